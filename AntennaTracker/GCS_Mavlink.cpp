@@ -292,6 +292,10 @@ bool GCS_MAVLINK::try_send_message(enum ap_message id)
     case MSG_VIBRATION:
     case MSG_RPM:
     case MSG_MISSION_ITEM_REACHED:
+    case MSG_SCHEDULER_STATS:
+    case MSG_STREAM_STATS:
+    case MSG_ROUTE_STATS:
+    case MSG_PERF_STATS:
         break; // just here to prevent a warning
     }
     return true;
@@ -398,22 +402,7 @@ bool GCS_MAVLINK::stream_trigger(enum streams stream_num)
         rate *= 0.25f;
     }
 
-    if (rate <= 0) {
-        return false;
-    }
-
-    if (stream_ticks[stream_num] == 0) {
-        // we're triggering now, setup the next trigger point
-        if (rate > 50) {
-            rate = 50;
-        }
-        stream_ticks[stream_num] = (50 / rate) -1 + stream_slowdown;
-        return true;
-    }
-
-    // count down at 50Hz
-    stream_ticks[stream_num]--;
-    return false;
+    return stream_due(stream_num, rate);
 }
 
 void
@@ -423,7 +412,7 @@ GCS_MAVLINK::data_stream_send(void)
         if (streamRates[STREAM_PARAMS].get() <= 0) {
             streamRates[STREAM_PARAMS].set(10);
         }
-        if (stream_trigger(STREAM_PARAMS)) {
+        if (param_streaming() || stream_trigger(STREAM_PARAMS)) {
             send_message(MSG_NEXT_PARAM);
         }
     }
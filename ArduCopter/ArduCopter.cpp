@@ -75,18 +75,35 @@
 
 #include "Copter.h"
 
-#define SCHED_TASK(func, _interval_ticks, _max_time_micros) {\
+#define SCHED_TASK(func, _interval_ticks, _max_time_micros, _priority) {\
     .function = FUNCTOR_BIND(&copter, &Copter::func, void),\
     AP_SCHEDULER_NAME_INITIALIZER(func)\
     .interval_ticks = _interval_ticks,\
     .max_time_micros = _max_time_micros,\
+    .priority = _priority,\
+}
+
+/*
+  a task that only touches its own state and may be run on a worker
+  thread, concurrently with the main loop, on boards that have one
+ */
+#define SCHED_TASK_THREAD_SAFE(func, _interval_ticks, _max_time_micros, _priority) {\
+    .function = FUNCTOR_BIND(&copter, &Copter::func, void),\
+    AP_SCHEDULER_NAME_INITIALIZER(func)\
+    .interval_ticks = _interval_ticks,\
+    .max_time_micros = _max_time_micros,\
+    .priority = _priority,\
+    .thread_safe = true,\
 }
 
 /*
   scheduler table for fast CPUs - all regular tasks apart from the fast_loop()
   should be listed here, along with how often they should be called
-  (in 2.5ms units) and the maximum time they are expected to take (in
-  microseconds)
+  (in 2.5ms units), the maximum time they are expected to take (in
+  microseconds) and their priority in deadline scheduling mode
+  (SCHED_MODE=1). A priority of 16 is worth one interval of slip. RC
+  input and throttle come first, then GCS and logging, which suffer
+  most from being starved behind tasks that overrun
   1    = 400hz
   2    = 200hz
   4    = 100hz
@@ -99,70 +116,70 @@
   
  */
 const AP_Scheduler::Task Copter::scheduler_tasks[] = {
-    SCHED_TASK(rc_loop,                4,    130),
-    SCHED_TASK(throttle_loop,          8,     75),
-    SCHED_TASK(update_GPS,             8,    200),
+    SCHED_TASK(rc_loop,                4,    130,  16),
+    SCHED_TASK(throttle_loop,          8,     75,  16),
+    SCHED_TASK(update_GPS,             8,    200,   0),
 #if OPTFLOW == ENABLED
-    SCHED_TASK(update_optical_flow,    2,    160),
+    SCHED_TASK(update_optical_flow,    2,    160,   0),
 #endif
-    SCHED_TASK(update_batt_compass,   40,    120),
-    SCHED_TASK(read_aux_switches,     40,     50),
-    SCHED_TASK(arm_motors_check,      40,     50),
-    SCHED_TASK(auto_disarm_check,     40,     50),
-    SCHED_TASK(auto_trim,             40,     75),
-    SCHED_TASK(update_altitude,       40,    140),
-    SCHED_TASK(run_nav_updates,        8,    100),
-    SCHED_TASK(update_thr_average,     4,     90),
-    SCHED_TASK(three_hz_loop,        133,     75),
-    SCHED_TASK(compass_accumulate,     4,    100),
-    SCHED_TASK(barometer_accumulate,   8,     90),
+    SCHED_TASK(update_batt_compass,   40,    120,   0),
+    SCHED_TASK(read_aux_switches,     40,     50,   0),
+    SCHED_TASK(arm_motors_check,      40,     50,   0),
+    SCHED_TASK(auto_disarm_check,     40,     50,   0),
+    SCHED_TASK(auto_trim,             40,     75,   0),
+    SCHED_TASK(update_altitude,       40,    140,   0),
+    SCHED_TASK(run_nav_updates,        8,    100,   0),
+    SCHED_TASK(update_thr_average,     4,     90,   0),
+    SCHED_TASK(three_hz_loop,        133,     75,   0),
+    SCHED_TASK(compass_accumulate,     4,    100,   0),
+    SCHED_TASK(barometer_accumulate,   8,     90,   0),
 #if PRECISION_LANDING == ENABLED
-    SCHED_TASK(update_precland,        8,     50),
+    SCHED_TASK(update_precland,        8,     50,   0),
 #endif
 #if FRAME_CONFIG == HELI_FRAME
-    SCHED_TASK(check_dynamic_flight,   8,     75),
+    SCHED_TASK(check_dynamic_flight,   8,     75,   0),
 #endif
-    SCHED_TASK(update_notify,          8,     90),
-    SCHED_TASK(one_hz_loop,          400,    100),
-    SCHED_TASK(ekf_check,             40,     75),
-    SCHED_TASK(landinggear_update,    40,     75),
-    SCHED_TASK(lost_vehicle_check,    40,     50),
-    SCHED_TASK(gcs_check_input,        1,    180),
-    SCHED_TASK(gcs_send_heartbeat,   400,    110),
-    SCHED_TASK(gcs_send_deferred,      8,    550),
-    SCHED_TASK(gcs_data_stream_send,   8,    550),
-    SCHED_TASK(update_mount,           8,     75),
-    SCHED_TASK(ten_hz_logging_loop,   40,    350),
-    SCHED_TASK(fifty_hz_logging_loop,  8,    110),
-    SCHED_TASK(full_rate_logging_loop, 1,    100),
-    SCHED_TASK(dataflash_periodic,     1,    300),
-    SCHED_TASK(perf_update,         4000,     75),
-    SCHED_TASK(read_receiver_rssi,    40,     75),
-    SCHED_TASK(rpm_update,            40,    200),
-    SCHED_TASK(compass_cal_update,    4,    100),
+    SCHED_TASK(update_notify,          8,     90,   0),
+    SCHED_TASK(one_hz_loop,          400,    100,   0),
+    SCHED_TASK(ekf_check,             40,     75,   0),
+    SCHED_TASK(landinggear_update,    40,     75,   0),
+    SCHED_TASK(lost_vehicle_check,    40,     50,   0),
+    SCHED_TASK(gcs_check_input,        1,    180,   8),
+    SCHED_TASK(gcs_send_heartbeat,   400,    110,   8),
+    SCHED_TASK(gcs_send_deferred,      8,    550,   8),
+    SCHED_TASK(gcs_data_stream_send,   8,    550,   8),
+    SCHED_TASK(update_mount,           8,     75,   0),
+    SCHED_TASK(ten_hz_logging_loop,   40,    350,   8),
+    SCHED_TASK(fifty_hz_logging_loop,  8,    110,   8),
+    SCHED_TASK(full_rate_logging_loop, 1,    100,   8),
+    SCHED_TASK(dataflash_periodic,     1,    300,   8),
+    SCHED_TASK(perf_update,         4000,     75,   0),
+    SCHED_TASK_THREAD_SAFE(read_receiver_rssi, 40, 75, 0),
+    SCHED_TASK(rpm_update,            40,    200,   0),
+    SCHED_TASK(compass_cal_update,    4,    100,   0),
 #if ADSB_ENABLED == ENABLED
-    SCHED_TASK(adsb_update,          400,    100),
+    SCHED_TASK(adsb_update,          400,    100,   0),
 #endif
 #if FRSKY_TELEM_ENABLED == ENABLED
-    SCHED_TASK(frsky_telemetry_send,  80,     75),
+    SCHED_TASK(frsky_telemetry_send,  80,     75,   0),
 #endif
 #if EPM_ENABLED == ENABLED
-    SCHED_TASK(epm_update,            40,     75),
+    SCHED_TASK(epm_update,            40,     75,   0),
 #endif
 #ifdef USERHOOK_FASTLOOP
-    SCHED_TASK(userhook_FastLoop,      4,     75),
+    SCHED_TASK(userhook_FastLoop,      4,     75,   0),
 #endif
 #ifdef USERHOOK_50HZLOOP
-    SCHED_TASK(userhook_50Hz,          8,     75),
+    SCHED_TASK(userhook_50Hz,          8,     75,   0),
 #endif
 #ifdef USERHOOK_MEDIUMLOOP
-    SCHED_TASK(userhook_MediumLoop,   40,     75),
+    SCHED_TASK(userhook_MediumLoop,   40,     75,   0),
 #endif
 #ifdef USERHOOK_SLOWLOOP
-    SCHED_TASK(userhook_SlowLoop,     120,    75),
+    SCHED_TASK(userhook_SlowLoop,     120,    75,   0),
 #endif
 #ifdef USERHOOK_SUPERSLOWLOOP
-    SCHED_TASK(userhook_SuperSlowLoop, 400,   75),
+    SCHED_TASK(userhook_SuperSlowLoop, 400,   75,   0),
 #endif
 };
 
@@ -207,8 +224,10 @@ void Copter::barometer_accumulate(void)
 
 void Copter::perf_update(void)
 {
-    if (should_log(MASK_LOG_PM))
+    if (should_log(MASK_LOG_PM)) {
         Log_Write_Performance();
+        DataFlash.Log_Write_Scheduler(scheduler);
+    }
     if (scheduler.debug()) {
         gcs_send_text_fmt(MAV_SEVERITY_WARNING, "PERF: %u/%u %lu %lu\n",
                           (unsigned)perf_info_get_num_long_running(),
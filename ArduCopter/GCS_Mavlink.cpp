@@ -737,7 +737,15 @@ bool GCS_MAVLINK::try_send_message(enum ap_message id)
         mavlink_msg_mission_item_reached_send(chan, mission_item_reached_index);
         break;
 
+    case MSG_SCHEDULER_STATS:
+        CHECK_PAYLOAD_SIZE(DEBUG_VECT);
+        send_scheduler_stats(copter.scheduler);
+        break;
+
     case MSG_RETRY_DEFERRED:
+    case MSG_STREAM_STATS:
+    case MSG_ROUTE_STATS:
+    case MSG_PERF_STATS:
         break; // just here to prevent a warning
 
     case MSG_MAG_CAL_PROGRESS:
@@ -853,22 +861,7 @@ bool GCS_MAVLINK::stream_trigger(enum streams stream_num)
         rate *= 0.25f;
     }
 
-    if (rate <= 0) {
-        return false;
-    }
-
-    if (stream_ticks[stream_num] == 0) {
-        // we're triggering now, setup the next trigger point
-        if (rate > 50) {
-            rate = 50;
-        }
-        stream_ticks[stream_num] = (50 / rate) - 1 + stream_slowdown;
-        return true;
-    }
-
-    // count down at 50Hz
-    stream_ticks[stream_num]--;
-    return false;
+    return stream_due(stream_num, rate);
 }
 
 void
@@ -889,7 +882,7 @@ GCS_MAVLINK::data_stream_send(void)
         if (streamRates[STREAM_PARAMS].get() <= 0) {
             streamRates[STREAM_PARAMS].set(10);
         }
-        if (stream_trigger(STREAM_PARAMS)) {
+        if (param_streaming() || stream_trigger(STREAM_PARAMS)) {
             send_message(MSG_NEXT_PARAM);
         }
         // don't send anything else at the same time as parameters
@@ -973,6 +966,12 @@ GCS_MAVLINK::data_stream_send(void)
         send_message(MSG_EKF_STATUS_REPORT);
         send_message(MSG_VIBRATION);
         send_message(MSG_RPM);
+        if (copter.scheduler.debug() != 0) {
+            send_message(MSG_SCHEDULER_STATS);
+            send_message(MSG_STREAM_STATS);
+            send_message(MSG_ROUTE_STATS);
+            send_message(MSG_PERF_STATS);
+        }
     }
 }
 
@@ -168,7 +168,9 @@ void Copter::read_battery(void)
 }
 
 // read the receiver RSSI as an 8 bit number for MAVLink
-// RC_CHANNELS_SCALED message
+// RC_CHANNELS_SCALED message. This runs as a thread-safe task: it
+// only reads parameters and RC input, and only writes the RSSI
+// library's own state and the single byte receiver_rssi
 void Copter::read_receiver_rssi(void)
 {
     receiver_rssi = rssi.read_receiver_rssi_uint8();
@@ -0,0 +1,114 @@
+#!/usr/bin/env python
+'''
+check that Replay --start-time seeks into a log correctly
+
+The log is replayed from the start and from the start time. The second
+run must see the same parameters and the same IMU data from the start
+time on, and nothing from before it
+'''
+
+import optparse, os, glob, struct, sys
+
+parser = optparse.OptionParser("CheckSeek [options] LOGFILE")
+parser.add_option("--start-time", type=int, default=None, help="start time in milliseconds (default: middle of the log)")
+parser.add_option("--replay", type='string', default='./Replay.elf', help="Replay binary to run")
+
+opts, args = parser.parse_args()
+
+if len(args) != 1:
+    parser.print_help()
+    sys.exit(1)
+
+HEAD = b'\xa3\x95'
+FMT_TYPE = 128
+
+def read_log(filename):
+    '''return a list of (name, time_us, body) for each message in a DataFlash log.
+    time_us is None for messages without a TimeUS or TimeMS first field'''
+    data = open(filename, 'rb').read()
+    formats = { FMT_TYPE : ('FMT', 89, '', '') }
+    ret = []
+    ofs = 0
+    while len(data) - ofs >= 3:
+        if data[ofs:ofs+2] != HEAD:
+            break
+        mtype = ord(data[ofs+2:ofs+3])
+        if mtype not in formats:
+            break
+        (name, length, fmt, labels) = formats[mtype]
+        if len(data) - ofs < length:
+            break
+        body = data[ofs+3:ofs+length]
+        if mtype == FMT_TYPE:
+            (ftype, flen, fname, ffmt, flabels) = struct.unpack('<BB4s16s64s', body)
+            formats[ftype] = (fname.rstrip(b'\0').decode(), flen,
+                              ffmt.rstrip(b'\0').decode(),
+                              flabels.rstrip(b'\0').decode())
+        time_us = None
+        if labels.startswith('TimeUS') and fmt.startswith('Q'):
+            time_us = struct.unpack('<Q', body[:8])[0]
+        elif labels.startswith('TimeMS') and fmt.startswith('I'):
+            time_us = struct.unpack('<I', body[:4])[0] * 1000
+        ret.append((name, time_us, body))
+        ofs += length
+    return ret
+
+def run_replay(extra_args):
+    '''run Replay and return the log it wrote'''
+    before = set(glob.glob("logs/*.BIN"))
+    cmd = "%s -- %s %s > /dev/null" % (opts.replay, extra_args, args[0])
+    print("Running: %s" % cmd)
+    if os.system(cmd) != 0:
+        print("FAIL: Replay failed")
+        sys.exit(1)
+    changed = set(glob.glob("logs/*.BIN")).difference(before)
+    if len(changed) != 1:
+        print("FAIL: no output log from Replay")
+        sys.exit(1)
+    return list(changed)[0]
+
+def messages(log, name):
+    return [ m for m in log if m[0] == name ]
+
+errors = 0
+
+def check(ok, text):
+    global errors
+    if ok:
+        print("OK: %s" % text)
+    else:
+        print("FAIL: %s" % text)
+        errors += 1
+
+start_time = opts.start_time
+if start_time is None:
+    times = [ m[1] for m in messages(read_log(args[0]), 'IMU') ]
+    if len(times) == 0:
+        print("No IMU messages in %s" % args[0])
+        sys.exit(1)
+    start_time = int((times[0] + times[-1]) / 2000)
+
+full = read_log(run_replay(""))
+seek = read_log(run_replay("--start-time %u" % start_time))
+start_us = start_time * 1000
+
+check(len(messages(seek, 'PARM')) > 0 and
+      messages(seek, 'PARM') == messages(full, 'PARM'),
+      "the same %u parameters are replayed" % len(messages(full, 'PARM')))
+
+full_imu = [ m for m in messages(full, 'IMU') if m[1] >= start_us ]
+seek_imu = messages(seek, 'IMU')
+check(len(seek_imu) > 0 and seek_imu == full_imu,
+      "the same %u IMU messages are replayed from %u ms" % (len(full_imu), start_time))
+
+early = [ m for m in seek if m[0] in ('IMU', 'GPS', 'BARO', 'MAG') and m[1] < start_us ]
+check(len(early) == 0, "no sensor data from before %u ms is replayed" % start_time)
+
+for ekf in ('NKF1', 'EKF1'):
+    if len(messages(full, ekf)) > 0:
+        check(len(messages(seek, ekf)) > 0, "the EKF produces %s messages" % ekf)
+
+if errors:
+    print("%u checks failed" % errors)
+    sys.exit(1)
+print("All checks passed")
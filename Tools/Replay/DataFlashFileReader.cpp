@@ -3,24 +3,70 @@
 #include <fcntl.h>
 #include <string.h>
 #include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 
+DataFlashFileReader::~DataFlashFileReader()
+{
+    close_log();
+}
+
+void DataFlashFileReader::close_log(void)
+{
+    free_index();
+    if (log_data != NULL) {
+        munmap(log_data, log_size);
+        log_data = NULL;
+    }
+    log_size = 0;
+    offset = 0;
+}
+
 bool DataFlashFileReader::open_log(const char *logfile)
 {
-    fd = ::open(logfile, O_RDONLY);
+    close_log();
+
+    int fd = ::open(logfile, O_RDONLY);
     if (fd == -1) {
         return false;
     }
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        ::close(fd);
+        return false;
+    }
+    if (st.st_size == 0) {
+        // nothing to map; update() will report the end of the log
+        ::close(fd);
+        return true;
+    }
+
+    /*
+      map the log privately and writeable so message handlers are
+      free to modify the messages they are given in place
+     */
+    void *p = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        return false;
+    }
+    madvise(p, st.st_size, MADV_SEQUENTIAL);
+
+    log_data = (uint8_t *)p;
+    log_size = st.st_size;
+    offset = 0;
     return true;
 }
 
 bool DataFlashFileReader::update(char type[5])
 {
-    uint8_t hdr[3];
-    if (::read(fd, hdr, 3) != 3) {
+    if (log_size - offset < 3) {
         return false;
     }
+    uint8_t *hdr = &log_data[offset];
     if (hdr[0] != HEAD_BYTE1 || hdr[1] != HEAD_BYTE2) {
         printf("bad log header\n");
         return false;
@@ -28,10 +74,11 @@ bool DataFlashFileReader::update(char type[5])
 
     if (hdr[2] == LOG_FORMAT_MSG) {
         struct log_Format f;
-        memcpy(&f, hdr, 3);
-        if (::read(fd, &f.type, sizeof(f)-3) != sizeof(f)-3) {
+        if (log_size - offset < sizeof(f)) {
             return false;
         }
+        memcpy(&f, hdr, sizeof(f));
+        offset += sizeof(f);
         memcpy(&formats[f.type], &f, sizeof(formats[f.type]));
         strncpy(type, "FMT", 3);
         type[3] = 0;
@@ -52,15 +99,235 @@ bool DataFlashFileReader::update(char type[5])
         exit(1);
     }
 
-    uint8_t msg[f.length];
-
-    memcpy(msg, hdr, 3);
-    if (::read(fd, &msg[3], f.length-3) != f.length-3) {
+    if (log_size - offset < f.length) {
         return false;
     }
+    offset += f.length;
 
     strncpy(type, f.name, 4);
     type[4] = 0;
 
-    return handle_msg(f,msg);
+    return handle_msg(f, hdr);
+}
+
+/*
+  get the timestamp of a message whose first field is TimeUS or TimeMS
+ */
+bool DataFlashFileReader::message_time(const struct log_Format &f, const uint8_t *msg, uint64_t &time_us)
+{
+    const char *labels = f.labels;
+    if (strncmp(labels, "TimeUS", 6) == 0 &&
+        (labels[6] == ',' || labels[6] == 0) &&
+        f.format[0] == 'Q' && f.length >= 3 + sizeof(uint64_t)) {
+        memcpy(&time_us, &msg[3], sizeof(uint64_t));
+        return true;
+    }
+    if (strncmp(labels, "TimeMS", 6) == 0 &&
+        (labels[6] == ',' || labels[6] == 0) &&
+        f.format[0] == 'I' && f.length >= 3 + sizeof(uint32_t)) {
+        uint32_t time_ms;
+        memcpy(&time_ms, &msg[3], sizeof(uint32_t));
+        time_us = time_ms * 1000ULL;
+        return true;
+    }
+    return false;
+}
+
+bool DataFlashFileReader::append_offset(OffsetList &list, size_t ofs)
+{
+    if (list.count == list.allocated) {
+        uint32_t new_allocated = list.allocated ? list.allocated * 2 : 64;
+        size_t *new_offsets = (size_t *)realloc(list.offsets, new_allocated * sizeof(size_t));
+        if (new_offsets == NULL) {
+            return false;
+        }
+        list.offsets = new_offsets;
+        list.allocated = new_allocated;
+    }
+    list.offsets[list.count++] = ofs;
+    return true;
+}
+
+bool DataFlashFileReader::append_time(uint64_t time_us, size_t ofs)
+{
+    if (time_index_count == time_index_allocated) {
+        uint32_t new_allocated = time_index_allocated ? time_index_allocated * 2 : 64;
+        TimeIndexEntry *new_index = (TimeIndexEntry *)realloc(time_index, new_allocated * sizeof(TimeIndexEntry));
+        if (new_index == NULL) {
+            return false;
+        }
+        time_index = new_index;
+        time_index_allocated = new_allocated;
+    }
+    time_index[time_index_count].time_us = time_us;
+    time_index[time_index_count].offset = ofs;
+    time_index_count++;
+    return true;
+}
+
+void DataFlashFileReader::free_index(void)
+{
+    for (uint16_t i=0; i<LOGREADER_MAX_FORMATS; i++) {
+        free(type_index[i].offsets);
+        type_index[i] = {};
+    }
+    free(time_index);
+    time_index = NULL;
+    time_index_count = 0;
+    time_index_allocated = 0;
+    memset(index_formats, 0, sizeof(index_formats));
+    indexed_size = 0;
+    indexed = false;
+}
+
+/*
+  scan the log once, recording the offset of every message by type
+  and the offset of the first message in each
+  DATAFLASHREADER_TIME_INDEX_US of log time. Scanning stops at the
+  first damaged or truncated message, as update() does
+ */
+bool DataFlashFileReader::index_log(void)
+{
+    free_index();
+
+    size_t ofs = 0;
+    while (log_size - ofs >= 3) {
+        const uint8_t *msg = &log_data[ofs];
+        if (msg[0] != HEAD_BYTE1 || msg[1] != HEAD_BYTE2) {
+            break;
+        }
+        const uint8_t type = msg[2];
+        if (type >= LOGREADER_MAX_FORMATS) {
+            break;
+        }
+        size_t length;
+        if (type == LOG_FORMAT_MSG) {
+            length = sizeof(struct log_Format);
+            if (log_size - ofs < length) {
+                break;
+            }
+            const struct log_Format *f = (const struct log_Format *)msg;
+            if (f->type >= LOGREADER_MAX_FORMATS) {
+                break;
+            }
+            index_formats[f->type] = f;
+        } else {
+            const struct log_Format *f = index_formats[type];
+            if (f == NULL || f->length < 3 || log_size - ofs < f->length) {
+                break;
+            }
+            length = f->length;
+            uint64_t time_us;
+            if (message_time(*f, msg, time_us) &&
+                (time_index_count == 0 ||
+                 time_us >= time_index[time_index_count-1].time_us + DATAFLASHREADER_TIME_INDEX_US)) {
+                if (!append_time(time_us, ofs)) {
+                    return false;
+                }
+            }
+        }
+        if (!append_offset(type_index[type], ofs)) {
+            return false;
+        }
+        ofs += length;
+    }
+
+    indexed_size = ofs;
+    indexed = true;
+    return true;
+}
+
+/*
+  handle the messages of a type between the current position and target
+ */
+void DataFlashFileReader::handle_skipped(uint8_t type, size_t target)
+{
+    const OffsetList &list = type_index[type];
+    for (uint32_t i=0; i<list.count; i++) {
+        if (list.offsets[i] < offset) {
+            continue;
+        }
+        if (list.offsets[i] >= target) {
+            break;
+        }
+        if (type == LOG_FORMAT_MSG) {
+            struct log_Format f;
+            memcpy(&f, &log_data[list.offsets[i]], sizeof(f));
+            memcpy(&formats[f.type], &f, sizeof(formats[f.type]));
+            handle_log_format_msg(f);
+        } else {
+            handle_msg(formats[type], &log_data[list.offsets[i]]);
+        }
+    }
+}
+
+bool DataFlashFileReader::seek_time(uint64_t time_us, const char *keep_types[])
+{
+    if (!indexed) {
+        return false;
+    }
+
+    // find the last time index entry at or before time_us
+    size_t ofs = 0;
+    uint32_t lo = 0, hi = time_index_count;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if (time_index[mid].time_us <= time_us) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo > 0) {
+        ofs = time_index[lo-1].offset;
+    }
+
+    // then walk forward to the first message at or after time_us
+    size_t target = indexed_size;
+    while (ofs < indexed_size) {
+        const uint8_t *msg = &log_data[ofs];
+        const uint8_t type = msg[2];
+        if (type == LOG_FORMAT_MSG) {
+            ofs += sizeof(struct log_Format);
+            continue;
+        }
+        const struct log_Format *f = index_formats[type];
+        uint64_t msg_time_us;
+        if (message_time(*f, msg, msg_time_us) && msg_time_us >= time_us) {
+            target = ofs;
+            break;
+        }
+        ofs += f->length;
+    }
+
+    /*
+      formats defined between the current position and the target must
+      still be handled, or the messages which use them can't be parsed
+     */
+    handle_skipped(LOG_FORMAT_MSG, target);
+
+    /*
+      then the kept types, such as parameters, which are only logged
+      once. Each type is handled in log order
+     */
+    if (keep_types != NULL) {
+        if (!done_format_msgs) {
+            done_format_msgs = true;
+            end_format_msgs();
+        }
+        for (uint16_t type=0; type<LOGREADER_MAX_FORMATS; type++) {
+            if (type == LOG_FORMAT_MSG || formats[type].length == 0) {
+                continue;
+            }
+            for (uint8_t i=0; keep_types[i] != NULL; i++) {
+                if (strncmp(formats[type].name, keep_types[i], sizeof(formats[type].name)) == 0) {
+                    handle_skipped(type, target);
+                    break;
+                }
+            }
+        }
+    }
+
+    offset = target;
+    return target != indexed_size;
 }
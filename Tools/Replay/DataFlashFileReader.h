@@ -3,22 +3,79 @@
 
 #include <DataFlash/DataFlash.h>
 
+/*
+  reader for DataFlash .bin logs. The log is memory mapped and
+  messages are handed to handle_msg() in place, without copying.
+
+  index_log() optionally scans the whole log once to build an index of
+  the offsets of each message type and a sparse timestamp index, which
+  allow seeking by time
+ */
 class DataFlashFileReader
 {
 public:
+    virtual ~DataFlashFileReader();
+
     bool open_log(const char *logfile);
     bool update(char type[5]);
 
+    // build the message type and timestamp indexes
+    bool index_log(void);
+
+    // move to the first message with a timestamp at or after
+    // time_us. FMT messages which are skipped over are still handled,
+    // as are messages of the types named in the NULL terminated
+    // keep_types list. Needs index_log()
+    bool seek_time(uint64_t time_us, const char *keep_types[] = NULL);
+
     virtual bool handle_log_format_msg(const struct log_Format &f) = 0;
     virtual bool handle_msg(const struct log_Format &f, uint8_t *msg) = 0;
 
 protected:
-    int fd = -1;
     bool done_format_msgs = false;
     virtual void end_format_msgs(void) {}
 
 #define LOGREADER_MAX_FORMATS 255 // must be >= highest MESSAGE
     struct log_Format formats[LOGREADER_MAX_FORMATS] {};
+
+private:
+    // the mapped log, and the offset of the next message
+    uint8_t *log_data = NULL;
+    size_t log_size = 0;
+    size_t offset = 0;
+
+    // growable array of log offsets
+    struct OffsetList {
+        size_t *offsets;
+        uint32_t count;
+        uint32_t allocated;
+    };
+    OffsetList type_index[LOGREADER_MAX_FORMATS] {};
+
+    // one entry per DATAFLASHREADER_TIME_INDEX_US of log time
+#define DATAFLASHREADER_TIME_INDEX_US 100000
+    struct TimeIndexEntry {
+        uint64_t time_us;
+        size_t offset;
+    };
+    TimeIndexEntry *time_index = NULL;
+    uint32_t time_index_count = 0;
+    uint32_t time_index_allocated = 0;
+
+    // formats seen while indexing, pointing into the mapped log
+    const struct log_Format *index_formats[LOGREADER_MAX_FORMATS] {};
+
+    // offset at which indexing stopped, either the end of the log or
+    // the first damaged message
+    size_t indexed_size = 0;
+    bool indexed = false;
+
+    void close_log(void);
+    void free_index(void);
+    bool append_offset(OffsetList &list, size_t ofs);
+    bool append_time(uint64_t time_us, size_t ofs);
+    void handle_skipped(uint8_t type, size_t target);
+    static bool message_time(const struct log_Format &f, const uint8_t *msg, uint64_t &time_us);
 };
 
 #endif
@@ -7,6 +7,8 @@ LR_MsgHandler::LR_MsgHandler(struct log_Format &_f,
                              uint64_t &_last_timestamp_usec) :
     dataflash(_dataflash), last_timestamp_usec(_last_timestamp_usec),
     MsgHandler(_f) {
+    resolve_field("TimeUS", field_time_us);
+    resolve_field("TimeMS", field_time_ms);
 }
 
 void LR_MsgHandler::wait_timestamp_usec(uint64_t timestamp)
@@ -23,16 +25,13 @@ void LR_MsgHandler::wait_timestamp(uint32_t timestamp)
 
 void LR_MsgHandler::wait_timestamp_from_msg(uint8_t *msg)
 {
-    uint64_t time_us;
-    uint32_t time_ms;
-
-    if (field_value(msg, "TimeUS", time_us)) {
+    if (field_time_us.found()) {
         // 64-bit timestamp present - great!
-        wait_timestamp_usec(time_us);
-    } else if (field_value(msg, "TimeMS", time_ms)) {
+        wait_timestamp_usec(field_time_us.get(msg));
+    } else if (field_time_ms.found()) {
         // there is special rounding code that needs to be crossed in
         // wait_timestamp:
-        wait_timestamp(time_ms);
+        wait_timestamp(field_time_ms.get(msg));
     } else {
         ::printf("No timestamp on message");
     }
@@ -47,7 +46,7 @@ void LR_MsgHandler::wait_timestamp_from_msg(uint8_t *msg)
 void LR_MsgHandler_AHR2::process_message(uint8_t *msg)
 {
     wait_timestamp_from_msg(msg);
-    attitude_from_msg(msg, ahr2_attitude, "Roll", "Pitch", "Yaw");
+    attitude_from_msg(msg, ahr2_attitude, attitude_fields);
 }
 
 
@@ -66,9 +65,9 @@ void LR_MsgHandler_ARSP::process_message(uint8_t *msg)
 {
     wait_timestamp_from_msg(msg);
 
-    airspeed.setHIL(require_field_float(msg, "Airspeed"),
-		    require_field_float(msg, "DiffPress"),
-		    require_field_float(msg, "Temp"));
+    airspeed.setHIL(require_field(msg, field_airspeed),
+		    require_field(msg, field_diffpress),
+		    require_field(msg, field_temp));
 }
 
 void LR_MsgHandler_FRAM::process_message(uint8_t *msg)
@@ -80,19 +79,19 @@ void LR_MsgHandler_FRAM::process_message(uint8_t *msg)
 void LR_MsgHandler_ATT::process_message(uint8_t *msg)
 {
     wait_timestamp_from_msg(msg);
-    attitude_from_msg(msg, attitude, "Roll", "Pitch", "Yaw");
+    attitude_from_msg(msg, attitude, attitude_fields);
 }
 
 void LR_MsgHandler_CHEK::process_message(uint8_t *msg)
 {
     wait_timestamp_from_msg(msg);
     check_state.time_us = AP_HAL::micros64();
-    attitude_from_msg(msg, check_state.euler, "Roll", "Pitch", "Yaw");
+    attitude_from_msg(msg, check_state.euler, attitude_fields);
     check_state.euler *= radians(1);
-    location_from_msg(msg, check_state.pos, "Lat", "Lng", "Alt");
-    require_field(msg, "VN", check_state.velocity.x);
-    require_field(msg, "VE", check_state.velocity.y);
-    require_field(msg, "VD", check_state.velocity.z);
+    location_from_msg(msg, check_state.pos, location_fields);
+    check_state.velocity.x = require_field(msg, field_vn);
+    check_state.velocity.y = require_field(msg, field_ve);
+    check_state.velocity.z = require_field(msg, field_vd);
 }
 
 
@@ -100,8 +99,8 @@ void LR_MsgHandler_BARO::process_message(uint8_t *msg)
 {
     wait_timestamp_from_msg(msg);
     baro.setHIL(0,
-		require_field_float(msg, "Press"),
-		require_field_int16_t(msg, "Temp") * 0.01f);
+		require_field(msg, field_press),
+		require_field(msg, field_temp) * 0.01f);
 }
 
 
@@ -133,32 +132,51 @@ void LR_MsgHandler_GPS2::process_message(uint8_t *msg)
 }
 
 
+/*
+  GPS message labels have changed over time, so where a field has had
+  more than one label resolve whichever this format uses
+ */
+void LR_MsgHandler_GPS_Base::resolve_gps_fields(void)
+{
+    resolve_field("T", field_time_t);
+    resolve_location_fields(location_fields, "Lat", "Lng", "Alt");
+    resolve_ground_vel_fields(ground_vel_fields, "Spd", "GCrs", "VZ");
+    resolve_field("Status", field_status);
+    if (!resolve_field("HDop", field_hdop)) {
+        resolve_field("HDp", field_hdop);
+    }
+    if (!resolve_field("NSats", field_nsats) &&
+        !resolve_field("numSV", field_nsats)) {
+        // report the current label if it is missing
+        resolve_field("NSats", field_nsats);
+    }
+    if (!resolve_field("RAlt", field_relalt)) {
+        resolve_field("RelAlt", field_relalt);
+    }
+}
+
 void LR_MsgHandler_GPS_Base::update_from_msg_gps(uint8_t gps_offset, uint8_t *msg, bool responsible_for_relalt)
 {
     uint64_t time_us;
-    if (! field_value(msg, "TimeUS", time_us)) {
-        uint32_t timestamp;
-        require_field(msg, "T", timestamp);
+    if (field_time_us.found()) {
+        time_us = field_time_us.get(msg);
+    } else {
+        uint32_t timestamp = require_field(msg, field_time_t);
         time_us = timestamp * 1000;
     }
     wait_timestamp_usec(time_us);
 
     Location loc;
-    location_from_msg(msg, loc, "Lat", "Lng", "Alt");
+    location_from_msg(msg, loc, location_fields);
     Vector3f vel;
-    ground_vel_from_msg(msg, vel, "Spd", "GCrs", "VZ");
+    ground_vel_from_msg(msg, vel, ground_vel_fields);
 
-    uint8_t status = require_field_uint8_t(msg, "Status");
-    uint8_t hdop = 0;
-    if (! field_value(msg, "HDop", hdop) &&
-        ! field_value(msg, "HDp", hdop)) {
-        hdop = 20;
-    }
-    uint8_t nsats = 0;
-    if (! field_value(msg, "NSats", nsats) &&
-        ! field_value(msg, "numSV", nsats)) {
-        field_not_found(msg, "NSats");
+    uint8_t status = require_field(msg, field_status);
+    uint8_t hdop = 20;
+    if (field_hdop.found()) {
+        hdop = field_hdop.get(msg);
     }
+    uint8_t nsats = require_field(msg, field_nsats);
     gps.setHIL(gps_offset,
                (AP_GPS::GPS_Status)status,
                uint32_t(time_us/1000),
@@ -166,18 +184,13 @@ void LR_MsgHandler_GPS_Base::update_from_msg_gps(uint8_t gps_offset, uint8_t *ms
                vel,
                nsats,
                hdop,
-               require_field_float(msg, "VZ") != 0);
+               require_field(msg, ground_vel_fields.vz) != 0);
     if (status == AP_GPS::GPS_OK_FIX_3D && ground_alt_cm == 0) {
-        ground_alt_cm = require_field_int32_t(msg, "Alt");
+        ground_alt_cm = require_field(msg, location_fields.alt);
     }
 
     if (responsible_for_relalt) {
-        // this could possibly check for the presence of "RelAlt" label?
-        int32_t tmp;
-        if (! field_value(msg, "RAlt", tmp)) {
-            tmp = require_field_int32_t(msg, "RelAlt");
-        }
-        rel_altitude = 0.01f * tmp;
+        rel_altitude = 0.01f * require_field(msg, field_relalt);
     }
 }
 
@@ -208,14 +221,10 @@ void LR_MsgHandler_IMU_Base::update_from_msg_imu(uint8_t imu_offset, uint8_t *ms
     uint8_t this_imu_mask = 1 << imu_offset;
 
     if (gyro_mask & this_imu_mask) {
-        Vector3f gyro;
-        require_field(msg, "Gyr", gyro);
-        ins.set_gyro(imu_offset, gyro);
+        ins.set_gyro(imu_offset, require_field(msg, field_gyro));
     }
     if (accel_mask & this_imu_mask) {
-        Vector3f accel2;
-        require_field(msg, "Acc", accel2);
-        ins.set_accel(imu_offset, accel2);
+        ins.set_accel(imu_offset, require_field(msg, field_accel));
     }
 }
 
@@ -235,20 +244,14 @@ void LR_MsgHandler_IMT_Base::update_from_msg_imt(uint8_t imu_offset, uint8_t *ms
 
     uint8_t this_imu_mask = 1 << imu_offset;
 
-    float delta_time = 0;
-    require_field(msg, "DelT", delta_time);
-    ins.set_delta_time(delta_time);
+    ins.set_delta_time(require_field(msg, field_delta_time));
 
     if (gyro_mask & this_imu_mask) {
-        Vector3f d_angle;
-        require_field(msg, "DelA", d_angle);
-        ins.set_delta_angle(imu_offset, d_angle);
+        ins.set_delta_angle(imu_offset, require_field(msg, field_delta_angle));
     }
     if (accel_mask & this_imu_mask) {
-        float dvt = 0;
-        require_field(msg, "DelvT", dvt);
-        Vector3f d_velocity;
-        require_field(msg, "DelV", d_velocity);
+        float dvt = require_field(msg, field_delta_velocity_dt);
+        Vector3f d_velocity = require_field(msg, field_delta_velocity);
         ins.set_delta_velocity(imu_offset, dvt, d_velocity);
     }
 }
@@ -278,10 +281,8 @@ void LR_MsgHandler_MAG_Base::update_from_msg_compass(uint8_t compass_offset, uin
 {
     wait_timestamp_from_msg(msg);
 
-    Vector3f mag;
-    require_field(msg, "Mag", mag);
-    Vector3f mag_offset;
-    require_field(msg, "Ofs", mag_offset);
+    Vector3f mag = require_field(msg, field_mag);
+    Vector3f mag_offset = require_field(msg, field_offset);
 
     compass.setHIL(compass_offset, mag - mag_offset);
     // compass_offset is which compass we are setting info for;
@@ -327,8 +328,8 @@ void LR_MsgHandler_MSG::process_message(uint8_t *msg)
 
 void LR_MsgHandler_NTUN_Copter::process_message(uint8_t *msg)
 {
-    inavpos = Vector3f(require_field_float(msg, "PosX") * 0.01f,
-		       require_field_float(msg, "PosY") * 0.01f,
+    inavpos = Vector3f(require_field(msg, field_posx) * 0.01f,
+		       require_field(msg, field_posy) * 0.01f,
 		       0);
 }
 
@@ -376,10 +377,8 @@ void LR_MsgHandler_PARM::process_message(uint8_t *msg)
 {
     const uint8_t parameter_name_len = AP_MAX_NAME_SIZE + 1; // null-term
     char parameter_name[parameter_name_len];
-    uint64_t time_us;
-
-    if (field_value(msg, "TimeUS", time_us)) {
-        wait_timestamp_usec(time_us);
+    if (field_time_us.found()) {
+        wait_timestamp_usec(field_time_us.get(msg));
     } else {
         // older logs can have a lot of FMT and PARM messages up the
         // front which don't have timestamps.  Since in Replay we run
@@ -398,5 +397,5 @@ void LR_MsgHandler_PARM::process_message(uint8_t *msg)
 void LR_MsgHandler_SIM::process_message(uint8_t *msg)
 {
     wait_timestamp_from_msg(msg);
-    attitude_from_msg(msg, sim_attitude, "Roll", "Pitch", "Yaw");
+    attitude_from_msg(msg, sim_attitude, attitude_fields);
 }
@@ -27,6 +27,9 @@ protected:
 
     uint64_t &last_timestamp_usec;
 
+    MsgField<uint64_t> field_time_us;
+    MsgField<uint32_t> field_time_ms;
+
 };
 
 /* subclasses below this point */
@@ -37,12 +40,15 @@ public:
     LR_MsgHandler_AHR2(log_Format &_f, DataFlash_Class &_dataflash,
                     uint64_t &_last_timestamp_usec, Vector3f &_ahr2_attitude)
         : LR_MsgHandler(_f, _dataflash,_last_timestamp_usec),
-          ahr2_attitude(_ahr2_attitude) { };
+          ahr2_attitude(_ahr2_attitude) {
+        resolve_attitude_fields(attitude_fields, "Roll", "Pitch", "Yaw");
+    };
 
     virtual void process_message(uint8_t *msg);
 
 private:
     Vector3f &ahr2_attitude;
+    AttitudeFields attitude_fields;
 };
 
 
@@ -62,12 +68,19 @@ class LR_MsgHandler_ARSP : public LR_MsgHandler
 public:
     LR_MsgHandler_ARSP(log_Format &_f, DataFlash_Class &_dataflash,
 		    uint64_t &_last_timestamp_usec, AP_Airspeed &_airspeed) :
-	LR_MsgHandler(_f, _dataflash, _last_timestamp_usec), airspeed(_airspeed) { };
+	LR_MsgHandler(_f, _dataflash, _last_timestamp_usec), airspeed(_airspeed) {
+        resolve_field("Airspeed", field_airspeed);
+        resolve_field("DiffPress", field_diffpress);
+        resolve_field("Temp", field_temp);
+    };
 
     virtual void process_message(uint8_t *msg);
 
 private:
     AP_Airspeed &airspeed;
+    MsgField<float> field_airspeed;
+    MsgField<float> field_diffpress;
+    MsgField<float> field_temp;
 };
 
 class LR_MsgHandler_FRAM : public LR_MsgHandler
@@ -87,11 +100,14 @@ public:
     LR_MsgHandler_ATT(log_Format &_f, DataFlash_Class &_dataflash,
                    uint64_t &_last_timestamp_usec, Vector3f &_attitude)
         : LR_MsgHandler(_f, _dataflash, _last_timestamp_usec), attitude(_attitude)
-        { };
+        {
+            resolve_attitude_fields(attitude_fields, "Roll", "Pitch", "Yaw");
+        };
     virtual void process_message(uint8_t *msg);
 
 private:
     Vector3f &attitude;
+    AttitudeFields attitude_fields;
 };
 
 
@@ -102,11 +118,22 @@ public:
                        uint64_t &_last_timestamp_usec, CheckState &_check_state)
         : LR_MsgHandler(_f, _dataflash, _last_timestamp_usec), 
           check_state(_check_state)
-        { };
+        {
+            resolve_attitude_fields(attitude_fields, "Roll", "Pitch", "Yaw");
+            resolve_location_fields(location_fields, "Lat", "Lng", "Alt");
+            resolve_field("VN", field_vn);
+            resolve_field("VE", field_ve);
+            resolve_field("VD", field_vd);
+        };
     virtual void process_message(uint8_t *msg);
 
 private:
     CheckState &check_state;
+    AttitudeFields attitude_fields;
+    LocationFields location_fields;
+    MsgField<float> field_vn;
+    MsgField<float> field_ve;
+    MsgField<float> field_vd;
 };
 
 class LR_MsgHandler_BARO : public LR_MsgHandler
@@ -114,12 +141,17 @@ class LR_MsgHandler_BARO : public LR_MsgHandler
 public:
     LR_MsgHandler_BARO(log_Format &_f, DataFlash_Class &_dataflash,
                     uint64_t &_last_timestamp_usec, AP_Baro &_baro)
-        : LR_MsgHandler(_f, _dataflash, _last_timestamp_usec), baro(_baro) { };
+        : LR_MsgHandler(_f, _dataflash, _last_timestamp_usec), baro(_baro) {
+        resolve_field("Press", field_press);
+        resolve_field("Temp", field_temp);
+    };
 
     virtual void process_message(uint8_t *msg);
 
 private:
     AP_Baro &baro;
+    MsgField<float> field_press;
+    MsgField<int16_t> field_temp;
 };
 
 
@@ -145,7 +177,9 @@ public:
                            uint32_t &_ground_alt_cm, float &_rel_altitude)
         : LR_MsgHandler(_f, _dataflash, _last_timestamp_usec),
           gps(_gps), ground_alt_cm(_ground_alt_cm),
-          rel_altitude(_rel_altitude) { };
+          rel_altitude(_rel_altitude) {
+        resolve_gps_fields();
+    };
 
 protected:
     void update_from_msg_gps(uint8_t imu_offset, uint8_t *data, bool responsible_for_relalt);
@@ -154,6 +188,15 @@ private:
     AP_GPS &gps;
     uint32_t &ground_alt_cm;
     float &rel_altitude;
+
+    void resolve_gps_fields(void);
+    MsgField<uint32_t> field_time_t;
+    LocationFields location_fields;
+    GroundVelFields ground_vel_fields;
+    MsgField<uint8_t> field_status;
+    MsgField<uint8_t> field_hdop;
+    MsgField<uint8_t> field_nsats;
+    MsgField<int32_t> field_relalt;
 };
 
 
@@ -208,13 +251,18 @@ public:
         LR_MsgHandler(_f, _dataflash, _last_timestamp_usec),
         accel_mask(_accel_mask),
         gyro_mask(_gyro_mask),
-        ins(_ins) { };
+        ins(_ins) {
+        resolve_field("Gyr", field_gyro);
+        resolve_field("Acc", field_accel);
+    };
     void update_from_msg_imu(uint8_t imu_offset, uint8_t *msg);
 
 private:
     uint8_t &accel_mask;
     uint8_t &gyro_mask;
     AP_InertialSensor &ins;
+    MsgVector3Field field_gyro;
+    MsgVector3Field field_accel;
 };
 
 class LR_MsgHandler_IMU : public LR_MsgHandler_IMU_Base
@@ -269,7 +317,12 @@ public:
         accel_mask(_accel_mask),
         gyro_mask(_gyro_mask),
         use_imt(_use_imt),
-        ins(_ins) { };
+        ins(_ins) {
+        resolve_field("DelT", field_delta_time);
+        resolve_field("DelA", field_delta_angle);
+        resolve_field("DelvT", field_delta_velocity_dt);
+        resolve_field("DelV", field_delta_velocity);
+    };
     void update_from_msg_imt(uint8_t imu_offset, uint8_t *msg);
 
 private:
@@ -277,6 +330,10 @@ private:
     uint8_t &gyro_mask;
     bool &use_imt;
     AP_InertialSensor &ins;
+    MsgField<float> field_delta_time;
+    MsgVector3Field field_delta_angle;
+    MsgField<float> field_delta_velocity_dt;
+    MsgVector3Field field_delta_velocity;
 };
 
 class LR_MsgHandler_IMT : public LR_MsgHandler_IMT_Base
@@ -327,13 +384,18 @@ class LR_MsgHandler_MAG_Base : public LR_MsgHandler
 public:
     LR_MsgHandler_MAG_Base(log_Format &_f, DataFlash_Class &_dataflash,
                         uint64_t &_last_timestamp_usec, Compass &_compass)
-	: LR_MsgHandler(_f, _dataflash, _last_timestamp_usec), compass(_compass) { };
+	: LR_MsgHandler(_f, _dataflash, _last_timestamp_usec), compass(_compass) {
+        resolve_field("Mag", field_mag);
+        resolve_field("Ofs", field_offset);
+    };
 
 protected:
     void update_from_msg_compass(uint8_t compass_offset, uint8_t *msg);
 
 private:
     Compass &compass;
+    MsgVector3Field field_mag;
+    MsgVector3Field field_offset;
 };
 
 class LR_MsgHandler_MAG : public LR_MsgHandler_MAG_Base
@@ -381,12 +443,17 @@ class LR_MsgHandler_NTUN_Copter : public LR_MsgHandler
 public:
     LR_MsgHandler_NTUN_Copter(log_Format &_f, DataFlash_Class &_dataflash,
 			   uint64_t &_last_timestamp_usec, Vector3f &_inavpos)
-	: LR_MsgHandler(_f, _dataflash, _last_timestamp_usec), inavpos(_inavpos) {};
+	: LR_MsgHandler(_f, _dataflash, _last_timestamp_usec), inavpos(_inavpos) {
+        resolve_field("PosX", field_posx);
+        resolve_field("PosY", field_posy);
+    };
 
     virtual void process_message(uint8_t *msg);
 
 private:
     Vector3f &inavpos;
+    MsgField<float> field_posx;
+    MsgField<float> field_posy;
 };
 
 
@@ -407,12 +474,15 @@ public:
                    Vector3f &_sim_attitude)
         : LR_MsgHandler(_f, _dataflash, _last_timestamp_usec),
           sim_attitude(_sim_attitude)
-        { };
+        {
+            resolve_attitude_fields(attitude_fields, "Roll", "Pitch", "Yaw");
+        };
 
     virtual void process_message(uint8_t *msg);
 
 private:
     Vector3f &sim_attitude;
+    AttitudeFields attitude_fields;
 };
 
 
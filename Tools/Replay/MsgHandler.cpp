@@ -152,6 +152,43 @@ bool MsgHandler::field_value(uint8_t *msg, const char *label, Vector3f &ret)
 }
 
 
+/*
+  resolve a vector from the three fields made of its label and an
+  X, Y or Z suffix
+ */
+bool MsgHandler::resolve_field(const char *label, MsgVector3Field &field)
+{
+    char axis_label[64];
+    const size_t len = strlen(label);
+    field.label = label;
+    if (len+2 > sizeof(axis_label)) {
+        return false;
+    }
+    memcpy(axis_label, label, len);
+    axis_label[len+1] = '\0';
+
+    axis_label[len] = 'X';
+    resolve_field(axis_label, field.x);
+    axis_label[len] = 'Y';
+    resolve_field(axis_label, field.y);
+    axis_label[len] = 'Z';
+    resolve_field(axis_label, field.z);
+
+    // don't leave the axis fields pointing at axis_label
+    field.x.label = field.y.label = field.z.label = label;
+
+    return field.found();
+}
+
+Vector3f MsgHandler::require_field(uint8_t *msg, const MsgVector3Field &field)
+{
+    if (!field.found()) {
+        field_not_found(msg, field.get_label());
+    }
+    return field.get(msg);
+}
+
+
 void MsgHandler::string_for_labels(char *buffer, uint bufferlen)
 {
     memset(buffer, '\0', bufferlen);
@@ -189,42 +226,64 @@ MsgHandler::~MsgHandler()
     }
 }
 
+void MsgHandler::resolve_location_fields(LocationFields &fields,
+                                         const char *label_lat,
+                                         const char *label_long,
+                                         const char *label_alt)
+{
+    resolve_field(label_lat, fields.lat);
+    resolve_field(label_long, fields.lng);
+    resolve_field(label_alt, fields.alt);
+}
+
 void MsgHandler::location_from_msg(uint8_t *msg,
                                   Location &loc,
-                                  const char *label_lat,
-                                  const char *label_long,
-                                  const char *label_alt)
+                                  const LocationFields &fields)
 {
-    loc.lat = require_field_int32_t(msg, label_lat);
-    loc.lng = require_field_int32_t(msg, label_long);
-    loc.alt = require_field_int32_t(msg, label_alt);
+    loc.lat = require_field(msg, fields.lat);
+    loc.lng = require_field(msg, fields.lng);
+    loc.alt = require_field(msg, fields.alt);
     loc.options = 0;
 }
 
+void MsgHandler::resolve_ground_vel_fields(GroundVelFields &fields,
+                                           const char *label_speed,
+                                           const char *label_course,
+                                           const char *label_vz)
+{
+    resolve_field(label_speed, fields.speed);
+    resolve_field(label_course, fields.course);
+    resolve_field(label_vz, fields.vz);
+}
+
 void MsgHandler::ground_vel_from_msg(uint8_t *msg,
                                     Vector3f &vel,
-                                    const char *label_speed,
-                                    const char *label_course,
-                                    const char *label_vz)
+                                    const GroundVelFields &fields)
 {
-    uint32_t ground_speed;
-    int32_t ground_course;
-    require_field(msg, label_speed, ground_speed);
-    require_field(msg, label_course, ground_course);
+    uint32_t ground_speed = require_field(msg, fields.speed);
+    int32_t ground_course = require_field(msg, fields.course);
     vel[0] = ground_speed*0.01f*cosf(radians(ground_course*0.01f));
     vel[1] = ground_speed*0.01f*sinf(radians(ground_course*0.01f));
-    vel[2] = require_field_float(msg, label_vz);
+    vel[2] = require_field(msg, fields.vz);
+}
+
+void MsgHandler::resolve_attitude_fields(AttitudeFields &fields,
+                                         const char *label_roll,
+                                         const char *label_pitch,
+                                         const char *label_yaw)
+{
+    resolve_field(label_roll, fields.roll);
+    resolve_field(label_pitch, fields.pitch);
+    resolve_field(label_yaw, fields.yaw);
 }
 
 void MsgHandler::attitude_from_msg(uint8_t *msg,
 				   Vector3f &att,
-				   const char *label_roll,
-				   const char *label_pitch,
-				   const char *label_yaw)
+				   const AttitudeFields &fields)
 {
-    att[0] = require_field_int16_t(msg, label_roll) * 0.01f;
-    att[1] = require_field_int16_t(msg, label_pitch) * 0.01f;
-    att[2] = require_field_uint16_t(msg, label_yaw) * 0.01f;
+    att[0] = require_field(msg, fields.roll) * 0.01f;
+    att[1] = require_field(msg, fields.pitch) * 0.01f;
+    att[2] = require_field(msg, fields.yaw) * 0.01f;
 }
 
 void MsgHandler::field_not_found(uint8_t *msg, const char *label)
@@ -10,6 +10,50 @@
 
 #define streq(x, y) (!strcmp(x, y))
 
+/*
+  a field of a message format, resolved once from its label by
+  MsgHandler::resolve_field(). Reading the field from a message is
+  then a load at a fixed offset, rather than a search of the format's
+  labels and a switch on the field type
+ */
+template <typename R>
+class MsgField {
+public:
+    bool found() const { return load != NULL; }
+    const char *get_label() const { return label; }
+    R get(const uint8_t *msg) const { return load(&msg[offset]); }
+
+private:
+    friend class MsgHandler;
+
+    template <typename T>
+    static R load_as(const uint8_t *p) {
+        T v;
+        memcpy(&v, p, sizeof(v));
+        return (R)v;
+    }
+
+    const char *label = NULL;
+    uint8_t offset = 0;
+    R (*load)(const uint8_t *p) = NULL;
+};
+
+// a Vector3f held in three fields, labelled e.g. GyrX, GyrY and GyrZ
+class MsgVector3Field {
+public:
+    bool found() const { return x.found() && y.found() && z.found(); }
+    const char *get_label() const { return label; }
+    Vector3f get(const uint8_t *msg) const {
+        return Vector3f(x.get(msg), y.get(msg), z.get(msg));
+    }
+
+private:
+    friend class MsgHandler;
+
+    const char *label = NULL;
+    MsgField<float> x, y, z;
+};
+
 class MsgHandler {
 public:
     // constructor - create a parser for a MavLink message format
@@ -41,6 +85,23 @@ public:
     uint16_t require_field_uint16_t(uint8_t *msg, const char *label);
     int16_t require_field_int16_t(uint8_t *msg, const char *label);
 
+    // resolve_field - look up a field once, for fast access to its
+    // value in each message. These return false if the field was not
+    // found
+    template<typename R>
+    bool resolve_field(const char *label, MsgField<R> &field);
+    bool resolve_field(const char *label, MsgVector3Field &field);
+
+    template <typename R>
+    R require_field(uint8_t *msg, const MsgField<R> &field)
+        {
+            if (!field.found()) {
+                field_not_found(msg, field.get_label());
+            }
+            return field.get(msg);
+        }
+    Vector3f require_field(uint8_t *msg, const MsgVector3Field &field);
+
 private:
 
     void add_field(const char *_label, uint8_t _type, uint8_t _offset,
@@ -72,20 +133,40 @@ protected:
     struct log_Format f; // the format we are a parser for
     ~MsgHandler();
 
-    void location_from_msg(uint8_t *msg, Location &loc, const char *label_lat,
-			   const char *label_long, const char *label_alt);
+    struct LocationFields {
+        MsgField<int32_t> lat;
+        MsgField<int32_t> lng;
+        MsgField<int32_t> alt;
+    };
+    void resolve_location_fields(LocationFields &fields, const char *label_lat,
+                                 const char *label_long, const char *label_alt);
+    void location_from_msg(uint8_t *msg, Location &loc, const LocationFields &fields);
 
+    struct GroundVelFields {
+        MsgField<uint32_t> speed;
+        MsgField<int32_t> course;
+        MsgField<float> vz;
+    };
+    void resolve_ground_vel_fields(GroundVelFields &fields,
+                                   const char *label_speed,
+                                   const char *label_course,
+                                   const char *label_vz);
     void ground_vel_from_msg(uint8_t *msg,
 			     Vector3f &vel,
-			     const char *label_speed,
-			     const char *label_course,
-			     const char *label_vz);
+			     const GroundVelFields &fields);
 
+    struct AttitudeFields {
+        MsgField<int16_t> roll;
+        MsgField<int16_t> pitch;
+        MsgField<uint16_t> yaw;
+    };
+    void resolve_attitude_fields(AttitudeFields &fields,
+                                 const char *label_roll,
+                                 const char *label_pitch,
+                                 const char *label_yaw);
     void attitude_from_msg(uint8_t *msg,
 			   Vector3f &att,
-			   const char *label_roll,
-			   const char *label_pitch,
-			   const char *label_yaw);
+			   const AttitudeFields &fields);
     void field_not_found(uint8_t *msg, const char *label);
 };
 
@@ -108,6 +189,56 @@ bool MsgHandler::field_value(uint8_t *msg, const char *label, R &ret)
 }
 
 
+template<typename R>
+bool MsgHandler::resolve_field(const char *label, MsgField<R> &field)
+{
+    field.label = label;
+    field.load = NULL;
+
+    struct format_field_info *info = find_field_info(label);
+    if (info == NULL || info->offset == 0) {
+        return false;
+    }
+
+    field.offset = info->offset;
+    switch (info->type) {
+    case 'B':
+        field.load = &MsgField<R>::template load_as<uint8_t>;
+        break;
+    case 'c':
+    case 'h':
+        field.load = &MsgField<R>::template load_as<int16_t>;
+        break;
+    case 'H':
+    case 'C':
+        field.load = &MsgField<R>::template load_as<uint16_t>;
+        break;
+    case 'f':
+        field.load = &MsgField<R>::template load_as<float>;
+        break;
+    case 'I':
+    case 'E':
+        field.load = &MsgField<R>::template load_as<uint32_t>;
+        break;
+    case 'L':
+    case 'e':
+        field.load = &MsgField<R>::template load_as<int32_t>;
+        break;
+    case 'q':
+        field.load = &MsgField<R>::template load_as<int64_t>;
+        break;
+    case 'Q':
+        field.load = &MsgField<R>::template load_as<uint64_t>;
+        break;
+    default:
+        ::printf("Unhandled format type (%c)\n", info->type);
+        exit(1);
+    }
+
+    return true;
+}
+
+
 template<typename R>
 inline void MsgHandler::field_value_for_type_at_offset(uint8_t *msg,
                                                       uint8_t type,
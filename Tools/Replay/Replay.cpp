@@ -48,12 +48,14 @@
 #include <stdio.h>
 #include <errno.h>
 #include <signal.h>
+#include <time.h>
 #include <unistd.h>
 #include <AP_HAL/utility/getopt_cpp.h>
 #include <AP_SerialManager/AP_SerialManager.h>
 #include "Parameters.h"
 #include "VehicleType.h"
 #include "MsgHandler.h"
+#include "ReplayBatch.h"
 
 #ifndef INT16_MIN
 #define INT16_MIN -32768
@@ -218,6 +220,10 @@ public:
     bool check_solution = false;
     const char *log_filename = NULL;
 
+    // set in batch worker processes, which write a summary of the
+    // log for the batch report
+    bool batch_worker = false;
+
     /*
       information about a log from find_log_info
      */
@@ -236,6 +242,32 @@ private:
 
     LogReader logreader{_vehicle.ahrs, _vehicle.ins, _vehicle.barometer, _vehicle.compass, _vehicle.gps, _vehicle.airspeed, _vehicle.dataflash, log_structure, ARRAY_SIZE(log_structure), nottypes};
 
+    /*
+      statistics of the magnitude of an EKF innovation over the log
+     */
+    struct innovation_stats {
+        uint32_t count;
+        float max;
+        double sum_sq;
+
+        void update(float v) {
+            count++;
+            max = MAX(max, v);
+            sum_sq += (double)v * v;
+        }
+        float rms(void) const {
+            return count ? sqrt(sum_sq / count) : 0;
+        }
+    };
+    struct {
+        innovation_stats vel;
+        innovation_stats pos;
+        innovation_stats mag;
+        innovation_stats tas;
+    } innovations {};
+
+    void write_batch_summary(uint32_t message_count);
+
     FILE *plotf;
     FILE *plotf2;
     FILE *ekf1f;
@@ -247,6 +279,7 @@ private:
     bool done_baro_init;
     bool done_home_init;
     int32_t arm_time_ms = -1;
+    uint32_t start_time_ms = 0;
     bool ahrs_healthy;
     bool have_imt = false;
     bool have_imt2 = false;
@@ -300,6 +333,7 @@ void Replay::usage(void)
     ::printf("\t--accel-mask MASK  set accel mask (1=accel1 only, 2=accel2 only, 3=both)\n");
     ::printf("\t--gyro-mask MASK   set gyro mask (1=gyro1 only, 2=gyro2 only, 3=both)\n");
     ::printf("\t--arm-time time    arm at time (milliseconds)\n");
+    ::printf("\t--start-time time  start replay at log time (milliseconds)\n");
     ::printf("\t--no-imt           don't use IMT data\n");
     ::printf("\t--check-generate   generate CHEK messages in output\n");
     ::printf("\t--check            check solution against CHEK messages\n");
@@ -308,6 +342,9 @@ void Replay::usage(void)
     ::printf("\t--tolerance-vel    tolerance for velocity in meters/second\n");
     ::printf("\t--nottypes         list of msg types not to output, comma separated\n");
     ::printf("\t--downsample       downsampling rate for output\n");
+    ::printf("\t--batch FILE       replay each log listed in FILE, one per line\n");
+    ::printf("\t--jobs N           number of batch worker processes (default: one per CPU)\n");
+    ::printf("\t--batch-dir DIR    directory for batch output (default: replay_batch)\n");
 }
 
 
@@ -318,7 +355,8 @@ enum {
     OPT_TOLERANCE_POS,
     OPT_TOLERANCE_VEL,
     OPT_NOTTYPES,
-    OPT_DOWNSAMPLE
+    OPT_DOWNSAMPLE,
+    OPT_START_TIME
 };
 
 void Replay::flush_dataflash(void) {
@@ -370,6 +408,7 @@ void Replay::_parse_command_line(uint8_t argc, char * const argv[])
         {"tolerance-vel",   true,   0, OPT_TOLERANCE_VEL},
         {"nottypes",        true,   0, OPT_NOTTYPES},
         {"downsample",      true,   0, OPT_DOWNSAMPLE},
+        {"start-time",      true,   0, OPT_START_TIME},
         {0, false, 0, 0}
     };
 
@@ -440,6 +479,10 @@ void Replay::_parse_command_line(uint8_t argc, char * const argv[])
             downsample = atoi(gopt.optarg);
             break;
 
+        case OPT_START_TIME:
+            start_time_ms = strtoul(gopt.optarg, NULL, 0);
+            break;
+
         case 'h':
         default:
             usage();
@@ -464,6 +507,8 @@ public:
     uint64_t last_clock_timestamp;
 private:
     MsgHandler *handler;
+    MsgField<uint64_t> field_time_us;
+    MsgField<uint32_t> field_time_ms;
 };
 
 bool IMUCounter::handle_log_format_msg(const struct log_Format &f) {
@@ -471,6 +516,8 @@ bool IMUCounter::handle_log_format_msg(const struct log_Format &f) {
         !strncmp(f.name,"IMT",4)) {
         // an IMU or IMT message message
         handler = new MsgHandler(f);
+        handler->resolve_field("TimeUS", field_time_us);
+        handler->resolve_field("TimeMS", field_time_ms);
     }
 
     return true;
@@ -483,9 +530,10 @@ bool IMUCounter::handle_msg(const struct log_Format &f, uint8_t *msg) {
         return true;
     }
 
-    if (handler->field_value(msg, "TimeUS", last_clock_timestamp)) {
-    } else if (handler->field_value(msg, "TimeMS", last_clock_timestamp)) {
-        last_clock_timestamp *= 1000;
+    if (field_time_us.found()) {
+        last_clock_timestamp = field_time_us.get(msg);
+    } else if (field_time_ms.found()) {
+        last_clock_timestamp = field_time_ms.get(msg) * 1000ULL;
     } else {
         ::printf("Unable to find timestamp in message");
     }
@@ -616,6 +664,21 @@ void Replay::setup()
 
     feenableexcept(FE_INVALID | FE_OVERFLOW);
 
+    if (start_time_ms != 0) {
+        /*
+          skip to the start time. Parameters and the MSG messages
+          which give the vehicle type are only logged at the start, so
+          they are still handled
+         */
+        const char *keep_types[] = { "PARM", "MSG", NULL };
+        if (!logreader.index_log() ||
+            !logreader.seek_time(start_time_ms * 1000ULL, keep_types)) {
+            ::printf("Failed to seek to %u ms\n", (unsigned)start_time_ms);
+            exit(1);
+        }
+        ::printf("Starting at %u ms\n", (unsigned)start_time_ms);
+    }
+
 
     plotf = fopen("plot.dat", "w");
     plotf2 = fopen("plot2.dat", "w");
@@ -845,8 +908,22 @@ void Replay::log_check_solution(void)
 }
 
 
+/*
+  wall clock time in microseconds, for measuring how fast the log
+  replays
+ */
+static uint64_t wall_clock_usec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec*1000000ULL + ts.tv_nsec/1000;
+}
+
 void Replay::loop()
 {
+    const uint64_t start_usec = wall_clock_usec();
+    uint32_t message_count = 0;
+
     while (true) {
         char type[5];
 
@@ -859,9 +936,14 @@ void Replay::loop()
 
         if (!logreader.update(type)) {
             ::printf("End of log at %.1f seconds\n", AP_HAL::millis()*0.001f);
+            const float elapsed = (wall_clock_usec() - start_usec) * 1.0e-6f;
+            ::printf("Replayed %u messages in %.2f seconds (%.0f messages/s)\n",
+                     (unsigned)message_count, elapsed,
+                     elapsed > 0 ? message_count / elapsed : 0);
             fclose(plotf);
             break;
         }
+        message_count++;
         read_sensors(type);
 
         if (streq(type,"ATT")) {
@@ -901,6 +983,10 @@ void Replay::loop()
             _vehicle.EKF.getMagNED(magNED);
             _vehicle.EKF.getMagXYZ(magXYZ);
             _vehicle.EKF.getInnovations(velInnov, posInnov, magInnov, tasInnov);
+            innovations.vel.update(velInnov.length());
+            innovations.pos.update(posInnov.length());
+            innovations.mag.update(magInnov.length());
+            innovations.tas.update(fabsf(tasInnov));
             _vehicle.EKF.getVariances(velVar, posVar, hgtVar, magVar, tasVar, offset);
             _vehicle.EKF.getFilterFaults(faultStatus);
             _vehicle.EKF.getPosNED(ekf_relpos);
@@ -1078,12 +1164,45 @@ void Replay::loop()
 
     flush_dataflash();
 
+    if (batch_worker) {
+        write_batch_summary(message_count);
+    }
+
     if (check_solution) {
         report_checks();
     }
     exit(0);
 }
 
+/*
+  write the one line summary of this log used in batch reports
+ */
+void Replay::write_batch_summary(uint32_t message_count)
+{
+    FILE *f = fopen(REPLAY_BATCH_SUMMARY_FILE, "w");
+    if (f == NULL) {
+        return;
+    }
+    fprintf(f, "%u\t%.1f", (unsigned)message_count, AP_HAL::millis()*0.001f);
+    if (check_solution) {
+        fprintf(f, "\t%.3f\t%.3f\t%.3f\t%.3f\t%.3f",
+                check_result.max_roll_error,
+                check_result.max_pitch_error,
+                check_result.max_yaw_error,
+                check_result.max_pos_error,
+                check_result.max_vel_error);
+    } else {
+        fprintf(f, "\t-\t-\t-\t-\t-");
+    }
+    const innovation_stats *stats[] = { &innovations.vel, &innovations.pos,
+                                        &innovations.mag, &innovations.tas };
+    for (uint8_t i=0; i<ARRAY_SIZE(stats); i++) {
+        fprintf(f, "\t%.3f\t%.3f", stats[i]->max, stats[i]->rms());
+    }
+    fprintf(f, "\n");
+    fclose(f);
+}
+
 
 bool Replay::show_error(const char *text, float max_error, float tolerance)
 {
@@ -1129,4 +1248,28 @@ void Replay::report_checks(void)
     }
 }
 
-AP_HAL_MAIN_CALLBACKS(&replay);
+/*
+  batch mode is started here rather than in setup(), as the workers
+  must be forked before the HAL starts its threads
+ */
+extern "C" {
+int AP_MAIN(int argc, char* const argv[]);
+int AP_MAIN(int argc, char* const argv[])
+{
+    char **args = (char **)calloc(argc+1, sizeof(char *));
+    if (args == NULL) {
+        return 1;
+    }
+    memcpy(args, argv, argc * sizeof(char *));
+
+    ReplayBatch batch;
+    if (batch.parse_command_line(argc, args)) {
+        // returns only in a worker
+        batch.run(argc, args);
+        replay.batch_worker = true;
+    }
+
+    hal.run(argc, args, &replay);
+    return 0;
+}
+}
@@ -0,0 +1,309 @@
+#include "ReplayBatch.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+ReplayBatch::~ReplayBatch()
+{
+    for (uint16_t i=0; i<num_logs; i++) {
+        free(jobs[i].log);
+    }
+    free(jobs);
+}
+
+/*
+  take the batch options out of the command line, so the HAL and
+  Replay parsers in each worker never see them
+ */
+bool ReplayBatch::parse_command_line(int &argc, char **argv)
+{
+    int n = 1;
+    for (int i=1; i<argc; i++) {
+        if (i+1 < argc && strcmp(argv[i], "--batch") == 0) {
+            list_file = argv[++i];
+        } else if (i+1 < argc && strcmp(argv[i], "--batch-dir") == 0) {
+            output_dir = argv[++i];
+        } else if (i+1 < argc && strcmp(argv[i], "--jobs") == 0) {
+            num_jobs = strtoul(argv[++i], NULL, 0);
+        } else {
+            argv[n++] = argv[i];
+        }
+    }
+    argc = n;
+    argv[n] = NULL;
+    return list_file != NULL;
+}
+
+/*
+  load the list of logs, one per line. Blank lines and lines starting
+  with # are ignored. Paths are made absolute as each worker runs in
+  its own directory
+ */
+bool ReplayBatch::load_list(void)
+{
+    FILE *f = fopen(list_file, "r");
+    if (f == NULL) {
+        perror(list_file);
+        return false;
+    }
+    char line[PATH_MAX];
+    uint16_t allocated = 0;
+    while (fgets(line, sizeof(line), f) != NULL) {
+        char *p = line;
+        while (*p == ' ' || *p == '\t') {
+            p++;
+        }
+        size_t len = strlen(p);
+        while (len > 0 && strchr(" \t\r\n", p[len-1]) != NULL) {
+            p[--len] = 0;
+        }
+        if (len == 0 || p[0] == '#') {
+            continue;
+        }
+        if (num_logs == UINT16_MAX) {
+            ::printf("Too many logs in %s\n", list_file);
+            break;
+        }
+        if (num_logs == allocated) {
+            uint32_t new_allocated = allocated ? allocated * 2 : 64;
+            if (new_allocated > UINT16_MAX) {
+                new_allocated = UINT16_MAX;
+            }
+            Job *new_jobs = (Job *)realloc(jobs, new_allocated * sizeof(Job));
+            if (new_jobs == NULL) {
+                fclose(f);
+                return false;
+            }
+            jobs = new_jobs;
+            allocated = new_allocated;
+        }
+        char resolved[PATH_MAX];
+        Job &job = jobs[num_logs];
+        memset(&job, 0, sizeof(job));
+        // a missing log is left as given, and fails in its worker
+        job.log = strdup(realpath(p, resolved) ? resolved : p);
+        if (job.log == NULL) {
+            fclose(f);
+            return false;
+        }
+        num_logs++;
+    }
+    fclose(f);
+    return true;
+}
+
+/*
+  each log is replayed in a directory named for its position in the
+  list and its file name
+ */
+void ReplayBatch::job_dir(uint16_t i, char *buf, size_t buflen) const
+{
+    const char *name = strrchr(jobs[i].log, '/');
+    name = name ? name+1 : jobs[i].log;
+    snprintf(buf, buflen, "%s/%04u-%s", output_dir, (unsigned)i+1, name);
+}
+
+/*
+  set up a newly forked worker to replay log i: move into the log's
+  directory, send output to a file there and make the command line
+  end with the log
+ */
+void ReplayBatch::worker_setup(uint16_t i, int &argc, char **&argv)
+{
+    char dir[PATH_MAX];
+    job_dir(i, dir, sizeof(dir));
+    if ((mkdir(dir, 0755) != 0 && errno != EEXIST) || chdir(dir) != 0) {
+        perror(dir);
+        _exit(1);
+    }
+    int fd = open("replay.txt", O_WRONLY|O_CREAT|O_TRUNC, 0644);
+    if (fd != -1) {
+        dup2(fd, STDOUT_FILENO);
+        dup2(fd, STDERR_FILENO);
+        close(fd);
+    }
+
+    bool have_separator = false;
+    for (int j=1; j<argc; j++) {
+        if (strcmp(argv[j], "--") == 0) {
+            have_separator = true;
+        }
+    }
+    char **worker_argv = (char **)calloc(argc+3, sizeof(char *));
+    if (worker_argv == NULL) {
+        _exit(1);
+    }
+    memcpy(worker_argv, argv, argc * sizeof(char *));
+    if (!have_separator) {
+        // Replay's own arguments go after the HAL's
+        worker_argv[argc++] = (char *)"--";
+    }
+    worker_argv[argc++] = jobs[i].log;
+    worker_argv[argc] = NULL;
+    argv = worker_argv;
+}
+
+ReplayBatch::Job *ReplayBatch::find_job(pid_t pid)
+{
+    for (uint16_t i=0; i<num_logs; i++) {
+        if (jobs[i].pid == pid) {
+            return &jobs[i];
+        }
+    }
+    return NULL;
+}
+
+bool ReplayBatch::job_ok(const Job &job) const
+{
+    return job.finished && WIFEXITED(job.status) && WEXITSTATUS(job.status) == 0;
+}
+
+void ReplayBatch::describe_status(const Job &job, char *buf, size_t buflen) const
+{
+    if (!job.finished) {
+        snprintf(buf, buflen, "not run");
+    } else if (WIFSIGNALED(job.status)) {
+        snprintf(buf, buflen, "killed by signal %d", WTERMSIG(job.status));
+    } else if (WEXITSTATUS(job.status) != 0) {
+        snprintf(buf, buflen, "failed (exit %d)", WEXITSTATUS(job.status));
+    } else {
+        snprintf(buf, buflen, "ok");
+    }
+}
+
+/*
+  gather the summary of each log into OUTPUT_DIR/report.txt
+ */
+void ReplayBatch::write_report(void)
+{
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/report.txt", output_dir);
+    FILE *f = fopen(path, "w");
+    if (f == NULL) {
+        perror(path);
+        return;
+    }
+
+    uint16_t num_ok = 0;
+    for (uint16_t i=0; i<num_logs; i++) {
+        if (job_ok(jobs[i])) {
+            num_ok++;
+        }
+    }
+    fprintf(f, "# %u logs, %u ok, %u failed\n",
+            (unsigned)num_logs, (unsigned)num_ok, (unsigned)(num_logs - num_ok));
+    fprintf(f, "Log\tStatus\t%s\n", REPLAY_BATCH_SUMMARY_COLUMNS);
+
+    for (uint16_t i=0; i<num_logs; i++) {
+        char status[40];
+        describe_status(jobs[i], status, sizeof(status));
+
+        // a worker which died early may not have written a summary
+        char summary[512] = "-";
+        char dir[PATH_MAX];
+        job_dir(i, dir, sizeof(dir));
+        const int len = snprintf(path, sizeof(path), "%s/%s", dir, REPLAY_BATCH_SUMMARY_FILE);
+        FILE *sf = NULL;
+        if (len < 0 || (size_t)len >= sizeof(path)) {
+            snprintf(summary, sizeof(summary), "- (path too long)");
+        } else {
+            sf = fopen(path, "r");
+        }
+        if (sf != NULL) {
+            if (fgets(summary, sizeof(summary), sf) != NULL) {
+                summary[strcspn(summary, "\r\n")] = 0;
+            }
+            fclose(sf);
+        }
+
+        fprintf(f, "%s\t%s\t%s\n", jobs[i].log, status, summary);
+    }
+    fclose(f);
+
+    ::printf("%u logs, %u ok, %u failed. Report in %s/report.txt\n",
+             (unsigned)num_logs, (unsigned)num_ok, (unsigned)(num_logs - num_ok),
+             output_dir);
+}
+
+void ReplayBatch::run(int &argc, char **&argv)
+{
+    if (!load_list()) {
+        exit(1);
+    }
+    if (num_logs == 0) {
+        ::printf("No logs in %s\n", list_file);
+        exit(1);
+    }
+    if (num_jobs == 0) {
+        long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        num_jobs = num_cpus > 0 ? num_cpus : 1;
+    }
+    if (mkdir(output_dir, 0755) != 0 && errno != EEXIST) {
+        perror(output_dir);
+        exit(1);
+    }
+
+    ::printf("Replaying %u logs with %u workers into %s\n",
+             (unsigned)num_logs, (unsigned)num_jobs, output_dir);
+
+    uint16_t next = 0;
+    uint16_t running = 0;
+    uint16_t finished = 0;
+    while (next < num_logs || running > 0) {
+        if (next < num_logs && running < num_jobs) {
+            uint16_t i = next++;
+            // don't let the worker inherit and repeat buffered output
+            fflush(stdout);
+            pid_t pid = fork();
+            if (pid == 0) {
+                worker_setup(i, argc, argv);
+                return;
+            }
+            if (pid == -1) {
+                perror("fork");
+                continue;
+            }
+            jobs[i].pid = pid;
+            running++;
+            continue;
+        }
+
+        int status;
+        pid_t pid = wait(&status);
+        if (pid == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("wait");
+            break;
+        }
+        Job *job = find_job(pid);
+        if (job == NULL) {
+            continue;
+        }
+        job->status = status;
+        job->finished = true;
+        running--;
+        finished++;
+
+        char desc[40];
+        describe_status(*job, desc, sizeof(desc));
+        ::printf("[%u/%u] %s: %s\n", (unsigned)finished, (unsigned)num_logs, job->log, desc);
+    }
+
+    write_report();
+
+    for (uint16_t i=0; i<num_logs; i++) {
+        if (!job_ok(jobs[i])) {
+            exit(1);
+        }
+    }
+    exit(0);
+}
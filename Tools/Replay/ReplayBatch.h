@@ -0,0 +1,59 @@
+#ifndef REPLAY_BATCH_H
+#define REPLAY_BATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+// summary written by each worker into its directory, one line of
+// tab separated values in REPLAY_BATCH_SUMMARY_COLUMNS order
+#define REPLAY_BATCH_SUMMARY_FILE "summary.txt"
+#define REPLAY_BATCH_SUMMARY_COLUMNS "Messages\tDuration(s)\t"          \
+    "RollErr(deg)\tPitchErr(deg)\tYawErr(deg)\tPosErr(m)\tVelErr(m/s)\t" \
+    "VelInnovMax\tVelInnovRMS\tPosInnovMax\tPosInnovRMS\t"               \
+    "MagInnovMax\tMagInnovRMS\tTASInnovMax\tTASInnovRMS"
+
+/*
+  batch mode for Replay. A list of logs is replayed by a pool of
+  worker processes. Replay is full of singletons, so rather than
+  replaying several logs in one process each worker is forked before
+  the HAL is started, giving it a fresh copy of the HAL and vehicle
+  objects. Each worker replays one log in its own directory, and the
+  per-log summaries are collected into a single report
+ */
+class ReplayBatch {
+public:
+    ~ReplayBatch();
+
+    // remove the batch options from argv. Returns true if a batch
+    // was requested
+    bool parse_command_line(int &argc, char **argv);
+
+    // replay the logs, write the report and exit. Returns only in a
+    // worker process, with argc/argv set up for its log
+    void run(int &argc, char **&argv);
+
+private:
+    const char *list_file = NULL;
+    const char *output_dir = "replay_batch";
+    uint16_t num_jobs = 0;
+
+    struct Job {
+        char *log;
+        pid_t pid;
+        int status;
+        bool finished;
+    };
+    Job *jobs = NULL;
+    uint16_t num_logs = 0;
+
+    bool load_list(void);
+    void job_dir(uint16_t i, char *buf, size_t buflen) const;
+    void worker_setup(uint16_t i, int &argc, char **&argv);
+    Job *find_job(pid_t pid);
+    bool job_ok(const Job &job) const;
+    void describe_status(const Job &job, char *buf, size_t buflen) const;
+    void write_report(void);
+};
+
+#endif
@@ -327,7 +327,7 @@ private:
         ubx_rxm_rawx rxm_rawx;
 #endif
         ubx_ack_ack ack;
-        uint8_t bytes[];
+        uint8_t bytes[1];
     } _buffer;
 
     enum ubs_protocol_bytes {
@@ -58,6 +58,16 @@ public:
        optional function to stop clock at a given time, used by log replay
      */
     virtual void     stop_clock(uint64_t time_usec) {}
+
+    /*
+      optionally run a proc on a worker thread, on platforms with
+      spare CPU cores. Returns true if the proc was queued, or is
+      still queued or running from an earlier call. Returns false if
+      no worker is available, in which case the caller should run the
+      proc itself. If run_time_us is not NULL the worker stores the
+      time the proc took in microseconds there each time it finishes
+     */
+    virtual bool     run_on_worker(AP_HAL::MemberProc, uint32_t *run_time_us = NULL) { return false; }
 };
 
 #endif // __AP_HAL_SCHEDULER_H__
@@ -37,3 +37,16 @@ void AP_HAL::UARTDriver::vprintf(const char *fmt, va_list ap)
 {
     print_vprintf((AP_HAL::Print*)this, 0, fmt, ap);
 }
+
+uint16_t AP_HAL::UARTDriver::read_buffer(uint8_t *buffer, uint16_t count)
+{
+    uint16_t n = 0;
+    while (n < count) {
+        int16_t c = read();
+        if (c == -1) {
+            break;
+        }
+        buffer[n++] = (uint8_t)c;
+    }
+    return n;
+}
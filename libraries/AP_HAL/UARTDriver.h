@@ -47,6 +47,23 @@ public:
     virtual void set_flow_control(enum flow_control flow_control_setting) {};
     virtual enum flow_control get_flow_control(void) { return FLOW_CONTROL_DISABLE; };
 
+    /*
+      reserve size bytes of contiguous space in the write buffer, to
+      be filled in place and then sent with write_commit(). Nothing is
+      sent until the commit, so a reserved packet goes out whole.
+      Returns NULL if the space isn't available or the driver doesn't
+      support reservations, in which case use write()
+     */
+    virtual uint8_t *write_reserve(uint16_t size) { return NULL; }
+    virtual void write_commit(uint16_t size) {}
+
+    /*
+      read up to count bytes, returning the number read. The default
+      reads a byte at a time with read(); drivers with a receive
+      buffer can do better
+     */
+    virtual uint16_t read_buffer(uint8_t *buffer, uint16_t count);
+
     /* Implementations of BetterStream virtual methods. These are
      * provided by AP_HAL to ensure consistency between ports to
      * different boards
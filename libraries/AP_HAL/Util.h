@@ -90,6 +90,23 @@ public:
     virtual void perf_end(perf_counter_t h) {}
     virtual void perf_count(perf_counter_t h) {}
 
+    /*
+      a snapshot of one counter. Times are in microseconds, and are
+      the elapsed times of a PC_ELAPSED counter or the intervals
+      between events of a PC_INTERVAL counter
+     */
+    struct perf_info {
+        const char *name;
+        perf_counter_type type;
+        uint64_t count;
+        float avg_us;
+        float min_us;
+        float max_us;
+        float stddev_us;
+    };
+    // get the counter at index idx, returning false past the last one
+    virtual bool perf_get_info(uint16_t idx, perf_info &info) { return false; }
+
     // create a new semaphore
     virtual Semaphore *new_semaphore(void) { return nullptr; }
     
@@ -0,0 +1,116 @@
+#include <AP_gbenchmark.h>
+
+#include <string.h>
+
+#include <AP_HAL/utility/RingBuffer.h>
+
+#define BUFFER_SIZE 8192
+
+/*
+  ring buffer handled with the old style BUF_* macros, as a baseline
+ */
+struct MacroBuffer {
+    uint8_t _buf[BUFFER_SIZE];
+    uint16_t _buf_size = BUFFER_SIZE;
+    volatile uint16_t _buf_head = 0;
+    volatile uint16_t _buf_tail = 0;
+
+    uint16_t write(const uint8_t *data, uint16_t len)
+    {
+        uint16_t _head;
+        uint16_t space = BUF_SPACE(_buf);
+        if (len > space) {
+            len = space;
+        }
+        uint16_t n = _buf_size - _buf_tail;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(&_buf[_buf_tail], data, n);
+        BUF_ADVANCETAIL(_buf, n);
+        if (len > n) {
+            memcpy(&_buf[_buf_tail], &data[n], len - n);
+            BUF_ADVANCETAIL(_buf, len - n);
+        }
+        return len;
+    }
+
+    uint16_t read(uint8_t *data, uint16_t len)
+    {
+        uint16_t _tail;
+        uint16_t available = BUF_AVAILABLE(_buf);
+        if (len > available) {
+            len = available;
+        }
+        uint16_t n = _buf_size - _buf_head;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(data, &_buf[_buf_head], n);
+        BUF_ADVANCEHEAD(_buf, n);
+        if (len > n) {
+            memcpy(&data[n], &_buf[_buf_head], len - n);
+            BUF_ADVANCEHEAD(_buf, len - n);
+        }
+        return len;
+    }
+};
+
+static void BM_MacroBufferWriteRead(benchmark::State& state)
+{
+    MacroBuffer buffer;
+    uint8_t data[256] {};
+    const uint16_t len = state.range_x();
+
+    while (state.KeepRunning()) {
+        buffer.write(data, len);
+        buffer.read(data, len);
+        gbenchmark_escape(data);
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * len);
+}
+
+static void BM_ByteBufferWriteRead(benchmark::State& state)
+{
+    ByteBuffer buffer(BUFFER_SIZE);
+    uint8_t data[256] {};
+    const uint32_t len = state.range_x();
+
+    while (state.KeepRunning()) {
+        buffer.write(data, len);
+        buffer.read(data, len);
+        gbenchmark_escape(data);
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * len);
+}
+
+/*
+  fill the buffer in place with reserve()/commit() and drain it with
+  readptr()/advance(), as the UART and log drivers do
+ */
+static void BM_ByteBufferReserveCommit(benchmark::State& state)
+{
+    ByteBuffer buffer(BUFFER_SIZE);
+    const uint32_t len = state.range_x();
+
+    while (state.KeepRunning()) {
+        uint32_t n;
+        uint8_t *w = buffer.reserve(n);
+        if (n > len) {
+            n = len;
+        }
+        memset(w, 0x55, n);
+        buffer.commit(n);
+
+        const uint8_t *r = buffer.readptr(n);
+        gbenchmark_escape((void *)r);
+        buffer.advance(n);
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * len);
+}
+
+BENCHMARK(BM_MacroBufferWriteRead)->Arg(1)->Arg(17)->Arg(256);
+BENCHMARK(BM_ByteBufferWriteRead)->Arg(1)->Arg(17)->Arg(256);
+BENCHMARK(BM_ByteBufferReserveCommit)->Arg(1)->Arg(17)->Arg(256);
+
+BENCHMARK_MAIN()
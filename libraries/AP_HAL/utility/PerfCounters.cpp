@@ -0,0 +1,333 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  performance counters for the HALs without native ones (Linux and
+  SITL). Based on the Linux HAL counters by Intel Corporation
+ */
+
+#include <AP_HAL/AP_HAL.h>
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX || CONFIG_HAL_BOARD == HAL_BOARD_SITL
+
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "PerfCounters.h"
+#include "TraceEvents.h"
+
+extern const AP_HAL::HAL& hal;
+
+struct PerfCounters::counter {
+    struct counter *next;
+    const char *name;
+    perf_counter_type type;
+    // taken while the statistics are updated or read
+    uint8_t lock;
+    // number of events
+    uint64_t count;
+    // PC_ELAPSED: time of perf_begin(), PC_INTERVAL: time of the last event
+    uint64_t start;
+    // statistics of the elapsed times or intervals, in nanoseconds
+    uint64_t samples;
+    uint64_t least;
+    uint64_t most;
+    double mean;
+    double m2;
+};
+
+PerfCounters::counter *PerfCounters::_head;
+PerfCounters::counter *PerfCounters::_tail;
+const char *PerfCounters::_exit_file;
+volatile sig_atomic_t PerfCounters::_dump_requested;
+volatile sig_atomic_t PerfCounters::_exit_requested;
+
+// serialises additions to the registry
+static pthread_mutex_t registry_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static inline uint64_t now_nsec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_nsec + (ts.tv_sec * 1000000000ULL);
+}
+
+static inline void lock_counter(uint8_t *lock)
+{
+    while (__atomic_test_and_set(lock, __ATOMIC_ACQUIRE)) {
+    }
+}
+
+static inline void unlock_counter(uint8_t *lock)
+{
+    __atomic_clear(lock, __ATOMIC_RELEASE);
+}
+
+PerfCounters::perf_counter_t PerfCounters::alloc(perf_counter_type type, const char *name)
+{
+    struct counter *c = (struct counter *)calloc(1, sizeof(struct counter));
+    if (c == NULL) {
+        return NULL;
+    }
+    c->name = name;
+    c->type = type;
+    c->least = UINT64_MAX;
+
+    /*
+      readers walk the list without the mutex, so the counter must be
+      complete before it is linked in
+     */
+    pthread_mutex_lock(&registry_mutex);
+    if (_tail == NULL) {
+        __atomic_store_n(&_head, c, __ATOMIC_RELEASE);
+    } else {
+        __atomic_store_n(&_tail->next, c, __ATOMIC_RELEASE);
+    }
+    _tail = c;
+    pthread_mutex_unlock(&registry_mutex);
+
+    return (perf_counter_t)c;
+}
+
+/*
+  add an elapsed time or interval to the statistics, keeping a running
+  mean and variance with Welford's method, as PX4 does
+ */
+void PerfCounters::_update_stats(struct counter *c, uint64_t sample_ns)
+{
+    lock_counter(&c->lock);
+    c->samples++;
+    if (sample_ns < c->least) {
+        c->least = sample_ns;
+    }
+    if (sample_ns > c->most) {
+        c->most = sample_ns;
+    }
+    const double delta = sample_ns - c->mean;
+    c->mean += delta / c->samples;
+    c->m2 += delta * (sample_ns - c->mean);
+    unlock_counter(&c->lock);
+}
+
+void PerfCounters::begin(perf_counter_t perf)
+{
+    struct counter *c = (struct counter *)perf;
+    if (c == NULL) {
+        return;
+    }
+    if (c->type != AP_HAL::Util::PC_ELAPSED) {
+        hal.console->printf("perf_begin() called over a perf_counter_t(%s) that"
+                            " is not of the PC_ELAPSED type.\n", c->name);
+        return;
+    }
+    TRACE_BEGIN(c->name);
+    c->start = now_nsec();
+}
+
+void PerfCounters::end(perf_counter_t perf)
+{
+    struct counter *c = (struct counter *)perf;
+    if (c == NULL) {
+        return;
+    }
+    if (c->type != AP_HAL::Util::PC_ELAPSED) {
+        hal.console->printf("perf_end() called over a perf_counter_t(%s) "
+                            "that is not of the PC_ELAPSED type.\n", c->name);
+        return;
+    }
+    if (c->start == 0) {
+        hal.console->printf("perf_end() called before an perf_begin() on %s.\n",
+                            c->name);
+        return;
+    }
+    const uint64_t elapsed = now_nsec() - c->start;
+    c->start = 0;
+    TRACE_END(c->name);
+    __atomic_add_fetch(&c->count, 1, __ATOMIC_RELAXED);
+    _update_stats(c, elapsed);
+}
+
+void PerfCounters::count(perf_counter_t perf)
+{
+    struct counter *c = (struct counter *)perf;
+    if (c == NULL) {
+        return;
+    }
+    switch (c->type) {
+    case AP_HAL::Util::PC_COUNT:
+        __atomic_add_fetch(&c->count, 1, __ATOMIC_RELAXED);
+        break;
+    case AP_HAL::Util::PC_INTERVAL: {
+        const uint64_t now = now_nsec();
+        const uint64_t last = __atomic_exchange_n(&c->start, now, __ATOMIC_RELAXED);
+        if (__atomic_fetch_add(&c->count, 1, __ATOMIC_RELAXED) != 0) {
+            _update_stats(c, now - last);
+        }
+        break;
+    }
+    default:
+        hal.console->printf("perf_count() called over a perf_counter_t(%s) "
+                            "that is not of the PC_COUNT or PC_INTERVAL type.\n",
+                            c->name);
+        break;
+    }
+}
+
+bool PerfCounters::get_info(uint16_t idx, AP_HAL::Util::perf_info &info)
+{
+    struct counter *c = __atomic_load_n(&_head, __ATOMIC_ACQUIRE);
+    while (c != NULL && idx > 0) {
+        c = __atomic_load_n(&c->next, __ATOMIC_ACQUIRE);
+        idx--;
+    }
+    if (c == NULL) {
+        return false;
+    }
+
+    info.name = c->name;
+    info.type = c->type;
+    info.count = __atomic_load_n(&c->count, __ATOMIC_RELAXED);
+
+    lock_counter(&c->lock);
+    const uint64_t samples = c->samples;
+    const uint64_t least = c->least;
+    const uint64_t most = c->most;
+    const double mean = c->mean;
+    const double m2 = c->m2;
+    unlock_counter(&c->lock);
+
+    if (samples == 0) {
+        info.avg_us = info.min_us = info.max_us = info.stddev_us = 0;
+    } else {
+        info.avg_us = mean * 1.0e-3;
+        info.min_us = least * 1.0e-3f;
+        info.max_us = most * 1.0e-3f;
+        info.stddev_us = samples > 1 ? sqrt(m2 / (samples - 1)) * 1.0e-3 : 0;
+    }
+    return true;
+}
+
+static const char *type_name(AP_HAL::Util::perf_counter_type type)
+{
+    switch (type) {
+    case AP_HAL::Util::PC_COUNT:
+        return "count";
+    case AP_HAL::Util::PC_ELAPSED:
+        return "elapsed";
+    case AP_HAL::Util::PC_INTERVAL:
+        return "interval";
+    }
+    return "unknown";
+}
+
+void PerfCounters::print(FILE *f)
+{
+    AP_HAL::Util::perf_info info;
+    fprintf(f, "%-24s %-8s %12s %10s %10s %10s %10s\n",
+            "name", "type", "count", "avg_us", "min_us", "max_us", "stddev_us");
+    for (uint16_t i=0; get_info(i, info); i++) {
+        fprintf(f, "%-24s %-8s %12llu %10.1f %10.1f %10.1f %10.1f\n",
+                info.name, type_name(info.type), (unsigned long long)info.count,
+                info.avg_us, info.min_us, info.max_us, info.stddev_us);
+    }
+}
+
+bool PerfCounters::write_file(const char *path)
+{
+    FILE *f = fopen(path, "w");
+    if (f == NULL) {
+        return false;
+    }
+    const size_t len = strlen(path);
+    const bool json = len >= 5 && strcmp(&path[len-5], ".json") == 0;
+
+    AP_HAL::Util::perf_info info;
+    if (json) {
+        fprintf(f, "[\n");
+    } else {
+        fprintf(f, "name,type,count,avg_us,min_us,max_us,stddev_us\n");
+    }
+    for (uint16_t i=0; get_info(i, info); i++) {
+        if (json) {
+            fprintf(f, "%s  {\"name\": \"%s\", \"type\": \"%s\", \"count\": %llu, "
+                    "\"avg_us\": %.3f, \"min_us\": %.3f, \"max_us\": %.3f, \"stddev_us\": %.3f}",
+                    i==0?"":",\n",
+                    info.name, type_name(info.type), (unsigned long long)info.count,
+                    info.avg_us, info.min_us, info.max_us, info.stddev_us);
+        } else {
+            fprintf(f, "%s,%s,%llu,%.3f,%.3f,%.3f,%.3f\n",
+                    info.name, type_name(info.type), (unsigned long long)info.count,
+                    info.avg_us, info.min_us, info.max_us, info.stddev_us);
+        }
+    }
+    if (json) {
+        fprintf(f, "\n]\n");
+    }
+    return fclose(f) == 0;
+}
+
+void PerfCounters::_at_exit(void)
+{
+    if (!write_file(_exit_file)) {
+        fprintf(stderr, "Failed to write perf counters to %s\n", _exit_file);
+    }
+}
+
+/*
+  only set flags here. The work is done by poll() and the HAL's main
+  loop, outside the signal handler
+ */
+void PerfCounters::_signal_handler(int signum)
+{
+    if (signum == SIGUSR1) {
+        _dump_requested = 1;
+        return;
+    }
+    if (_exit_requested) {
+        // a second request, perhaps because the main loop isn't running
+        signal(signum, SIG_DFL);
+        raise(signum);
+        return;
+    }
+    _exit_requested = 1;
+}
+
+void PerfCounters::init(const char *exit_file)
+{
+    signal(SIGUSR1, _signal_handler);
+    if (exit_file != NULL) {
+        _exit_file = exit_file;
+        atexit(_at_exit);
+        exit_on_signal();
+    }
+}
+
+void PerfCounters::exit_on_signal(void)
+{
+    signal(SIGINT, _signal_handler);
+    signal(SIGTERM, _signal_handler);
+}
+
+void PerfCounters::poll(void)
+{
+    if (_dump_requested) {
+        _dump_requested = 0;
+        print(stdout);
+    }
+}
+
+#endif // CONFIG_HAL_BOARD
@@ -0,0 +1,89 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  performance counters for the HALs without native ones (Linux and
+  SITL), behind the AP_HAL::Util perf_*() calls
+ */
+#pragma once
+
+#include <AP_HAL/AP_HAL.h>
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX || CONFIG_HAL_BOARD == HAL_BOARD_SITL
+
+#include <signal.h>
+#include <stdio.h>
+
+/*
+  Every counter is kept in a registry so it can be reported: printed
+  to stdout on SIGUSR1, read with get_info() for MAVLink, and written
+  to a CSV or JSON file when the process exits.
+
+  Counters may be updated from any thread. A PC_ELAPSED counter must
+  only be timed by one thread at a time, as with the PX4 counters.
+ */
+class PerfCounters {
+public:
+    typedef AP_HAL::Util::perf_counter_t perf_counter_t;
+    typedef AP_HAL::Util::perf_counter_type perf_counter_type;
+
+    static perf_counter_t alloc(perf_counter_type type, const char *name);
+    static void begin(perf_counter_t perf);
+    static void end(perf_counter_t perf);
+    static void count(perf_counter_t perf);
+
+    static bool get_info(uint16_t idx, AP_HAL::Util::perf_info &info);
+
+    /*
+      install the SIGUSR1 handler. If exit_file is not NULL the
+      counters are written to it when the process exits, as JSON if
+      the name ends in .json and as CSV otherwise. SIGINT and SIGTERM
+      then cause a clean exit so the file gets written
+     */
+    static void init(const char *exit_file);
+
+    /*
+      make SIGINT and SIGTERM request a clean exit, so that atexit()
+      handlers get to run. The HAL's main loop checks
+      exit_requested() and calls exit() from the main thread. A
+      second signal kills the process straight away, in case the main
+      loop isn't running
+     */
+    static void exit_on_signal(void);
+    static bool exit_requested(void) { return _exit_requested; }
+
+    // act on signals received. Called regularly from the IO thread
+    static void poll(void);
+
+    // print all counters as a table
+    static void print(FILE *f);
+
+    // write all counters to a file, returning false on error
+    static bool write_file(const char *path);
+
+private:
+    struct counter;
+
+    static void _update_stats(struct counter *c, uint64_t sample_ns);
+    static void _at_exit(void);
+    static void _signal_handler(int signum);
+
+    static struct counter *_head;
+    static struct counter *_tail;
+    static const char *_exit_file;
+    static volatile sig_atomic_t _dump_requested;
+    static volatile sig_atomic_t _exit_requested;
+};
+
+#endif // CONFIG_HAL_BOARD
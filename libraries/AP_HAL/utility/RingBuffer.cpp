@@ -8,9 +8,7 @@
 
 ByteBuffer::ByteBuffer(uint32_t _size)
 {
-    size = _size;
-    buf = new uint8_t[size];
-    head = tail = 0;
+    set_size(_size);
 }
 
 ByteBuffer::~ByteBuffer(void)
@@ -18,52 +16,109 @@ ByteBuffer::~ByteBuffer(void)
     delete [] buf;
 }
 
+/*
+  reallocate the buffer, discarding any contents
+ */
+bool ByteBuffer::set_size(uint32_t _size)
+{
+    head = tail = 0;
+    if (_size == size && buf != nullptr) {
+        return true;
+    }
+    delete [] buf;
+    buf = nullptr;
+    size = 0;
+    if (_size == 0) {
+        return true;
+    }
+    buf = new uint8_t[_size];
+    if (buf == nullptr) {
+        return false;
+    }
+    size = _size;
+    return true;
+}
+
 uint32_t ByteBuffer::available(void) const
 {
-    uint32_t _tail;
-    return ((head > (_tail=tail))? (size - head) + _tail: _tail - head);
+    uint32_t _head = load_acquire(head);
+    uint32_t _tail = load_acquire(tail);
+    return ((_head > _tail)? (size - _head) + _tail: _tail - _head);
 }
 
 uint32_t ByteBuffer::space(void) const
 {
-    uint32_t _head;
-    return (((_head=head) > tail)?(_head - tail) - 1:((size - tail) + _head) - 1);
+    if (size == 0) {
+        return 0;
+    }
+    uint32_t _head = load_acquire(head);
+    uint32_t _tail = load_acquire(tail);
+    return ((_head > _tail)?(_head - _tail) - 1:((size - _tail) + _head) - 1);
 }
 
 bool ByteBuffer::empty(void) const
 {
-    return head == tail;
+    return load_acquire(head) == load_acquire(tail);
+}
+
+/*
+  discard all available data. This moves head, so must be called from
+  the consumer side
+ */
+void ByteBuffer::clear(void)
+{
+    store_release(head, load_acquire(tail));
 }
 
 uint32_t ByteBuffer::write(const uint8_t *data, uint32_t len)
 {
-    if (len > space()) {
-        len = space();
+    uint32_t written = 0;
+
+    // at most two passes, one up to the end of the buffer and one
+    // from the start
+    while (written < len) {
+        uint32_t n;
+        uint8_t *b = reserve(n);
+        if (b == nullptr) {
+            break;
+        }
+        if (n > len - written) {
+            n = len - written;
+        }
+        memcpy(b, &data[written], n);
+        commit(n);
+        written += n;
     }
-    if (len == 0) {
-        return 0;
+    return written;
+}
+
+/*
+  return a pointer to contiguous free space
+ */
+uint8_t *ByteBuffer::reserve(uint32_t &space_bytes)
+{
+    space_bytes = space();
+    if (space_bytes == 0) {
+        return nullptr;
     }
-    if (tail+len <= size) {
-        // perform as single memcpy
-        memcpy(&buf[tail], data, len);
-        tail = (tail + len) % size;
-        return len;
+    if (tail+space_bytes > size) {
+        space_bytes = size - tail;
     }
+    return &buf[tail];
+}
 
-    // perform as two memcpy calls
-    uint32_t n = size - tail;
-    if (n > len) {
-        n = len;
+/*
+  publish n bytes written to the space returned by reserve()
+ */
+bool ByteBuffer::commit(uint32_t n)
+{
+    if (n > space()) {
+        return false;
     }
-    memcpy(&buf[tail], data, n);
-    tail = (tail + n) % size;
-    data += n;
-    n = len - n;
-    if (n > 0) {
-        memcpy(&buf[tail], data, n);
-        tail = (tail + n) % size;
+    if (n != 0) {
+        store_release(tail, (tail + n) % size);
     }
-    return len;
+    return true;
 }
 
 bool ByteBuffer::advance(uint32_t n)
@@ -71,38 +126,43 @@ bool ByteBuffer::advance(uint32_t n)
     if (n > available()) {
         return false;
     }
-    head = (head + n) % size;
+    if (n != 0) {
+        store_release(head, (head + n) % size);
+    }
     return true;
 }
 
 uint32_t ByteBuffer::read(uint8_t *data, uint32_t len)
 {
-    if (len > available()) {
-        len = available();
+    len = peekbytes(data, len);
+    advance(len);
+    return len;
+}
+
+/*
+  copy up to len bytes from the start of the buffer without consuming
+  them
+ */
+uint32_t ByteBuffer::peekbytes(uint8_t *data, uint32_t len)
+{
+    uint32_t avail = available();
+    if (len > avail) {
+        len = avail;
     }
     if (len == 0) {
         return 0;
     }
-    uint32_t n;
-    const uint8_t *b = readptr(n);
+
+    // perform first memcpy, up to the end of the buffer
+    uint32_t n = size - head;
     if (n > len) {
         n = len;
     }
-
-    // perform first memcpy
-    memcpy(data, b, n);
-    advance(n);
-    data += n;
+    memcpy(data, &buf[head], n);
 
     if (len > n) {
-        // possible second memcpy
-        uint32_t n2;
-        b = readptr(n2);
-        if (n2 > len-n) {
-            n2 = len-n;
-        }
-        memcpy(data, b, n2);
-        advance(n2);
+        // possible second memcpy, from the start of the buffer
+        memcpy(&data[n], buf, len - n);
     }
     return len;
 }
@@ -25,30 +25,70 @@
 
 /*
   new style buffers
+
+  A ByteBuffer is safe for use by one producer thread (write(),
+  reserve() and commit()) and one consumer thread (read(), readptr()
+  and advance()) without locking. The producer only moves tail and the
+  consumer only moves head, and both are published with release
+  semantics and loaded with acquire semantics, so the bytes between
+  them are always visible to the thread that reads them.
  */
 class ByteBuffer {
 public:
     ByteBuffer(uint32_t size);
     ~ByteBuffer(void);
-    
+
+    // number of bytes available to be read
     uint32_t available(void) const;
+
+    // number of bytes that can be written
     uint32_t space(void) const;
+
     bool empty(void) const;
     uint32_t write(const uint8_t *data, uint32_t len);
     uint32_t read(uint8_t *data, uint32_t len);
     uint32_t get_size(void) const { return size; }
+
+    // change the size of the buffer, discarding its contents. Returns
+    // false if the allocation fails, in which case the buffer has zero
+    // size. Must not be called while another thread uses the buffer
+    bool set_size(uint32_t size);
+
+    // consumer side: discard the contents of the buffer. A producer
+    // that needs the buffer emptied must ask the consumer to do it
+    void clear(void);
+
+    // consumer side: return a pointer to contiguous readable data and
+    // mark n bytes of it as consumed
     bool advance(uint32_t n);
     const uint8_t *readptr(uint32_t &available_bytes);
     int16_t peek(uint32_t ofs) const;
-    
+    uint32_t peekbytes(uint8_t *data, uint32_t len);
+
+    /*
+      producer side: return a pointer to contiguous free space, which
+      can be filled in place (for example by ::read()) and then made
+      available to the consumer with commit(). Returns nullptr if the
+      buffer is full
+     */
+    uint8_t *reserve(uint32_t &space_bytes);
+    bool commit(uint32_t n);
+
 private:
     uint8_t *buf = nullptr;
     uint32_t size = 0;
 
     // head is where the next available data is. tail is where new
     // data is written
-    volatile uint32_t head = 0;
-    volatile uint32_t tail = 0;
+    uint32_t head = 0;
+    uint32_t tail = 0;
+
+    static uint32_t load_acquire(const uint32_t &v) {
+        return __atomic_load_n(&v, __ATOMIC_ACQUIRE);
+    }
+    static void store_release(uint32_t &v, uint32_t value) {
+        __atomic_store_n(&v, value, __ATOMIC_RELEASE);
+    }
 };
 
 /*
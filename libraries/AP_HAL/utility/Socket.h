@@ -63,6 +63,9 @@ public:
     // listen has been used. A new socket is returned
     SocketAPM *accept(uint32_t timeout_ms);
 
+    // return the underlying file descriptor, for use with poll/epoll
+    int get_fd(void) const { return fd; }
+
 private:
     bool datagram;
     struct sockaddr_in in_addr {};
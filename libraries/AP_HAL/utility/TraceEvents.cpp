@@ -0,0 +1,199 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  per-thread rings of trace events, written as Chrome trace-event JSON
+ */
+
+#include "TraceEvents.h"
+
+#if HAL_TRACE_EVENTS_ENABLED
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "PerfCounters.h"
+
+static_assert((TRACE_EVENTS_RING_SIZE & (TRACE_EVENTS_RING_SIZE - 1)) == 0,
+              "TRACE_EVENTS_RING_SIZE must be a power of 2");
+
+struct TraceEvents::ring {
+    struct ring *next;
+    pid_t tid;
+    // number of events ever recorded. Only the owning thread writes
+    // it, publishing each event with a release store
+    uint32_t head;
+    struct event {
+        uint64_t time_ns;
+        const char *name;
+        char phase;
+    } events[TRACE_EVENTS_RING_SIZE];
+};
+
+bool TraceEvents::_enabled;
+TraceEvents::ring *TraceEvents::_head;
+// the ring of the calling thread
+__thread TraceEvents::ring *TraceEvents::_thread_ring;
+const char *TraceEvents::_file;
+volatile sig_atomic_t TraceEvents::_write_requested;
+
+static inline uint64_t now_nsec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_nsec + (ts.tv_sec * 1000000000ULL);
+}
+
+TraceEvents::ring *TraceEvents::_new_ring(void)
+{
+    struct ring *r = (struct ring *)calloc(1, sizeof(struct ring));
+    if (r == NULL) {
+        return NULL;
+    }
+    r->tid = syscall(SYS_gettid);
+
+    // push onto the registry. Rings are never freed, so readers can
+    // walk the list without a lock
+    struct ring *head = __atomic_load_n(&_head, __ATOMIC_RELAXED);
+    do {
+        r->next = head;
+    } while (!__atomic_compare_exchange_n(&_head, &head, r, true,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    return r;
+}
+
+void TraceEvents::_record(const char *name, char phase)
+{
+    struct ring *r = _thread_ring;
+    if (r == NULL) {
+        r = _thread_ring = _new_ring();
+        if (r == NULL) {
+            return;
+        }
+    }
+    const uint32_t head = r->head;
+    struct ring::event &e = r->events[head & (TRACE_EVENTS_RING_SIZE - 1)];
+    e.time_ns = now_nsec();
+    e.name = name;
+    e.phase = phase;
+    __atomic_store_n(&r->head, head + 1, __ATOMIC_RELEASE);
+}
+
+/*
+  the name the kernel has for a thread, with anything that would need
+  escaping in JSON replaced
+ */
+static void thread_name(pid_t tid, char *name, size_t size)
+{
+    char path[40];
+    snprintf(path, sizeof(path), "/proc/self/task/%d/comm", (int)tid);
+    FILE *f = fopen(path, "r");
+    if (f == NULL || fgets(name, size, f) == NULL) {
+        snprintf(name, size, "thread %d", (int)tid);
+    }
+    if (f != NULL) {
+        fclose(f);
+    }
+    for (char *p = name; *p; p++) {
+        if (*p == '\n') {
+            *p = 0;
+            break;
+        }
+        if (*p == '"' || *p == '\\' || *p < ' ') {
+            *p = '_';
+        }
+    }
+}
+
+/*
+  write the rings while they may still be recorded into. Events
+  overwritten while they were being written are dropped, so each
+  thread's events are consistent although they may be cut short
+ */
+bool TraceEvents::write_file(const char *path)
+{
+    FILE *f = fopen(path, "w");
+    if (f == NULL) {
+        return false;
+    }
+    const int pid = getpid();
+    bool first = true;
+
+    fprintf(f, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+    for (struct ring *r = __atomic_load_n(&_head, __ATOMIC_ACQUIRE); r != NULL; r = r->next) {
+        char name[32];
+        thread_name(r->tid, name, sizeof(name));
+        fprintf(f, "%s\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %d, \"tid\": %d, \"args\": {\"name\": \"%s\"}}",
+                first?"":",", pid, (int)r->tid, name);
+        first = false;
+
+        const uint32_t head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+        uint32_t start = head > TRACE_EVENTS_RING_SIZE ? head - TRACE_EVENTS_RING_SIZE : 0;
+        for (uint32_t i = start; i != head; i++) {
+            const struct ring::event e = r->events[i & (TRACE_EVENTS_RING_SIZE - 1)];
+            // stop if the writer has lapped us
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            const uint32_t now_head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+            if (now_head - i > TRACE_EVENTS_RING_SIZE) {
+                break;
+            }
+            fprintf(f, ",\n{\"name\": \"%s\", \"ph\": \"%c\", \"ts\": %.3f, \"pid\": %d, \"tid\": %d%s}",
+                    e.name, e.phase, e.time_ns * 1.0e-3, pid, (int)r->tid,
+                    e.phase == 'i' ? ", \"s\": \"t\"" : "");
+        }
+    }
+    fprintf(f, "\n]}\n");
+    return fclose(f) == 0;
+}
+
+void TraceEvents::_at_exit(void)
+{
+    _enabled = false;
+    if (!write_file(_file)) {
+        fprintf(stderr, "Failed to write trace events to %s\n", _file);
+    }
+}
+
+void TraceEvents::_signal_handler(int signum)
+{
+    _write_requested = 1;
+}
+
+void TraceEvents::init(const char *file)
+{
+    if (file == NULL) {
+        return;
+    }
+    _file = file;
+    atexit(_at_exit);
+    signal(SIGUSR2, _signal_handler);
+    PerfCounters::exit_on_signal();
+    _enabled = true;
+}
+
+void TraceEvents::poll(void)
+{
+    if (_write_requested) {
+        _write_requested = 0;
+        if (!write_file(_file)) {
+            fprintf(stderr, "Failed to write trace events to %s\n", _file);
+        }
+    }
+}
+
+#endif // HAL_TRACE_EVENTS_ENABLED
@@ -0,0 +1,102 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  a timeline of what each thread was doing, for the Linux and SITL
+  HALs. Use the TRACE_*() macros, which compile to nothing on other
+  boards
+ */
+#pragma once
+
+#include <AP_HAL/AP_HAL.h>
+
+#ifndef HAL_TRACE_EVENTS_ENABLED
+#define HAL_TRACE_EVENTS_ENABLED (CONFIG_HAL_BOARD == HAL_BOARD_LINUX || CONFIG_HAL_BOARD == HAL_BOARD_SITL)
+#endif
+
+#if HAL_TRACE_EVENTS_ENABLED
+
+#include <signal.h>
+
+// events kept per thread. At 400Hz the main thread records a few
+// thousand events a second, so this holds several seconds of flight
+#ifndef TRACE_EVENTS_RING_SIZE
+#define TRACE_EVENTS_RING_SIZE 65536
+#endif
+
+/*
+  Each thread records into its own ring, allocated on its first event,
+  so recording takes no locks. Only the newest TRACE_EVENTS_RING_SIZE
+  events of each thread are kept.
+
+  Nothing is recorded until init() is called with a file name. The
+  rings are written to that file in Chrome trace-event JSON, which
+  chrome://tracing and other timeline viewers load, when the process
+  exits and on SIGUSR2.
+
+  Event names must be string constants, as only the pointer is kept.
+ */
+class TraceEvents {
+public:
+    static void begin(const char *name) {
+        if (_enabled) {
+            _record(name, 'B');
+        }
+    }
+    static void end(const char *name) {
+        if (_enabled) {
+            _record(name, 'E');
+        }
+    }
+    static void instant(const char *name) {
+        if (_enabled) {
+            _record(name, 'i');
+        }
+    }
+
+    // start recording, to be written to file
+    static void init(const char *file);
+
+    // act on signals received. Called regularly from the IO thread
+    static void poll(void);
+
+    // write all rings to a file, returning false on error
+    static bool write_file(const char *path);
+
+private:
+    struct ring;
+
+    static void _record(const char *name, char phase);
+    static struct ring *_new_ring(void);
+    static void _at_exit(void);
+    static void _signal_handler(int signum);
+
+    static bool _enabled;
+    static struct ring *_head;
+    static __thread struct ring *_thread_ring;
+    static const char *_file;
+    static volatile sig_atomic_t _write_requested;
+};
+
+#define TRACE_BEGIN(name)   TraceEvents::begin(name)
+#define TRACE_END(name)     TraceEvents::end(name)
+#define TRACE_INSTANT(name) TraceEvents::instant(name)
+
+#else
+
+#define TRACE_BEGIN(name)
+#define TRACE_END(name)
+#define TRACE_INSTANT(name)
+
+#endif // HAL_TRACE_EVENTS_ENABLED
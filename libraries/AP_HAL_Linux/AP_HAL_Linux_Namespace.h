@@ -17,6 +17,7 @@ namespace Linux {
     class GPIO_Sysfs;
     class Storage;
     class Storage_FRAM;
+    class Storage_Journal;
     class DigitalSource;
     class DigitalSource_Sysfs;
     class PWM_Sysfs;
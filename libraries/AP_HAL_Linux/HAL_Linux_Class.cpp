@@ -7,6 +7,7 @@
 #include "AP_HAL_Linux_Private.h"
 
 #include <AP_HAL/utility/getopt_cpp.h>
+#include <AP_HAL/utility/PerfCounters.h>
 #include <stdio.h>
 #include <unistd.h>
 #include <stdlib.h>
@@ -85,10 +86,12 @@ static AnalogIn analogIn;
 #endif
 
 /*
-  select between FRAM and FS
+  select between FRAM, journalled FS and FS
  */
 #if LINUX_STORAGE_USE_FRAM == 1
 static Storage_FRAM storageDriver;
+#elif LINUX_STORAGE_USE_JOURNAL == 1
+static Storage_Journal storageDriver;
 #else
 static Storage storageDriver;
 #endif
@@ -223,6 +226,15 @@ void _usage(void)
     printf("\t-custom terrain path:\n");
     printf("\t                   --terrain-directory /var/APM/terrain\n");
     printf("\t                   -t /var/APM/terrain\n");
+    printf("\t-worker threads for thread-safe tasks:\n");
+    printf("\t                   --workers 3\n");
+    printf("\t                   -w 3\n");
+    printf("\t-write perf counters on exit (CSV, or JSON if named *.json):\n");
+    printf("\t                   --perf-file /var/APM/perf.csv\n");
+    printf("\t                   -p /var/APM/perf.csv\n");
+    printf("\t-record a timeline of the threads, written on exit and on SIGUSR2:\n");
+    printf("\t                   --trace-file /var/APM/trace.json\n");
+    printf("\t                   -T /var/APM/trace.json\n");
 }
 
 void HAL_Linux::run(int argc, char* const argv[], Callbacks* callbacks) const
@@ -242,11 +254,14 @@ void HAL_Linux::run(int argc, char* const argv[], Callbacks* callbacks) const
 #endif
         {"log-directory",       true,  0, 'l'},
         {"terrain-directory",   true,  0, 't'},
+        {"workers",             true,  0, 'w'},
+        {"perf-file",           true,  0, 'p'},
+        {"trace-file",          true,  0, 'T'},
         {"help",                false,  0, 'h'},
         {0, false, 0, 0}
     };
 
-    GetOptLong gopt(argc, argv, "A:B:C:D:E:l:t:he:S",
+    GetOptLong gopt(argc, argv, "A:B:C:D:E:l:t:w:p:T:he:S",
                     options);
 
     /*
@@ -283,6 +298,15 @@ void HAL_Linux::run(int argc, char* const argv[], Callbacks* callbacks) const
         case 't':
             utilInstance.set_custom_terrain_directory(gopt.optarg);
             break;
+        case 'w':
+            schedulerInstance.set_num_workers(atoi(gopt.optarg));
+            break;
+        case 'p':
+            utilInstance.set_perf_file(gopt.optarg);
+            break;
+        case 'T':
+            utilInstance.set_trace_file(gopt.optarg);
+            break;
         case 'h':
             _usage();
             exit(0);
@@ -320,6 +344,12 @@ void HAL_Linux::run(int argc, char* const argv[], Callbacks* callbacks) const
 
     for (;;) {
         callbacks->loop();
+
+        // exit here rather than from the signal handler or the IO
+        // thread, so the atexit() handlers run on the main thread
+        if (PerfCounters::exit_requested()) {
+            exit(0);
+        }
     }
 }
 
@@ -28,6 +28,8 @@ class Linux::RCOutput_AioPRU : public AP_HAL::RCOutput {
     void     write(uint8_t ch, uint16_t period_us);
     uint16_t read(uint8_t ch);
     void     read(uint16_t* period_us, uint8_t len);
+    void     cork();
+    void     push();
 
 private:
    static const uint32_t TICK_PER_US = 200;
@@ -42,6 +44,11 @@ private:
     };
 
     volatile struct pwm *pwm;
+
+   // values written since cork(), sent together by push()
+   uint16_t _pending[PWM_CHAN_COUNT];
+   uint32_t _pending_write_mask = 0;
+   bool _corking = false;
 };
 
 #endif // __AP_HAL_LINUX_RCOUTPUT_AIOPRU_H__
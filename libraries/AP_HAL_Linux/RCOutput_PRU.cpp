@@ -71,9 +71,37 @@ void RCOutput_PRU::disable_ch(uint8_t ch)
 
 void RCOutput_PRU::write(uint8_t ch, uint16_t period_us)
 {
+    if (ch >= PWM_CHAN_COUNT) {
+        return;
+    }
+    if (_corking) {
+        _pending[ch] = period_us;
+        _pending_write_mask |= (1U << ch);
+        return;
+    }
     sharedMem_cmd->periodhi[chan_pru_map[ch]][1] = TICK_PER_US*period_us;
 }
 
+void RCOutput_PRU::cork()
+{
+    _corking = true;
+}
+
+/*
+  write all the corked channels back to back, so that the PWM
+  hardware picks them up in the same cycle
+ */
+void RCOutput_PRU::push()
+{
+    _corking = false;
+    for (uint8_t ch = 0; ch < PWM_CHAN_COUNT; ch++) {
+        if (_pending_write_mask & (1U << ch)) {
+            write(ch, _pending[ch]);
+        }
+    }
+    _pending_write_mask = 0;
+}
+
 uint16_t RCOutput_PRU::read(uint8_t ch)
 {
     return (sharedMem_cmd->hilo_read[chan_pru_map[ch]][1]/TICK_PER_US);
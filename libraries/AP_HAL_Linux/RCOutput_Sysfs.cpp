@@ -31,6 +31,7 @@ RCOutput_Sysfs::RCOutput_Sysfs(uint8_t chip, uint8_t channel_count)
     : _chip(chip)
     , _channel_count(channel_count)
     , _pwm_channels(new PWM_Sysfs *[_channel_count])
+    , _pending(new uint16_t[_channel_count])
 {
 }
 
@@ -41,6 +42,7 @@ RCOutput_Sysfs::~RCOutput_Sysfs()
     }
 
     delete _pwm_channels;
+    delete[] _pending;
 }
 
 void RCOutput_Sysfs::init()
@@ -101,7 +103,39 @@ void RCOutput_Sysfs::write(uint8_t ch, uint16_t period_us)
         return;
     }
 
-    _pwm_channels[ch]->set_duty_cycle(usec_to_nsec(period_us));
+    _pending[ch] = period_us;
+    _pending_write_mask |= (1U << ch);
+
+    if (!_corking) {
+        push();
+    }
+}
+
+void RCOutput_Sysfs::cork()
+{
+    _corking = true;
+}
+
+/*
+  each channel is a separate sysfs file, so a write per channel can't
+  be avoided. Skip the ones whose duty cycle hasn't changed, which on
+  a copter at steady throttle or disarmed is most of them
+ */
+void RCOutput_Sysfs::push()
+{
+    _corking = false;
+
+    for (uint8_t i = 0; i < _channel_count; i++) {
+        if (!(_pending_write_mask & (1U << i))) {
+            continue;
+        }
+        const uint32_t duty_cycle = usec_to_nsec(_pending[i]);
+        if (duty_cycle != _pwm_channels[i]->get_duty_cycle()) {
+            _pwm_channels[i]->set_duty_cycle(duty_cycle);
+        }
+    }
+
+    _pending_write_mask = 0;
 }
 
 uint16_t RCOutput_Sysfs::read(uint8_t ch)
@@ -21,9 +21,16 @@ public:
     void write(uint8_t ch, uint16_t period_us);
     uint16_t read(uint8_t ch);
     void read(uint16_t *period_us, uint8_t len);
+    void cork() override;
+    void push() override;
 
 private:
     const uint8_t _chip;
     const uint8_t _channel_count;
     PWM_Sysfs **_pwm_channels;
+
+    // values written since cork(), sent by push()
+    uint16_t *_pending;
+    uint32_t _pending_write_mask = 0;
+    bool _corking = false;
 };
@@ -67,9 +67,37 @@ void RCOutput_ZYNQ::disable_ch(uint8_t ch)
 
 void RCOutput_ZYNQ::write(uint8_t ch, uint16_t period_us)
 {
+    if (ch >= PWM_CHAN_COUNT) {
+        return;
+    }
+    if (_corking) {
+        _pending[ch] = period_us;
+        _pending_write_mask |= (1U << ch);
+        return;
+    }
     sharedMem_cmd->periodhi[ch].hi = TICK_PER_US*period_us;
 }
 
+void RCOutput_ZYNQ::cork()
+{
+    _corking = true;
+}
+
+/*
+  write all the corked channels back to back, so that the PWM
+  hardware picks them up in the same cycle
+ */
+void RCOutput_ZYNQ::push()
+{
+    _corking = false;
+    for (uint8_t ch = 0; ch < PWM_CHAN_COUNT; ch++) {
+        if (_pending_write_mask & (1U << ch)) {
+            write(ch, _pending[ch]);
+        }
+    }
+    _pending_write_mask = 0;
+}
+
 uint16_t RCOutput_ZYNQ::read(uint8_t ch)
 {
     return (sharedMem_cmd->periodhi[ch].hi/TICK_PER_US);
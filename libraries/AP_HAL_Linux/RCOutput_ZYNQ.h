@@ -23,6 +23,8 @@ class Linux::RCOutput_ZYNQ : public AP_HAL::RCOutput {
     void     write(uint8_t ch, uint16_t period_us);
     uint16_t read(uint8_t ch);
     void     read(uint16_t* period_us, uint8_t len);
+    void     cork();
+    void     push();
 
 private:
     static const int TICK_PER_US=100;
@@ -37,6 +39,11 @@ private:
         struct s_period_hi periodhi[MAX_ZYNQ_PWMS];
     };
     volatile struct pwm_cmd *sharedMem_cmd;
+
+    // values written since cork(), sent together by push()
+    uint16_t _pending[MAX_ZYNQ_PWMS];
+    uint32_t _pending_write_mask = 0;
+    bool _corking = false;
 };
 
 #endif // __AP_HAL_LINUX_RCOUTPUT_ZYNQ_H__
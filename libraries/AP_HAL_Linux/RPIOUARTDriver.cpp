@@ -38,8 +38,6 @@ RPIOUARTDriver::RPIOUARTDriver() :
     _need_set_baud(false),
     _baudrate(0)
 {
-    _readbuf = NULL;
-    _writebuf = NULL;
 }
 
 bool RPIOUARTDriver::sem_take_nonblocking()
@@ -82,27 +80,15 @@ void RPIOUARTDriver::begin(uint32_t b, uint16_t rxS, uint16_t txS)
    /*
      allocate the read buffer
    */
-   if (rxS != 0 && rxS != _readbuf_size) {
-       _readbuf_size = rxS;
-       if (_readbuf != NULL) {
-           free(_readbuf);
-       }
-       _readbuf = (uint8_t *)malloc(_readbuf_size);
-       _readbuf_head = 0;
-       _readbuf_tail = 0;
+   if (rxS != 0 && rxS != _readbuf.get_size()) {
+       _readbuf.set_size(rxS);
    }
 
    /*
      allocate the write buffer
    */
-   if (txS != 0 && txS != _writebuf_size) {
-       _writebuf_size = txS;
-       if (_writebuf != NULL) {
-           free(_writebuf);
-       }
-       _writebuf = (uint8_t *)malloc(_writebuf_size);
-       _writebuf_head = 0;
-       _writebuf_tail = 0;
+   if (txS != 0 && txS != _writebuf.get_size()) {
+       _writebuf.set_size(txS);
    }
 
    _spi = hal.spi->device(AP_HAL::SPIDevice_RASPIO);
@@ -126,7 +112,7 @@ void RPIOUARTDriver::begin(uint32_t b, uint16_t rxS, uint16_t txS)
         hal.scheduler->delay(1);
     }
 
-    if (_writebuf_size != 0 && _readbuf_size != 0) {
+    if (_writebuf.get_size() != 0 && _readbuf.get_size() != 0) {
         _initialised = true;
     }
 
@@ -204,8 +190,7 @@ void RPIOUARTDriver::_timer_tick(void)
     struct IOPacket _dma_packet_tx, _dma_packet_rx;
     
     /* get write_buf bytes */
-    uint16_t _tail;
-    uint16_t n = BUF_AVAILABLE(_writebuf);
+    uint32_t n = _writebuf.available();
     
     if (n > PKT_MAX_REGS * 2) {
         n = PKT_MAX_REGS * 2;
@@ -217,17 +202,7 @@ void RPIOUARTDriver::_timer_tick(void)
     }
     
     if (n > 0) {
-        uint16_t n1 = _writebuf_size - _writebuf_head;
-        if (n1 >= n) {
-            // do as a single write
-            memcpy( &((uint8_t *)_dma_packet_tx.regs)[0], &_writebuf[_writebuf_head], n );
-        } else {
-            // split into two writes
-            memcpy( &((uint8_t *)_dma_packet_tx.regs)[0], &_writebuf[_writebuf_head], n1 );
-            memcpy( &((uint8_t *)_dma_packet_tx.regs)[n1], &_writebuf[0], n-n1 );
-        }
-        
-        BUF_ADVANCEHEAD(_writebuf, n);
+        _writebuf.read((uint8_t *)_dma_packet_tx.regs, n);
     }
     
     _dma_packet_tx.count_code = PKT_MAX_REGS | PKT_CODE_SPIUART;
@@ -257,30 +232,16 @@ void RPIOUARTDriver::_timer_tick(void)
     _spi_sem->give();
     
     /* add bytes to read buf */
-    uint16_t _head;
-    n = BUF_SPACE(_readbuf);
-    
     if (_dma_packet_rx.page == PX4IO_PAGE_UART_BUFFER) {
         
-        if (n > _dma_packet_rx.offset) {
-            n = _dma_packet_rx.offset;
-        }
+        n = _dma_packet_rx.offset;
         
         if (n > PKT_MAX_REGS * 2) {
             n = PKT_MAX_REGS * 2;
         }
         
         if (n > 0) {
-            uint16_t n1 = _readbuf_size - _readbuf_tail;
-            if (n1 >= n) {
-                // one read will do
-                memcpy( &_readbuf[_readbuf_tail], &((uint8_t *)_dma_packet_rx.regs)[0], n );
-            } else {
-                memcpy( &_readbuf[_readbuf_tail], &((uint8_t *)_dma_packet_rx.regs)[0], n1 );
-                memcpy( &_readbuf[0], &((uint8_t *)_dma_packet_rx.regs)[n1], n-n1 );
-            }
-            
-            BUF_ADVANCETAIL(_readbuf, n);
+            _readbuf.write((uint8_t *)_dma_packet_rx.regs, n);
         }
         
     }
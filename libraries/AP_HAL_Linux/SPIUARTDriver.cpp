@@ -31,8 +31,6 @@ SPIUARTDriver::SPIUARTDriver() :
     _buffer(NULL),
     _external(false)
 {
-    _readbuf = NULL;
-    _writebuf = NULL;
 }
 
 bool SPIUARTDriver::sem_take_nonblocking()
@@ -65,27 +63,15 @@ void SPIUARTDriver::begin(uint32_t b, uint16_t rxS, uint16_t txS)
    /*
      allocate the read buffer
    */
-   if (rxS != 0 && rxS != _readbuf_size) {
-       _readbuf_size = rxS;
-       if (_readbuf != NULL) {
-           free(_readbuf);
-       }
-       _readbuf = (uint8_t *)malloc(_readbuf_size);
-       _readbuf_head = 0;
-       _readbuf_tail = 0;
+   if (rxS != 0 && rxS != _readbuf.get_size()) {
+       _readbuf.set_size(rxS);
    }
 
    /*
      allocate the write buffer
    */
-   if (txS != 0 && txS != _writebuf_size) {
-       _writebuf_size = txS;
-       if (_writebuf != NULL) {
-           free(_writebuf);
-       }
-       _writebuf = (uint8_t *)malloc(_writebuf_size);
-       _writebuf_head = 0;
-       _writebuf_tail = 0;
+   if (txS != 0 && txS != _writebuf.get_size()) {
+       _writebuf.set_size(txS);
    }
 
    if (_buffer == NULL) {
@@ -143,54 +129,14 @@ int SPIUARTDriver::_write_fd(const uint8_t *buf, uint16_t size)
 
     sem_give();
 
-    BUF_ADVANCEHEAD(_writebuf, size);
-
-    uint16_t ret = size;
+    _writebuf.advance(size);
 
     /* Since all SPI-transactions are transfers we need update
-     * the _readbuf. I do believe there is a way to encapsulate 
-     * this operation since it's the same as in the
-     * UARTDriver::write().  
+     * the _readbuf.
      */
+    _readbuf.write(_buffer, size);
 
-    uint8_t *buffer = _buffer;
-
-    uint16_t _head, space;
-    space = BUF_SPACE(_readbuf);
-
-    if (space == 0) {
-        return ret;
-    }
-
-    if (size > space) {
-        size = space;
-    }
-
-    if (_readbuf_tail < _head) {
-        // perform as single memcpy
-        assert(_readbuf_tail+size <= _readbuf_size);
-        memcpy(&_readbuf[_readbuf_tail], buffer, size);
-        BUF_ADVANCETAIL(_readbuf, size);
-        return ret;
-    }
-
-    // perform as two memcpy calls
-    uint16_t n = _readbuf_size - _readbuf_tail;
-    if (n > size) n = size;
-    assert(_readbuf_tail+n <= _readbuf_size);
-    memcpy(&_readbuf[_readbuf_tail], buffer, n);
-    BUF_ADVANCETAIL(_readbuf, n);
-    buffer += n;
-    n = size - n;
-    if (n > 0) {
-        assert(_readbuf_tail+n <= _readbuf_size);
-        memcpy(&_readbuf[_readbuf_tail], buffer, n);
-        BUF_ADVANCETAIL(_readbuf, n);
-    }
-
-
-    return ret;
-    
+    return size;
 }
 
 static const uint8_t ff_stub[300] = {0xff};
@@ -218,7 +164,7 @@ int SPIUARTDriver::_read_fd(uint8_t *buf, uint16_t n)
 
     sem_give();
 
-    BUF_ADVANCETAIL(_readbuf, n);
+    _readbuf.commit(n);
 
     return n;
 }
@@ -15,6 +15,7 @@
 #include <stdio.h>
 #include <errno.h>
 #include <sys/mman.h>
+#include <sys/epoll.h>
 
 #if CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_QFLIGHT
 #include <rpcmem.h>
@@ -34,6 +35,7 @@ extern const AP_HAL::HAL& hal;
 #define APM_LINUX_MAIN_PRIORITY         12
 #define APM_LINUX_TONEALARM_PRIORITY    11
 #define APM_LINUX_IO_PRIORITY           10
+#define APM_LINUX_WORKER_PRIORITY       9
 
 #if CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_NAVIO ||    \
     CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_ERLEBRAIN2 || \
@@ -53,11 +55,15 @@ extern const AP_HAL::HAL& hal;
 
 
 Scheduler::Scheduler()
-{}
+{
+    pthread_mutex_init(&_worker_mutex, NULL);
+    pthread_cond_init(&_worker_cond, NULL);
+}
 
 void Scheduler::_create_realtime_thread(pthread_t *ctx, int rtprio,
                                              const char *name,
-                                             pthread_startroutine_t start_routine)
+                                             pthread_startroutine_t start_routine,
+                                             const cpu_set_t *cpus)
 {
     struct sched_param param = { .sched_priority = rtprio };
     pthread_attr_t attr;
@@ -74,6 +80,9 @@ void Scheduler::_create_realtime_thread(pthread_t *ctx, int rtprio,
         pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
         pthread_attr_setschedparam(&attr, &param);
     }
+    if (cpus != NULL) {
+        pthread_attr_setaffinity_np(&attr, sizeof(*cpus), cpus);
+    }
     r = pthread_create(ctx, &attr, start_routine, this);
     if (r != 0) {
         hal.console->printf("Error creating thread '%s': %s\n",
@@ -132,9 +141,137 @@ void Scheduler::init()
         printf("WARNING: running as non-root. Will not use realtime scheduling\n");
     }
 
+    /*
+      with a worker pool the main thread gets CPU 0 to itself and
+      everything else is spread over the remaining CPUs
+     */
+    long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    cpu_set_t other_cpus;
+    const cpu_set_t *thread_cpus = NULL;
+    if (_num_workers > 0 && num_cpus > 1) {
+        cpu_set_t main_cpu;
+        CPU_ZERO(&main_cpu);
+        CPU_SET(0, &main_cpu);
+        sched_setaffinity(0, sizeof(main_cpu), &main_cpu);
+
+        CPU_ZERO(&other_cpus);
+        for (long i = 1; i < num_cpus && i < CPU_SETSIZE; i++) {
+            CPU_SET(i, &other_cpus);
+        }
+        thread_cpus = &other_cpus;
+    } else {
+        _num_workers = 0;
+    }
+
     for (iter = table; iter->ctx; iter++)
         _create_realtime_thread(iter->ctx, iter->rtprio, iter->name,
-                                iter->start_routine);
+                                iter->start_routine, thread_cpus);
+
+    _init_workers();
+}
+
+/*
+  start the worker threads, pinning each to one of the CPUs not used
+  by the main thread
+ */
+void Scheduler::_init_workers(void)
+{
+    if (_num_workers > LINUX_SCHEDULER_MAX_WORKERS) {
+        _num_workers = LINUX_SCHEDULER_MAX_WORKERS;
+    }
+    long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    for (uint8_t i = 0; i < _num_workers; i++) {
+        char name[16];
+        cpu_set_t cpu;
+        CPU_ZERO(&cpu);
+        CPU_SET(1 + (i % (num_cpus - 1)), &cpu);
+        snprintf(name, sizeof(name), "sched-worker%u", (unsigned)i);
+        _create_realtime_thread(&_worker_thread_ctx[i], APM_LINUX_WORKER_PRIORITY,
+                                name, &Linux::Scheduler::_worker_thread, &cpu);
+    }
+}
+
+/*
+  queue a proc to be run by the worker pool. A proc that is already
+  queued or running is not queued again
+ */
+bool Scheduler::run_on_worker(AP_HAL::MemberProc proc, uint32_t *run_time_us)
+{
+    if (_num_workers == 0) {
+        return false;
+    }
+    bool ret = true;
+    pthread_mutex_lock(&_worker_mutex);
+    uint8_t i;
+    for (i = 0; i < _num_worker_procs; i++) {
+        if (_worker_procs[i] == proc) {
+            break;
+        }
+    }
+    if (i == _num_worker_procs) {
+        if (_num_worker_procs < LINUX_SCHEDULER_MAX_WORKER_PROCS) {
+            _worker_procs[_num_worker_procs] = proc;
+            _worker_run_time[_num_worker_procs] = run_time_us;
+            _worker_running[_num_worker_procs] = false;
+            _num_worker_procs++;
+            pthread_cond_signal(&_worker_cond);
+        } else {
+            ret = false;
+        }
+    }
+    pthread_mutex_unlock(&_worker_mutex);
+    return ret;
+}
+
+void *Scheduler::_worker_thread(void *arg)
+{
+    Scheduler* sched = (Scheduler *)arg;
+
+    while (sched->system_initializing()) {
+        poll(NULL, 0, 1);
+    }
+
+    pthread_mutex_lock(&sched->_worker_mutex);
+    while (true) {
+        // find the oldest proc that nobody is running yet
+        uint8_t i;
+        for (i = 0; i < sched->_num_worker_procs; i++) {
+            if (!sched->_worker_running[i]) {
+                break;
+            }
+        }
+        if (i == sched->_num_worker_procs) {
+            pthread_cond_wait(&sched->_worker_cond, &sched->_worker_mutex);
+            continue;
+        }
+        AP_HAL::MemberProc proc = sched->_worker_procs[i];
+        sched->_worker_running[i] = true;
+        pthread_mutex_unlock(&sched->_worker_mutex);
+
+        TRACE_BEGIN("worker");
+        uint32_t proc_started = AP_HAL::micros();
+        proc();
+        uint32_t run_time = AP_HAL::micros() - proc_started;
+        TRACE_END("worker");
+
+        pthread_mutex_lock(&sched->_worker_mutex);
+        // other workers may have removed entries, so look it up again
+        for (i = 0; i < sched->_num_worker_procs; i++) {
+            if (sched->_worker_procs[i] == proc) {
+                break;
+            }
+        }
+        if (sched->_worker_run_time[i] != NULL) {
+            __atomic_store_n(sched->_worker_run_time[i], run_time, __ATOMIC_RELEASE);
+        }
+        sched->_num_worker_procs--;
+        for (; i < sched->_num_worker_procs; i++) {
+            sched->_worker_procs[i] = sched->_worker_procs[i+1];
+            sched->_worker_run_time[i] = sched->_worker_run_time[i+1];
+            sched->_worker_running[i] = sched->_worker_running[i+1];
+        }
+    }
+    return NULL;
 }
 
 void Scheduler::_microsleep(uint32_t usec)
@@ -233,6 +370,7 @@ void Scheduler::_run_timers(bool called_from_timer_thread)
         return;
     }
     _in_timer_proc = true;
+    TRACE_BEGIN("timers");
 
     if (!_timer_semaphore.take(0)) {
         printf("Failed to take timer semaphore in _run_timers\n");
@@ -259,6 +397,7 @@ void Scheduler::_run_timers(bool called_from_timer_thread)
         _failsafe();
     }
 
+    TRACE_END("timers");
     _in_timer_proc = false;
 }
 
@@ -310,6 +449,7 @@ void Scheduler::_run_io(void)
     if (!_io_semaphore.take(0)) {
         return;
     }
+    TRACE_BEGIN("io");
 
     // now call the IO based drivers
     for (int i = 0; i < _num_io_procs; i++) {
@@ -318,6 +458,7 @@ void Scheduler::_run_io(void)
         }
     }
 
+    TRACE_END("io");
     _io_semaphore.give();
 }
 
@@ -343,6 +484,7 @@ void *Scheduler::_rcin_thread(void *arg)
  */
 void Scheduler::_run_uarts(void)
 {
+    TRACE_BEGIN("uarts");
     // process any pending serial bytes
     UARTDriver::from(hal.uartA)->_timer_tick();
     UARTDriver::from(hal.uartB)->_timer_tick();
@@ -355,6 +497,114 @@ void Scheduler::_run_uarts(void)
     UARTDriver::from(hal.uartC)->_timer_tick();
 #endif
     UARTDriver::from(hal.uartE)->_timer_tick();
+    TRACE_END("uarts");
+}
+
+/*
+  event driven UART I/O. Wait on the file descriptors of all UARTs
+  that have one and service a UART as soon as it has input. UARTs with
+  pending output are flushed every millisecond, and every UART is
+  serviced at least every APM_LINUX_UART_PERIOD, which covers devices
+  that can't be waited on (SPI, console) and reconnecting sockets
+ */
+void Scheduler::_uart_reactor(void)
+{
+    UARTDriver *uarts[4];
+    uint8_t num_uarts = 0;
+
+    uarts[num_uarts++] = UARTDriver::from(hal.uartA);
+    uarts[num_uarts++] = UARTDriver::from(hal.uartB);
+#if CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_RASPILOT
+    // a SPI UART is serviced by the timer thread
+    if (RPIOUARTDriver::from(hal.uartC)->isExternal()) {
+        uarts[num_uarts++] = UARTDriver::from(hal.uartC);
+    }
+#else
+    uarts[num_uarts++] = UARTDriver::from(hal.uartC);
+#endif
+    uarts[num_uarts++] = UARTDriver::from(hal.uartE);
+
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd == -1) {
+        hal.console->printf("epoll_create1 failed: %s, polling UARTs\n",
+                            strerror(errno));
+        while (true) {
+            _microsleep(APM_LINUX_UART_PERIOD);
+            _run_uarts();
+        }
+    }
+
+    // fd currently registered for each UART, and whether epoll
+    // accepted it
+    int registered_fd[ARRAY_SIZE(uarts)];
+    bool pollable[ARRAY_SIZE(uarts)];
+    for (uint8_t i = 0; i < num_uarts; i++) {
+        registered_fd[i] = -1;
+        pollable[i] = false;
+    }
+
+    uint64_t last_full_run_usec = 0;
+
+    while (true) {
+        /*
+          keep the epoll set in line with the device fds, which
+          change as ports are opened and TCP clients come and go
+         */
+        bool tx_pending = false;
+        for (uint8_t i = 0; i < num_uarts; i++) {
+            int fd = uarts[i]->get_read_fd();
+            if (fd != registered_fd[i]) {
+                if (pollable[i]) {
+                    // may already be gone if the fd was closed
+                    epoll_ctl(epfd, EPOLL_CTL_DEL, registered_fd[i], NULL);
+                }
+                pollable[i] = false;
+                if (fd != -1) {
+                    /*
+                      edge triggered, so input we can't take yet
+                      because the read buffer is full doesn't keep
+                      waking us up. It gets picked up by the periodic
+                      run instead
+                     */
+                    struct epoll_event ev = {};
+                    ev.events = EPOLLIN | EPOLLET;
+                    ev.data.u32 = i;
+                    pollable[i] = (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) == 0);
+                }
+                registered_fd[i] = fd;
+            }
+            if (uarts[i]->tx_pending()) {
+                tx_pending = true;
+            }
+        }
+
+        struct epoll_event events[ARRAY_SIZE(uarts)];
+        int timeout_ms = tx_pending ? 1 : APM_LINUX_UART_PERIOD / 1000;
+        int nevents = epoll_wait(epfd, events, ARRAY_SIZE(events), timeout_ms);
+
+        bool serviced[ARRAY_SIZE(uarts)] = {};
+        for (int n = 0; n < nevents; n++) {
+            uint32_t i = events[n].data.u32;
+            if (i < num_uarts) {
+                uarts[i]->_timer_tick();
+                serviced[i] = true;
+            }
+        }
+
+        uint64_t now = AP_HAL::micros64();
+        bool full_run = (now - last_full_run_usec >= APM_LINUX_UART_PERIOD);
+        if (full_run) {
+            last_full_run_usec = now;
+        }
+        for (uint8_t i = 0; i < num_uarts; i++) {
+            if (serviced[i]) {
+                continue;
+            }
+            if (full_run || uarts[i]->tx_pending()) {
+                uarts[i]->_timer_tick();
+            }
+        }
+    }
 }
 
 void *Scheduler::_uart_thread(void* arg)
@@ -364,12 +614,13 @@ void *Scheduler::_uart_thread(void* arg)
     while (sched->system_initializing()) {
         poll(NULL, 0, 1);
     }
+#if !HAL_LINUX_UARTS_ON_TIMER_THREAD
+    sched->_uart_reactor();
+#else
     while (true) {
         sched->_microsleep(APM_LINUX_UART_PERIOD);
-#if !HAL_LINUX_UARTS_ON_TIMER_THREAD
-        _run_uarts();
-#endif
     }
+#endif
     return NULL;
 }
 
@@ -404,6 +655,10 @@ void *Scheduler::_io_thread(void* arg)
 
         // run registered IO procepsses
         sched->_run_io();
+
+        // dump perf counters or trace events if a signal asked for it
+        PerfCounters::poll();
+        TraceEvents::poll();
     }
     return NULL;
 }
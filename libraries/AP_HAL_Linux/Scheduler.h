@@ -8,9 +8,12 @@
 #if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
 #include <sys/time.h>
 #include <pthread.h>
+#include <sched.h>
 
 #define LINUX_SCHEDULER_MAX_TIMER_PROCS 10
 #define LINUX_SCHEDULER_MAX_IO_PROCS 10
+#define LINUX_SCHEDULER_MAX_WORKERS 3
+#define LINUX_SCHEDULER_MAX_WORKER_PROCS 16
 
 class Linux::Scheduler : public AP_HAL::Scheduler {
 
@@ -48,6 +51,12 @@ public:
 
     void     stop_clock(uint64_t time_usec);
 
+    bool     run_on_worker(AP_HAL::MemberProc proc, uint32_t *run_time_us = NULL);
+
+    // number of worker threads to start in init(), 0 to disable the
+    // worker pool
+    void     set_num_workers(uint8_t num_workers) { _num_workers = num_workers; }
+
     uint64_t stopped_clock_usec() const { return _stopped_clock_usec; }
 
 private:
@@ -77,23 +86,43 @@ private:
     pthread_t _rcin_thread_ctx;
     pthread_t _uart_thread_ctx;
     pthread_t _tonealarm_thread_ctx;
+    pthread_t _worker_thread_ctx[LINUX_SCHEDULER_MAX_WORKERS];
 
     static void *_timer_thread(void* arg);
     static void *_io_thread(void* arg);
     static void *_rcin_thread(void* arg);
     static void *_uart_thread(void* arg);
     static void _run_uarts(void);
+    void _uart_reactor(void);
     static void *_tonealarm_thread(void* arg);
+    static void *_worker_thread(void* arg);
 
     void _run_timers(bool called_from_timer_thread);
     void _run_io(void);
     void _create_realtime_thread(pthread_t *ctx, int rtprio, const char *name,
-                                 pthread_startroutine_t start_routine);
+                                 pthread_startroutine_t start_routine,
+                                 const cpu_set_t *cpus = NULL);
+    void _init_workers(void);
 
     uint64_t _stopped_clock_usec;
 
     Semaphore _timer_semaphore;
     Semaphore _io_semaphore;
+
+    /*
+      worker pool used to offload thread-safe main loop tasks onto
+      spare cores. _worker_procs holds every proc that is queued or
+      running on a worker, in the order they were queued, and
+      _worker_run_time where to report each one's runtime. Protected
+      by _worker_mutex
+     */
+    uint8_t _num_workers;
+    AP_HAL::MemberProc _worker_procs[LINUX_SCHEDULER_MAX_WORKER_PROCS];
+    uint32_t *_worker_run_time[LINUX_SCHEDULER_MAX_WORKER_PROCS];
+    bool _worker_running[LINUX_SCHEDULER_MAX_WORKER_PROCS];
+    uint8_t _num_worker_procs;
+    pthread_mutex_t _worker_mutex;
+    pthread_cond_t _worker_cond;
 };
 
 #endif // CONFIG_HAL_BOARD
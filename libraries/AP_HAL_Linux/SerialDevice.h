@@ -14,6 +14,13 @@ public:
     virtual ssize_t read(uint8_t *buf, uint16_t n) = 0;
     virtual void set_blocking(bool blocking) = 0;
     virtual void set_speed(uint32_t speed) = 0;
+
+    /*
+      file descriptor that becomes readable when there is input, for
+      event driven I/O. Returns -1 if the device can't be waited on,
+      in which case it is polled
+     */
+    virtual int get_read_fd() { return -1; }
 };
 
 #endif
@@ -7,6 +7,11 @@
 #define LINUX_STORAGE_USE_FRAM 0
 #endif
 
+// journal storage writes, unless the board has FRAM
+#ifndef LINUX_STORAGE_USE_JOURNAL
+#define LINUX_STORAGE_USE_JOURNAL (!LINUX_STORAGE_USE_FRAM)
+#endif
+
 #include <AP_HAL/AP_HAL.h>
 #include "AP_HAL_Linux_Namespace.h"
 
@@ -16,6 +21,15 @@
 #define LINUX_STORAGE_LINE_SIZE (1<<LINUX_STORAGE_LINE_SHIFT)
 #define LINUX_STORAGE_NUM_LINES (LINUX_STORAGE_SIZE/LINUX_STORAGE_LINE_SIZE)
 
+// name the storage file after the sketch so you can use the same board
+// card for ArduCopter and ArduPlane
+#if CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_BEBOP
+#define STORAGE_DIR "/data/ftp/internal_000/APM"
+#else
+#define STORAGE_DIR "/var/APM"
+#endif
+#define STORAGE_FILE STORAGE_DIR "/" SKETCHNAME ".stg"
+
 class Linux::Storage : public AP_HAL::Storage
 {
 public:
@@ -48,6 +62,7 @@ protected:
 };
 
 #include "Storage_FRAM.h"
+#include "Storage_Journal.h"
 
 #endif // __AP_HAL_LINUX_STORAGE_H__
 
@@ -0,0 +1,223 @@
+#include <AP_HAL/AP_HAL.h>
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include "Storage.h"
+
+using namespace Linux;
+
+/*
+  This keeps the .stg image file of Linux::Storage, but rather than
+  rewriting dirty lines in place, each timer tick appends all the
+  dirty lines to a journal file as checksummed records, using a single
+  write() and fdatasync(). On boot the journal is replayed over the
+  image, stopping at the first damaged record, so a power cut loses at
+  most the last tick of changes and never leaves a torn line.
+
+  When the journal gets too large it is compacted into a single record
+  holding the whole buffer, and the image is brought up to date.
+ */
+
+#define LINUX_STORAGE_JOURNAL_MAGIC 0x4754534AUL // "JSTG"
+
+extern const AP_HAL::HAL& hal;
+
+/*
+  standard CRC32, as used by zlib
+ */
+uint32_t Storage_Journal::_crc32(uint32_t crc, const uint8_t *buf, uint32_t len)
+{
+    crc = ~crc;
+    while (len--) {
+        crc ^= *buf++;
+        for (uint8_t i=0; i<8; i++) {
+            crc = (crc >> 1) ^ (0xEDB88320UL & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+/*
+  add a record for part of the buffer at ofs in _record_buffer,
+  returning the offset after it
+ */
+uint16_t Storage_Journal::_add_record(uint16_t ofs, uint16_t offset, uint16_t length)
+{
+    struct record_header hdr;
+    hdr.magic = LINUX_STORAGE_JOURNAL_MAGIC;
+    hdr.offset = offset;
+    hdr.length = length;
+    hdr.crc = 0;
+    uint8_t *data = &_record_buffer[ofs + sizeof(hdr)];
+    memcpy(data, &_buffer[offset], length);
+    hdr.crc = _crc32(_crc32(0, (const uint8_t *)&hdr, sizeof(hdr)), data, length);
+    memcpy(&_record_buffer[ofs], &hdr, sizeof(hdr));
+    return ofs + sizeof(hdr) + length;
+}
+
+/*
+  apply the journal to the buffer, leaving _journal_size as the length
+  of the valid records
+ */
+void Storage_Journal::_replay(void)
+{
+    _journal_size = 0;
+    int fd = open(STORAGE_JOURNAL_FILE, O_RDONLY);
+    if (fd == -1) {
+        return;
+    }
+    struct record_header hdr;
+    while (read(fd, &hdr, sizeof(hdr)) == sizeof(hdr)) {
+        if (hdr.magic != LINUX_STORAGE_JOURNAL_MAGIC ||
+            hdr.length == 0 ||
+            hdr.offset + (uint32_t)hdr.length > sizeof(_buffer)) {
+            break;
+        }
+        if (read(fd, _record_buffer, hdr.length) != hdr.length) {
+            break;
+        }
+        const uint32_t crc = hdr.crc;
+        hdr.crc = 0;
+        if (_crc32(_crc32(0, (const uint8_t *)&hdr, sizeof(hdr)), _record_buffer, hdr.length) != crc) {
+            break;
+        }
+        memcpy(&_buffer[hdr.offset], _record_buffer, hdr.length);
+        _journal_size += sizeof(hdr) + hdr.length;
+    }
+    close(fd);
+}
+
+void Storage_Journal::_storage_open(void)
+{
+    if (_initialised) {
+        return;
+    }
+    Storage::_storage_open();
+    _replay();
+}
+
+/*
+  open the journal for appending, dropping anything after the last
+  complete record, such as a record torn by a failed write
+ */
+bool Storage_Journal::_open_journal(void)
+{
+    _journal_fd = open(STORAGE_JOURNAL_FILE, O_WRONLY|O_CREAT|O_APPEND, 0666);
+    if (_journal_fd == -1) {
+        return false;
+    }
+    if (ftruncate(_journal_fd, _journal_size) != 0) {
+        close(_journal_fd);
+        _journal_fd = -1;
+        return false;
+    }
+    return true;
+}
+
+// write a whole file and sync it
+bool Storage_Journal::_write_file(const char *path, const uint8_t *buf, uint32_t len)
+{
+    int fd = open(path, O_WRONLY|O_CREAT|O_TRUNC, 0666);
+    if (fd == -1) {
+        return false;
+    }
+    bool ret = write(fd, buf, len) == (ssize_t)len && fsync(fd) == 0;
+    close(fd);
+    return ret;
+}
+
+/*
+  replace the journal with a single record holding the whole buffer,
+  then update the image. The new journal is renamed into place so a
+  power cut leaves either the old journal or the new one, and the image
+  is only written afterwards, as the old journal must never be
+  replayed over a newer image
+ */
+void Storage_Journal::_compact(void)
+{
+    uint32_t write_mask = _dirty_mask;
+    _dirty_mask &= ~write_mask;
+
+    const uint16_t len = _add_record(0, 0, sizeof(_buffer));
+    if (!_write_file(STORAGE_JOURNAL_FILE ".tmp", _record_buffer, len) ||
+        rename(STORAGE_JOURNAL_FILE ".tmp", STORAGE_JOURNAL_FILE) != 0) {
+        _dirty_mask |= write_mask;
+        return;
+    }
+    if (_journal_fd != -1) {
+        close(_journal_fd);
+        _journal_fd = -1;
+    }
+    _journal_size = len;
+
+    // the data in the record is the new image
+    if (_write_file(STORAGE_FILE ".tmp", &_record_buffer[sizeof(struct record_header)], sizeof(_buffer))) {
+        rename(STORAGE_FILE ".tmp", STORAGE_FILE);
+    }
+
+    // make the renames durable
+    int fd = open(STORAGE_DIR, O_RDONLY);
+    if (fd != -1) {
+        fsync(fd);
+        close(fd);
+    }
+}
+
+void Storage_Journal::_timer_tick(void)
+{
+    if (!_initialised || _dirty_mask == 0) {
+        return;
+    }
+
+    if (_journal_size >= LINUX_STORAGE_JOURNAL_MAX_SIZE) {
+        _compact();
+        return;
+    }
+
+    if (_journal_fd == -1 && !_open_journal()) {
+        return;
+    }
+
+    /*
+      take all the dirty lines. The mask is cleared before the lines
+      are copied, so a write racing with the copy marks its lines dirty
+      again and they go in a later record. As in Storage::_timer_tick()
+      this runs in a SCHED_FIFO thread, so the main task can't update
+      _dirty_mask between the read and the clear
+     */
+    uint32_t write_mask = _dirty_mask;
+    _dirty_mask &= ~write_mask;
+
+    // one record for each run of dirty lines
+    uint16_t len = 0;
+    uint8_t i = 0;
+    while (i < LINUX_STORAGE_NUM_LINES) {
+        if (!(write_mask & (1U<<i))) {
+            i++;
+            continue;
+        }
+        uint8_t n = 1;
+        while (i+n < LINUX_STORAGE_NUM_LINES && (write_mask & (1U<<(i+n)))) {
+            n++;
+        }
+        len = _add_record(len, i<<LINUX_STORAGE_LINE_SHIFT, n<<LINUX_STORAGE_LINE_SHIFT);
+        i += n;
+    }
+
+    if (write(_journal_fd, _record_buffer, len) != len ||
+        fdatasync(_journal_fd) != 0) {
+        // write error - try again on the next tick, after trimming
+        // any partial record
+        _dirty_mask |= write_mask;
+        close(_journal_fd);
+        _journal_fd = -1;
+        return;
+    }
+    _journal_size += len;
+}
+
+#endif // CONFIG_HAL_BOARD
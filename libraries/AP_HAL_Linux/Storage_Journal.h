@@ -0,0 +1,48 @@
+#ifndef __AP_HAL_LINUX_STORAGE_JOURNAL_H__
+#define __AP_HAL_LINUX_STORAGE_JOURNAL_H__
+
+#include <AP_HAL/AP_HAL.h>
+#include "AP_HAL_Linux_Namespace.h"
+
+#define STORAGE_JOURNAL_FILE STORAGE_FILE ".jnl"
+
+// compact the journal once it grows past this size
+#define LINUX_STORAGE_JOURNAL_MAX_SIZE (4*LINUX_STORAGE_SIZE)
+
+/*
+  storage with the same in-memory buffer and .stg image file as
+  Linux::Storage, but with changes appended to a journal of checksummed
+  records rather than rewritten in place
+ */
+class Linux::Storage_Journal : public Linux::Storage
+{
+public:
+    Storage_Journal() : _journal_fd(-1), _journal_size(0) { }
+
+    void _timer_tick(void);
+
+private:
+    struct record_header {
+        uint32_t magic;
+        uint16_t offset;
+        uint16_t length;
+        uint32_t crc;
+    };
+
+    int _journal_fd;
+    uint32_t _journal_size;
+
+    // records built here before being written with a single write()
+    uint8_t _record_buffer[LINUX_STORAGE_SIZE +
+                           LINUX_STORAGE_NUM_LINES * sizeof(struct record_header)];
+
+    void _storage_open(void);
+    void _replay(void);
+    void _compact(void);
+    bool _open_journal(void);
+    uint16_t _add_record(uint16_t ofs, uint16_t offset, uint16_t length);
+    static uint32_t _crc32(uint32_t crc, const uint8_t *buf, uint32_t len);
+    static bool _write_file(const char *path, const uint8_t *buf, uint32_t len);
+};
+
+#endif // __AP_HAL_LINUX_STORAGE_JOURNAL_H__
@@ -16,6 +16,12 @@ public:
     virtual ssize_t write(const uint8_t *buf, uint16_t n) override;
     virtual ssize_t read(uint8_t *buf, uint16_t n) override;
 
+    // until a client connects the listening socket becomes readable
+    // on a new connection, which read() then accepts
+    virtual int get_read_fd() override {
+        return sock != NULL ? sock->get_fd() : listener.get_fd();
+    }
+
 private:
     SocketAPM listener{false};
     SocketAPM *sock = NULL;
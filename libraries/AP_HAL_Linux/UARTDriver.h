@@ -2,6 +2,8 @@
 #ifndef __AP_HAL_LINUX_UARTDRIVER_H__
 #define __AP_HAL_LINUX_UARTDRIVER_H__
 
+#include <AP_HAL/utility/RingBuffer.h>
+
 #include "AP_HAL_Linux.h"
 
 #include "SerialDevice.h"
@@ -27,16 +29,24 @@ public:
     int16_t available();
     int16_t txspace();
     int16_t read();
+    uint16_t read_buffer(uint8_t *buffer, uint16_t count);
 
     /* Linux implementations of Print virtual methods */
     size_t write(uint8_t c);
     size_t write(const uint8_t *buffer, size_t size);
 
+    uint8_t *write_reserve(uint16_t size);
+    void write_commit(uint16_t size);
+
     void set_device_path(const char *path);
 
     bool _write_pending_bytes(void);
     virtual void _timer_tick(void);
 
+    // file descriptor to wait on for input, or -1 if the port needs
+    // to be polled
+    virtual int get_read_fd(void);
+
     enum flow_control get_flow_control(void) { return _flow_control; }
 
 private:
@@ -76,18 +86,8 @@ protected:
     volatile bool _initialised;
     // we use in-task ring buffers to reduce the system call cost
     // of ::read() and ::write() in the main loop
-    uint8_t *_readbuf;
-    uint16_t _readbuf_size;
-
-    // _head is where the next available data is. _tail is where new
-    // data is put
-    volatile uint16_t _readbuf_head;
-    volatile uint16_t _readbuf_tail;
-
-    uint8_t *_writebuf;
-    uint16_t _writebuf_size;
-    volatile uint16_t _writebuf_head;
-    volatile uint16_t _writebuf_tail;
+    ByteBuffer _readbuf{0};
+    ByteBuffer _writebuf{0};
 
     virtual int _write_fd(const uint8_t *buf, uint16_t n);
     virtual int _read_fd(uint8_t *buf, uint16_t n);
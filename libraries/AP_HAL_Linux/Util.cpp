@@ -37,6 +37,9 @@ void Util::init(int argc, char * const *argv) {
 #else
     _heat = new Linux::Heat();
 #endif // #ifdef
+
+    PerfCounters::init(perf_file);
+    TraceEvents::init(trace_file);
 }
 
 void Util::set_imu_temp(float current)
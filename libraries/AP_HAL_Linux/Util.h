@@ -8,6 +8,8 @@
 #include "AP_HAL_Linux_Namespace.h"
 #include "ToneAlarmDriver.h"
 #include "Semaphores.h"
+#include <AP_HAL/utility/PerfCounters.h>
+#include <AP_HAL/utility/TraceEvents.h>
 
 class Linux::Util : public AP_HAL::Util {
 public:
@@ -38,6 +40,12 @@ public:
     void set_custom_log_directory(const char *_custom_log_directory) { custom_log_directory = _custom_log_directory; }
     void set_custom_terrain_directory(const char *_custom_terrain_directory) { custom_terrain_directory = _custom_terrain_directory; }
 
+    // file the perf counters are written to on exit, or NULL
+    void set_perf_file(const char *_perf_file) { perf_file = _perf_file; }
+
+    // file trace events are written to, or NULL to not record them
+    void set_trace_file(const char *_trace_file) { trace_file = _trace_file; }
+
     bool is_chardev_node(const char *path);
     void set_imu_temp(float current);
 
@@ -57,10 +65,15 @@ public:
      */
     int read_file(const char *path, const char *fmt, ...) FMT_SCANF(3, 4);
 
-    perf_counter_t perf_alloc(perf_counter_type t, const char *name) override;
-    void perf_begin(perf_counter_t perf) override;
-    void perf_end(perf_counter_t perf) override;
-    void perf_count(perf_counter_t perf) override;
+    perf_counter_t perf_alloc(perf_counter_type t, const char *name) override {
+        return PerfCounters::alloc(t, name);
+    }
+    void perf_begin(perf_counter_t perf) override { PerfCounters::begin(perf); }
+    void perf_end(perf_counter_t perf) override { PerfCounters::end(perf); }
+    void perf_count(perf_counter_t perf) override { PerfCounters::count(perf); }
+    bool perf_get_info(uint16_t idx, perf_info &info) override {
+        return PerfCounters::get_info(idx, info);
+    }
 
     // create a new semaphore
     AP_HAL::Semaphore *new_semaphore(void) override { return new Linux::Semaphore; }
@@ -72,6 +85,8 @@ private:
     char* const *saved_argv;
     const char* custom_log_directory = NULL;
     const char* custom_terrain_directory = NULL;	
+    const char* perf_file = NULL;
+    const char* trace_file = NULL;
 };
 
 
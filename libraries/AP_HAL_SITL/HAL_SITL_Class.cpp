@@ -18,6 +18,7 @@
 #include "SITL_State.h"
 #include "Util.h"
 
+#include <AP_HAL/utility/PerfCounters.h>
 #include <AP_HAL_Empty/AP_HAL_Empty.h>
 #include <AP_HAL_Empty/AP_HAL_Empty_Private.h>
 
@@ -89,6 +90,12 @@ void HAL_SITL::run(int argc, char * const argv[], Callbacks* callbacks) const
 
     for (;;) {
         callbacks->loop();
+
+        // exit here rather than from the signal handler or the IO
+        // thread, so the atexit() handlers run on the main thread
+        if (PerfCounters::exit_requested()) {
+            exit(0);
+        }
     }
 }
 
@@ -12,6 +12,8 @@
 #include <signal.h>
 #include <unistd.h>
 #include <AP_HAL/utility/getopt_cpp.h>
+#include <AP_HAL/utility/PerfCounters.h>
+#include <AP_HAL/utility/TraceEvents.h>
 
 #include <SITL/SIM_Multicopter.h>
 #include <SITL/SIM_Helicopter.h>
@@ -53,6 +55,8 @@ void SITL_State::_usage(void)
            "\t--uartC device     set device string for UARTC\n"
            "\t--uartD device     set device string for UARTD\n"
            "\t--uartE device     set device string for UARTE\n"
+           "\t--perf-file FILE   write perf counters to FILE on exit (JSON if FILE ends in .json)\n"
+           "\t--trace-file FILE  record a timeline of the threads to FILE, written on exit and SIGUSR2\n"
         );
 }
 
@@ -85,6 +89,8 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
     const char *home_str = "-35.363261,149.165230,584,353";
     const char *model_str = NULL;
     char *autotest_dir = NULL;
+    const char *perf_file = NULL;
+    const char *trace_file = NULL;
     float speedup = 1.0f;
 
     if (asprintf(&autotest_dir, SKETCHBOOK "/Tools/autotest") <= 0) {
@@ -116,6 +122,8 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
         CMDLINE_UARTD,
         CMDLINE_UARTE,
         CMDLINE_ADSB,
+        CMDLINE_PERFFILE,
+        CMDLINE_TRACEFILE,
     };
 
     const struct GetOptLong::option options[] = {
@@ -138,6 +146,8 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
         {"gimbal",          false,  0, CMDLINE_GIMBAL},
         {"adsb",            false,  0, CMDLINE_ADSB},
         {"autotest-dir",    true,   0, CMDLINE_AUTOTESTDIR},
+        {"perf-file",       true,   0, CMDLINE_PERFFILE},
+        {"trace-file",      true,   0, CMDLINE_TRACEFILE},
         {0, false, 0, 0}
     };
 
@@ -193,6 +203,12 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
         case CMDLINE_AUTOTESTDIR:
             autotest_dir = strdup(gopt.optarg);
             break;
+        case CMDLINE_PERFFILE:
+            perf_file = gopt.optarg;
+            break;
+        case CMDLINE_TRACEFILE:
+            trace_file = gopt.optarg;
+            break;
 
         case CMDLINE_UARTA:
         case CMDLINE_UARTB:
@@ -208,6 +224,9 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
         }
     }
 
+    PerfCounters::init(perf_file);
+    TraceEvents::init(trace_file);
+
     if (!model_str) {
         printf("You must specify a vehicle model\n");
         exit(1);
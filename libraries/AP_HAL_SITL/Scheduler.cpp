@@ -5,6 +5,8 @@
 
 #include "AP_HAL_SITL.h"
 #include "Scheduler.h"
+#include <AP_HAL/utility/PerfCounters.h>
+#include <AP_HAL/utility/TraceEvents.h>
 #include <sys/time.h>
 #include <unistd.h>
 #include <fenv.h>
@@ -174,6 +176,7 @@ void SITLScheduler::_run_timer_procs(bool called_from_isr)
         return;
     }
     _in_timer_proc = true;
+    TRACE_BEGIN("timers");
 
     if (!_timer_suspended) {
         // now call the timer based drivers
@@ -191,6 +194,7 @@ void SITLScheduler::_run_timer_procs(bool called_from_isr)
         _failsafe();
     }
 
+    TRACE_END("timers");
     _in_timer_proc = false;
 }
 
@@ -200,6 +204,7 @@ void SITLScheduler::_run_io_procs(bool called_from_isr)
         return;
     }
     _in_io_proc = true;
+    TRACE_BEGIN("io");
 
     if (!_timer_suspended) {
         // now call the IO based drivers
@@ -212,6 +217,11 @@ void SITLScheduler::_run_io_procs(bool called_from_isr)
         _timer_event_missed = true;
     }
 
+    // dump perf counters or trace events if a signal asked for it
+    PerfCounters::poll();
+    TraceEvents::poll();
+
+    TRACE_END("io");
     _in_io_proc = false;
 }
 
@@ -182,6 +182,37 @@ int16_t SITLUARTDriver::read(void)
     return -1;
 }
 
+uint16_t SITLUARTDriver::read_buffer(uint8_t *buffer, uint16_t count)
+{
+    int16_t avail = available();
+    if (avail <= 0) {
+        return 0;
+    }
+    if (count > avail) {
+        count = avail;
+    }
+
+    ssize_t n;
+    if (_portNumber == 1 || _portNumber == 4) {
+        n = _sitlState->gps_read(_fd, buffer, count);
+    } else if (!_use_send_recv) {
+        n = ::read(_console?0:_fd, buffer, count);
+    } else {
+        n = recv(_fd, buffer, count, MSG_DONTWAIT);
+        if (n == 0) {
+            // the socket has reached EOF
+            close(_fd);
+            _connected = false;
+            fprintf(stdout, "Closed connection on serial port %u\n", _portNumber);
+            fflush(stdout);
+        }
+    }
+    if (n <= 0) {
+        return 0;
+    }
+    return n;
+}
+
 void SITLUARTDriver::flush(void)
 {
 }
@@ -211,6 +242,47 @@ size_t SITLUARTDriver::write(const uint8_t *buffer, size_t size)
     return n;
 }
 
+/*
+  there is no write buffer in SITL, so a reservation is made in a
+  staging buffer and sent with a single system call on commit
+ */
+uint8_t *SITLUARTDriver::write_reserve(uint16_t size)
+{
+    _check_connection();
+    if (!_connected || size > sizeof(_reserve_buf)) {
+        return NULL;
+    }
+    return _reserve_buf;
+}
+
+void SITLUARTDriver::write_commit(uint16_t size)
+{
+    if (size > sizeof(_reserve_buf)) {
+        return;
+    }
+    const uint8_t *p = _reserve_buf;
+    while (size > 0) {
+        ssize_t n;
+        if (!_use_send_recv) {
+            n = ::write(_fd, p, size);
+        } else {
+            n = send(_fd, p, size, _nonblocking_writes ? MSG_DONTWAIT : 0);
+        }
+        if (n > 0) {
+            p += n;
+            size -= n;
+        } else if (n == -1 && errno == EINTR) {
+            continue;
+        } else {
+            // hand the rest to write(), which behaves as it did before
+            // write_reserve() existed, including dropping bytes when a
+            // non-blocking port is full
+            write(p, size);
+            return;
+        }
+    }
+}
+
 /*
   start a TCP connection for the serial port. If wait_for_connection
   is true then block until a client connects
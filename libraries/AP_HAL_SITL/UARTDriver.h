@@ -44,15 +44,24 @@ public:
         return false;
     }
 
+    // TCP connections are flow controlled by the socket, as on Linux
+    enum flow_control get_flow_control(void) {
+        return _use_send_recv ? FLOW_CONTROL_ENABLE : FLOW_CONTROL_DISABLE;
+    }
+
     /* Implementations of Stream virtual methods */
     int16_t available();
     int16_t txspace();
     int16_t read();
+    uint16_t read_buffer(uint8_t *buffer, uint16_t count);
 
     /* Implementations of Print virtual methods */
     size_t write(uint8_t c);
     size_t write(const uint8_t *buffer, size_t size);
 
+    uint8_t *write_reserve(uint16_t size);
+    void write_commit(uint16_t size);
+
     // file descriptor, exposed so SITL_State::loop_hook() can use it
     int _fd;
 
@@ -91,6 +100,9 @@ private:
 
     SITL_State *_sitlState;
 
+    // staging buffer for write_reserve()
+    uint8_t _reserve_buf[_max_buffer_size];
+
 };
 
 #endif
@@ -5,6 +5,7 @@
 #include <AP_HAL/AP_HAL.h>
 #include "AP_HAL_SITL_Namespace.h"
 #include "Semaphores.h"
+#include <AP_HAL/utility/PerfCounters.h>
 
 class HALSITL::SITLUtil : public AP_HAL::Util {
 public:
@@ -20,6 +21,16 @@ public:
         return 0x20000;
     }
 
+    perf_counter_t perf_alloc(perf_counter_type t, const char *name) override {
+        return PerfCounters::alloc(t, name);
+    }
+    void perf_begin(perf_counter_t perf) override { PerfCounters::begin(perf); }
+    void perf_end(perf_counter_t perf) override { PerfCounters::end(perf); }
+    void perf_count(perf_counter_t perf) override { PerfCounters::count(perf); }
+    bool perf_get_info(uint16_t idx, perf_info &info) override {
+        return PerfCounters::get_info(idx, info);
+    }
+
     // create a new semaphore
     AP_HAL::Semaphore *new_semaphore(void) override { return new HALSITL::Semaphore; }
 };
@@ -24,6 +24,7 @@
 #include "AP_InertialSensor_UserInteract.h"
 #include <Filter/LowPassFilter.h>
 #include <Filter/LowPassFilter2p.h>
+#include <Filter/LowPassFilter2pBank.h>
 
 class AP_InertialSensor_Backend;
 class AuxiliaryBus;
@@ -285,8 +286,9 @@ private:
     float _delta_velocity_acc_dt[INS_MAX_INSTANCES];
 
     // Low Pass filters for gyro and accel
-    LowPassFilter2pVector3f _accel_filter[INS_MAX_INSTANCES];
-    LowPassFilter2pVector3f _gyro_filter[INS_MAX_INSTANCES];
+    // accel and gyro low pass filters, with the accel of each instance
+    // in the first INS_MAX_INSTANCES channels and the gyro in the rest
+    LowPassFilter2pVector3fBank<2*INS_MAX_INSTANCES> _imu_filter;
     Vector3f _accel_filtered[INS_MAX_INSTANCES];
     Vector3f _gyro_filtered[INS_MAX_INSTANCES];
     bool _new_accel_data[INS_MAX_INSTANCES];
@@ -92,9 +92,9 @@ void AP_InertialSensor_Backend::_notify_new_gyro_raw_sample(uint8_t instance,
     _imu._last_delta_angle[instance] = delta_angle;
     _imu._last_raw_gyro[instance] = gyro;
 
-    _imu._gyro_filtered[instance] = _imu._gyro_filter[instance].apply(gyro);
+    _imu._gyro_filtered[instance] = _imu._imu_filter.apply(INS_MAX_INSTANCES + instance, gyro);
     if (_imu._gyro_filtered[instance].is_nan() || _imu._gyro_filtered[instance].is_inf()) {
-        _imu._gyro_filter[instance].reset();
+        _imu._imu_filter.reset(INS_MAX_INSTANCES + instance);
     }
 
     _imu._new_gyro_data[instance] = true;
@@ -150,9 +150,9 @@ void AP_InertialSensor_Backend::_notify_new_accel_raw_sample(uint8_t instance,
     _imu._delta_velocity_acc[instance] += accel * dt;
     _imu._delta_velocity_acc_dt[instance] += dt;
 
-    _imu._accel_filtered[instance] = _imu._accel_filter[instance].apply(accel);
+    _imu._accel_filtered[instance] = _imu._imu_filter.apply(instance, accel);
     if (_imu._accel_filtered[instance].is_nan() || _imu._accel_filtered[instance].is_inf()) {
-        _imu._accel_filter[instance].reset();
+        _imu._imu_filter.reset(instance);
     }
 
     _imu._new_accel_data[instance] = true;
@@ -219,7 +219,7 @@ void AP_InertialSensor_Backend::update_gyro(uint8_t instance)
 
     // possibly update filter frequency
     if (_last_gyro_filter_hz[instance] != _gyro_filter_cutoff()) {
-        _imu._gyro_filter[instance].set_cutoff_frequency(_gyro_raw_sample_rate(instance), _gyro_filter_cutoff());
+        _imu._imu_filter.set_cutoff_frequency(INS_MAX_INSTANCES + instance, _gyro_raw_sample_rate(instance), _gyro_filter_cutoff());
         _last_gyro_filter_hz[instance] = _gyro_filter_cutoff();
     }
 
@@ -240,7 +240,7 @@ void AP_InertialSensor_Backend::update_accel(uint8_t instance)
     
     // possibly update filter frequency
     if (_last_accel_filter_hz[instance] != _accel_filter_cutoff()) {
-        _imu._accel_filter[instance].set_cutoff_frequency(_accel_raw_sample_rate(instance), _accel_filter_cutoff());
+        _imu._imu_filter.set_cutoff_frequency(instance, _accel_raw_sample_rate(instance), _accel_filter_cutoff());
         _last_accel_filter_hz[instance] = _accel_filter_cutoff();
     }
 
@@ -207,20 +207,42 @@ void AP_MPU6000_BusDriver_SPI::init()
 
 void AP_MPU6000_BusDriver_SPI::start(bool &fifo_mode, uint8_t &max_samples)
 {
-    fifo_mode = false;
+    /*
+      read the samples through the FIFO, so that a late poll doesn't
+      lose samples and several samples come in one transfer
+     */
+    fifo_mode = true;
     _error_count = 0;
+    write8(MPUREG_FIFO_EN, BIT_XG_FIFO_EN | BIT_YG_FIFO_EN |
+                           BIT_ZG_FIFO_EN | BIT_ACCEL_FIFO_EN | BIT_TEMP_FIFO_EN);
+    _fifo_reset();
     /* maximum number of samples read by a burst
      * a sample is an array containing :
-     * gyro_x
-     * gyro_y
-     * gyro_z
      * accel_x
      * accel_y
      * accel_z
+     * temperature
+     * gyro_x
+     * gyro_y
+     * gyro_z
      */
-    max_samples = 1;
+    max_samples = MPU6000_SPI_MAX_FIFO_SAMPLES;
 };
 
+/*
+  empty the FIFO, keeping the other USER_CTRL settings such as the
+  auxiliary bus master
+ */
+void AP_MPU6000_BusDriver_SPI::_fifo_reset()
+{
+    uint8_t user_ctrl;
+    read8(MPUREG_USER_CTRL, &user_ctrl);
+    user_ctrl &= ~BIT_USER_CTRL_FIFO_EN;
+    write8(MPUREG_USER_CTRL, user_ctrl);
+    write8(MPUREG_USER_CTRL, user_ctrl | BIT_USER_CTRL_FIFO_RESET);
+    write8(MPUREG_USER_CTRL, user_ctrl | BIT_USER_CTRL_FIFO_EN);
+}
+
 /*
  * This implementation is limited to a block of at most 32 bytes
  */
@@ -267,38 +289,60 @@ void AP_MPU6000_BusDriver_SPI::set_bus_speed(AP_HAL::SPIDeviceDriver::bus_speed
 
 void AP_MPU6000_BusDriver_SPI::read_data_transaction(uint8_t *samples,
                                                      AP_HAL::DigitalSource *_drdy_pin,
-                                                     uint8_t &n_samples)
+                                                     uint8_t &n_samples,
+                                                     uint32_t &n_lost)
 {
-    /* one register address followed by seven 2-byte registers */
-    struct PACKED {
-        uint8_t cmd;
-        uint8_t int_status;
-        uint8_t d[14];
-    } rx, tx = { cmd : MPUREG_INT_STATUS | 0x80, };
+    n_samples = 0;
+
+    uint8_t count[2];
+    read_block(MPUREG_FIFO_COUNTH, count, 2);
+    uint16_t bytes = uint16_val(count, 0);
+    if (bytes == 0) {
+        return;
+    }
+
+    /*
+      a count which isn't a whole number of samples, or which has
+      reached the size of the FIFO, means it overflowed and the
+      samples in it can't be trusted
+     */
+    if (bytes % MPU6000_SAMPLE_SIZE != 0 ||
+        bytes > MPU6000_FIFO_SIZE - MPU6000_SAMPLE_SIZE) {
+        _fifo_reset();
+        n_lost += bytes / MPU6000_SAMPLE_SIZE;
+        return;
+    }
+
+    n_samples = bytes / MPU6000_SAMPLE_SIZE;
+    if (n_samples > MPU6000_SPI_MAX_FIFO_SAMPLES) {
+        n_samples = MPU6000_SPI_MAX_FIFO_SAMPLES;
+    }
 
-    _spi->transaction((const uint8_t *)&tx, (uint8_t *)&rx, sizeof(rx));
+    /* one register address followed by the samples */
+    const uint16_t len = n_samples * MPU6000_SAMPLE_SIZE;
+    uint8_t tx[MPU6000_SPI_MAX_FIFO_SAMPLES * MPU6000_SAMPLE_SIZE + 1] = { MPUREG_FIFO_R_W | 0x80, };
+    uint8_t rx[MPU6000_SPI_MAX_FIFO_SAMPLES * MPU6000_SAMPLE_SIZE + 1];
+
+    _spi->transaction(tx, rx, len + 1);
 
     /*
       detect a bad SPI bus transaction by looking for all 14 bytes
-      zero. This can happen with some boards with hw that end up
-      needing a lower bus speed
+      of the first sample zero. This can happen with some boards with
+      hw that end up needing a lower bus speed
     */
     uint8_t i;
-    for (i=0; i<14; i++) {
-        if (rx.d[i] != 0) break;
+    for (i=0; i<MPU6000_SAMPLE_SIZE; i++) {
+        if (rx[i+1] != 0) break;
     }
-    if (i == 14) {
+    if (i == MPU6000_SAMPLE_SIZE) {
         // likely a bad bus transaction
         if (++_error_count > 4) {
             set_bus_speed(AP_HAL::SPIDeviceDriver::SPI_SPEED_LOW);
         }
     }
 
-    n_samples = 1;
     /* remove cmd from data sample */
-    memcpy(&samples[0], &rx.d[0], 14);
-
-    return;
+    memcpy(samples, &rx[1], len);
 }
 
 AP_HAL::Semaphore* AP_MPU6000_BusDriver_SPI::get_semaphore()
@@ -364,7 +408,8 @@ void AP_MPU6000_BusDriver_I2C::set_bus_speed(AP_HAL::SPIDeviceDriver::bus_speed
 
 void AP_MPU6000_BusDriver_I2C::read_data_transaction(uint8_t *samples,
                                                      AP_HAL::DigitalSource *_drdy_pin,
-                                                     uint8_t &n_samples)
+                                                     uint8_t &n_samples,
+                                                     uint32_t &n_lost)
 {
 	uint16_t bytes_read;
     uint8_t ret = 0;
@@ -388,6 +433,7 @@ void AP_MPU6000_BusDriver_I2C::read_data_transaction(uint8_t *samples,
         write8(MPUREG_USER_CTRL, 0);
         write8(MPUREG_USER_CTRL, BIT_USER_CTRL_FIFO_RESET);
         write8(MPUREG_USER_CTRL, BIT_USER_CTRL_FIFO_EN);
+        n_lost += n_samples;
         n_samples = 0;
         return;
     }
@@ -532,12 +578,6 @@ void AP_InertialSensor_MPU6000::start()
     _register_write(MPUREG_PWR_MGMT_2, 0x00);
     hal.scheduler->delay(1);
 
-    _bus->start(_fifo_mode, max_samples);
-
-    /* each sample is on 16 bits */
-    _samples = new uint8_t[max_samples * MPU6000_SAMPLE_SIZE];
-    hal.scheduler->delay(1);
-
     // disable sensor filtering
     _set_filter_register(256);
 
@@ -578,6 +618,14 @@ void AP_InertialSensor_MPU6000::start()
     // until we clear the interrupt
     _register_write(MPUREG_INT_PIN_CFG, BIT_INT_RD_CLEAR | BIT_LATCH_INT_EN);
 
+    // start the bus last, so a FIFO only holds samples taken with
+    // the final configuration
+    _bus->start(_fifo_mode, max_samples);
+
+    /* each sample is on 16 bits */
+    _samples = new uint8_t[max_samples * MPU6000_SAMPLE_SIZE];
+    hal.scheduler->delay(1);
+
     // now that we have initialised, we set the SPI bus speed to high
     _bus->set_bus_speed(AP_HAL::SPIDeviceDriver::SPI_SPEED_HIGH);
 
@@ -602,6 +650,9 @@ bool AP_InertialSensor_MPU6000::update( void )
     update_accel(_accel_instance);
     update_gyro(_gyro_instance);
 
+    _set_accel_error_count(_accel_instance, _lost_samples);
+    _set_gyro_error_count(_gyro_instance, _lost_samples);
+
     _publish_temperature(_accel_instance, _temp_filtered);
     
     /* give the temperature to the control loop in order to keep it constant*/
@@ -698,7 +749,7 @@ void AP_InertialSensor_MPU6000::_read_data_transaction()
 {
     uint8_t n_samples;
 
-    _bus->read_data_transaction(_samples, _drdy_pin, n_samples);
+    _bus->read_data_transaction(_samples, _drdy_pin, n_samples, _lost_samples);
     _accumulate(_samples, n_samples);
 }
 
@@ -25,6 +25,13 @@
 #endif
 #define MAX_DATA_READ (MPU6000_MAX_FIFO_SAMPLES * MPU6000_SAMPLE_SIZE)
 
+// most samples read from the FIFO in one SPI transfer. Any more are
+// left for the next poll
+#define MPU6000_SPI_MAX_FIFO_SAMPLES 8
+
+// size of the on-chip FIFO in bytes
+#define MPU6000_FIFO_SIZE 1024
+
 class AP_MPU6000_AuxiliaryBus;
 class AP_MPU6000_AuxiliaryBusSlave;
 
@@ -41,9 +48,13 @@ public:
     virtual void read_block(uint8_t reg, uint8_t *buf, uint32_t size) = 0;
     virtual void write8(uint8_t reg, uint8_t val) = 0;
     virtual void set_bus_speed(AP_HAL::SPIDeviceDriver::bus_speed speed) = 0;
+    /// Read the pending samples into @p samples, setting @p n_samples.
+    /// @p n_lost is increased by the number of samples known to have
+    /// been lost, for example by a FIFO overflow
     virtual void read_data_transaction(uint8_t* samples,
                             AP_HAL::DigitalSource *_drdy_pin,
-                            uint8_t &n_samples) = 0;
+                            uint8_t &n_samples,
+                            uint32_t &n_lost) = 0;
     virtual AP_HAL::Semaphore* get_semaphore() = 0;
     virtual bool has_auxiliary_bus() = 0;
 };
@@ -114,6 +125,9 @@ private:
 
     bool _fifo_mode;
     uint8_t *_samples = nullptr;
+
+    // samples lost to FIFO overflows, reported as the error count
+    uint32_t _lost_samples = 0;
 };
 
 class AP_MPU6000_BusDriver_SPI : public AP_MPU6000_BusDriver
@@ -128,11 +142,14 @@ public:
     void set_bus_speed(AP_HAL::SPIDeviceDriver::bus_speed speed);
     void read_data_transaction(uint8_t* samples,
                                AP_HAL::DigitalSource *_drdy_pin,
-                               uint8_t &n_samples);
+                               uint8_t &n_samples,
+                               uint32_t &n_lost);
     AP_HAL::Semaphore* get_semaphore();
     bool has_auxiliary_bus() override;
 
 private:
+    void _fifo_reset();
+
     AP_HAL::SPIDeviceDriver *_spi;
     AP_HAL::Semaphore *_spi_sem;
     // count of bus errors
@@ -151,7 +168,8 @@ public:
     void set_bus_speed(AP_HAL::SPIDeviceDriver::bus_speed speed);
     void read_data_transaction(uint8_t* samples,
                                AP_HAL::DigitalSource *_drdy_pin,
-                               uint8_t &n_samples);
+                               uint8_t &n_samples,
+                               uint32_t &n_lost);
     AP_HAL::Semaphore* get_semaphore();
     bool has_auxiliary_bus() override;
 
@@ -77,6 +77,11 @@ extern const AP_HAL::HAL& hal;
 #define MPUREG_ZRMOT_THR                                0x21    // detection threshold for Zero Motion interrupt generation.
 #define MPUREG_ZRMOT_DUR                                0x22    // duration counter threshold for Zero Motion interrupt generation. The duration counter ticks at 16 Hz, therefore ZRMOT_DUR has a unit of 1 LSB = 64 ms.
 #define MPUREG_FIFO_EN                                  0x23
+#       define BIT_TEMP_FIFO_EN                                 0x80
+#       define BIT_XG_FIFO_EN                                   0x40
+#       define BIT_YG_FIFO_EN                                   0x20
+#       define BIT_ZG_FIFO_EN                                   0x10
+#       define BIT_ACCEL_FIFO_EN                                0x08
 #define MPUREG_INT_PIN_CFG                              0x37
 #       define BIT_INT_RD_CLEAR                                 0x10    // clear the interrupt when any read occurs
 #       define BIT_LATCH_INT_EN                                 0x20    // latch data ready pin
@@ -201,6 +206,18 @@ extern const AP_HAL::HAL& hal;
  */
 #define MPU9250_SAMPLE_SIZE 14
 
+/*
+ * most samples read from the FIFO in one transfer. Any more are left
+ * for the next poll
+ */
+#define MPU9250_MAX_FIFO_SAMPLES 8
+
+// size of the on-chip FIFO in bytes
+#define MPU9250_FIFO_SIZE 512
+
+#define int16_val(v, idx) ((int16_t)(((uint16_t)v[2*idx] << 8) | v[2*idx+1]))
+#define uint16_val(v, idx)(((uint16_t)v[2*idx] << 8) | v[2*idx+1])
+
 /* SPI bus driver implementation */
 AP_MPU9250_BusDriver_SPI::AP_MPU9250_BusDriver_SPI(AP_HAL::SPIDeviceDriver *spi)
 {
@@ -229,11 +246,11 @@ void AP_MPU9250_BusDriver_SPI::read8(uint8_t reg, uint8_t *val)
 
 void AP_MPU9250_BusDriver_SPI::read_block(uint8_t reg, uint8_t *val, uint8_t count)
 {
-    assert(count < 32);
+    assert(count <= MPU9250_MAX_FIFO_SAMPLES * MPU9250_SAMPLE_SIZE);
 
     uint8_t addr = reg | 0x80; // Set most significant bit
-    uint8_t tx[32] = { addr, };
-    uint8_t rx[32];
+    uint8_t tx[MPU9250_MAX_FIFO_SAMPLES * MPU9250_SAMPLE_SIZE + 1] = { addr, };
+    uint8_t rx[MPU9250_MAX_FIFO_SAMPLES * MPU9250_SAMPLE_SIZE + 1];
 
     _spi->transaction(tx, rx, count + 1);
     memcpy(val, rx + 1, count);
@@ -254,31 +271,6 @@ void AP_MPU9250_BusDriver_SPI::set_bus_speed(AP_HAL::SPIDeviceDriver::bus_speed
     _spi->set_bus_speed(speed);
 }
 
-bool AP_MPU9250_BusDriver_SPI::read_data_transaction(uint8_t *samples, uint8_t &n_samples)
-{
-    /* one register address followed by seven 2-byte registers */
-    struct PACKED {
-        uint8_t cmd;
-        uint8_t int_status;
-        uint8_t v[MPU9250_SAMPLE_SIZE];
-    } rx, tx = { cmd : MPUREG_INT_STATUS | 0x80, };
-
-    _spi->transaction((const uint8_t *)&tx, (uint8_t *)&rx, sizeof(rx));
-
-    if (!(rx.int_status & BIT_RAW_RDY_INT)) {
-        n_samples = 0;
-#if MPU9250_DEBUG
-        hal.console->printf("MPU9250: No sample available.\n");
-#endif
-        return false;
-    }
-
-    n_samples = 1;
-    memcpy(&samples[0], &rx.v[0], MPU9250_SAMPLE_SIZE);
-
-    return true;
-}
-
 AP_HAL::Semaphore* AP_MPU9250_BusDriver_SPI::get_semaphore()
 {
     return _spi->get_semaphore();
@@ -321,35 +313,6 @@ void AP_MPU9250_BusDriver_I2C::write8(uint8_t reg, uint8_t val)
     _i2c->writeRegister(_addr, reg, val);
 }
 
-bool AP_MPU9250_BusDriver_I2C::read_data_transaction(uint8_t *samples,
-                                                     uint8_t &n_samples)
-{
-    uint8_t ret = 0;
-    struct PACKED {
-        uint8_t int_status;
-        uint8_t v[MPU9250_SAMPLE_SIZE];
-    } buffer;
-
-    ret = _i2c->readRegisters(_addr, MPUREG_INT_STATUS, sizeof(buffer), (uint8_t *)&buffer);
-    if (ret != 0) {
-        hal.console->printf("MPU9250: error in I2C read\n");
-        n_samples = 0;
-        return false;
-    }
-
-    if (!(buffer.int_status & BIT_RAW_RDY_INT)) {
-#if MPU9250_DEBUG
-        hal.console->printf("MPU9250: No sample available.\n");
-#endif
-        n_samples = 0;
-        return false;
-    }
-
-    memcpy(samples, buffer.v, MPU9250_SAMPLE_SIZE);
-    n_samples = 1;
-    return true;
-}
-
 AP_HAL::Semaphore* AP_MPU9250_BusDriver_I2C::get_semaphore()
 {
     return _i2c->get_semaphore();
@@ -455,6 +418,9 @@ bool AP_InertialSensor_MPU9250::update( void )
     update_gyro(_gyro_instance);
     update_accel(_accel_instance);
 
+    _set_accel_error_count(_accel_instance, _lost_samples);
+    _set_gyro_error_count(_gyro_instance, _lost_samples);
+
     return true;
 }
 
@@ -479,37 +445,69 @@ void AP_InertialSensor_MPU9250::_poll_data(void)
 }
 
 /*
-  read from the data registers and update filtered data
+  empty the FIFO, keeping the other USER_CTRL settings such as the
+  auxiliary bus master
  */
-void AP_InertialSensor_MPU9250::_read_data_transaction() 
+void AP_InertialSensor_MPU9250::_fifo_reset()
 {
-    uint8_t n_samples;
-    uint8_t rx[MPU9250_SAMPLE_SIZE];
+    uint8_t user_ctrl = _register_read(MPUREG_USER_CTRL);
+    user_ctrl &= ~BIT_USER_CTRL_FIFO_EN;
+    _register_write(MPUREG_USER_CTRL, user_ctrl);
+    _register_write(MPUREG_USER_CTRL, user_ctrl | BIT_USER_CTRL_FIFO_RESET);
+    _register_write(MPUREG_USER_CTRL, user_ctrl | BIT_USER_CTRL_FIFO_EN);
+}
 
-    Vector3f accel, gyro;
+/*
+  read all the samples waiting in the FIFO in one transfer and feed
+  them through the filters
+ */
+void AP_InertialSensor_MPU9250::_read_data_transaction()
+{
+    uint8_t count[2];
+    _bus->read_block(MPUREG_FIFO_COUNTH, count, 2);
+    uint16_t bytes = uint16_val(count, 0);
+    if (bytes == 0) {
+        return;
+    }
 
-    if (!_bus->read_data_transaction(rx, n_samples)) {
+    /*
+      a count which isn't a whole number of samples, or which has
+      reached the size of the FIFO, means it overflowed and the
+      samples in it can't be trusted
+     */
+    if (bytes % MPU9250_SAMPLE_SIZE != 0 ||
+        bytes > MPU9250_FIFO_SIZE - MPU9250_SAMPLE_SIZE) {
+        _fifo_reset();
+        _lost_samples += bytes / MPU9250_SAMPLE_SIZE;
         return;
     }
 
-#define int16_val(v, idx) ((int16_t)(((uint16_t)v[2*idx] << 8) | v[2*idx+1]))
+    uint8_t n_samples = MIN(bytes / MPU9250_SAMPLE_SIZE, MPU9250_MAX_FIFO_SAMPLES);
+    uint8_t rx[MPU9250_MAX_FIFO_SAMPLES * MPU9250_SAMPLE_SIZE];
+
+    _bus->read_block(MPUREG_FIFO_R_W, rx, n_samples * MPU9250_SAMPLE_SIZE);
+
+    for (uint8_t i = 0; i < n_samples; i++) {
+        const uint8_t *data = &rx[i * MPU9250_SAMPLE_SIZE];
+        Vector3f accel, gyro;
 
-    accel = Vector3f(int16_val(rx, 1),
-                     int16_val(rx, 0),
-                     -int16_val(rx, 2));
-    accel *= MPU9250_ACCEL_SCALE_1G;
-    accel.rotate(_default_rotation);
-    _rotate_and_correct_accel(_accel_instance, accel);
-    _notify_new_accel_raw_sample(_accel_instance, accel);
+        accel = Vector3f(int16_val(data, 1),
+                         int16_val(data, 0),
+                         -int16_val(data, 2));
+        accel *= MPU9250_ACCEL_SCALE_1G;
+        accel.rotate(_default_rotation);
+        _rotate_and_correct_accel(_accel_instance, accel);
+        _notify_new_accel_raw_sample(_accel_instance, accel);
 
-    gyro = Vector3f(int16_val(rx, 5),
-                    int16_val(rx, 4),
-                    -int16_val(rx, 6));
-    gyro *= GYRO_SCALE;
-    gyro.rotate(_default_rotation);
+        gyro = Vector3f(int16_val(data, 5),
+                        int16_val(data, 4),
+                        -int16_val(data, 6));
+        gyro *= GYRO_SCALE;
+        gyro.rotate(_default_rotation);
 
-    _rotate_and_correct_gyro(_gyro_instance, gyro);
-    _notify_new_gyro_raw_sample(_gyro_instance, gyro);
+        _rotate_and_correct_gyro(_gyro_instance, gyro);
+        _notify_new_gyro_raw_sample(_gyro_instance, gyro);
+    }
 }
 
 /*
@@ -621,6 +619,15 @@ bool AP_InertialSensor_MPU9250::_hardware_init(void)
     value |= BIT_INT_RD_CLEAR | BIT_LATCH_INT_EN;
     _register_write(MPUREG_INT_PIN_CFG, value);
 
+    /*
+      read the samples through the FIFO, so that a late poll doesn't
+      lose samples and several samples come in one transfer. The FIFO
+      holds the same 14 byte samples as the data registers
+     */
+    _register_write(MPUREG_FIFO_EN, BIT_XG_FIFO_EN | BIT_YG_FIFO_EN |
+                                    BIT_ZG_FIFO_EN | BIT_ACCEL_FIFO_EN | BIT_TEMP_FIFO_EN);
+    _fifo_reset();
+
     // now that we have initialized, we set the SPI bus speed to high
     _bus->set_bus_speed(AP_HAL::SPIDeviceDriver::SPI_SPEED_HIGH);
 
@@ -26,8 +26,6 @@ public:
     virtual void write8(uint8_t reg, uint8_t val) = 0;
     virtual void read_block(uint8_t reg, uint8_t *val, uint8_t count) = 0;
     virtual void set_bus_speed(AP_HAL::SPIDeviceDriver::bus_speed speed) = 0;
-    virtual bool read_data_transaction(uint8_t* samples,
-                                       uint8_t &n_samples) = 0;
     virtual AP_HAL::Semaphore* get_semaphore() = 0;
     virtual bool has_auxiliary_bus() = 0;
 };
@@ -63,6 +61,7 @@ private:
 
     bool                 _init_sensor();
     void                 _read_data_transaction();
+    void                 _fifo_reset();
     bool                 _data_ready();
     void                 _poll_data(void);
     uint8_t              _register_read( uint8_t reg );
@@ -81,6 +80,9 @@ private:
     // placed by default on the system
     enum Rotation _default_rotation;
 
+    // samples lost to FIFO overflows, reported as the error count
+    uint32_t _lost_samples = 0;
+
 #if MPU9250_DEBUG
     static void _dump_registers();
 #endif
@@ -95,7 +97,6 @@ public:
     void write8(uint8_t reg, uint8_t val);
     void read_block(uint8_t reg, uint8_t *val, uint8_t count);
     void set_bus_speed(AP_HAL::SPIDeviceDriver::bus_speed speed);
-    bool read_data_transaction(uint8_t* samples, uint8_t &n_samples);
     AP_HAL::Semaphore* get_semaphore();
     bool has_auxiliary_bus();
 
@@ -112,7 +113,6 @@ public:
     void write8(uint8_t reg, uint8_t val);
     void read_block(uint8_t reg, uint8_t *val, uint8_t count);
     void set_bus_speed(AP_HAL::SPIDeviceDriver::bus_speed speed) {};
-    bool read_data_transaction(uint8_t* samples, uint8_t &n_samples);
     AP_HAL::Semaphore* get_semaphore();
     bool has_auxiliary_bus();
 
@@ -4,6 +4,7 @@
 /// @brief   Handles the MAVLINK command mission stack.  Reads and writes mission to storage.
 
 #include "AP_Mission.h"
+#include <stdlib.h>
 #include <AP_Terrain/AP_Terrain.h>
 
 const AP_Param::GroupInfo AP_Mission::var_info[] = {
@@ -46,6 +47,10 @@ void AP_Mission::init()
         AP_HAL::panic("AP_Mission Content must be 12 bytes");
     }
 
+#if AP_MISSION_CACHE_ENABLED
+    cache_load();
+#endif
+
     _last_change_time_ms = AP_HAL::millis();
 }
 
@@ -261,6 +266,15 @@ bool AP_Mission::get_next_nav_cmd(uint16_t start_index, Mission_Command& cmd)
 
     // search until the end of the mission command list
     while(cmd_index < (unsigned)_cmd_total) {
+#if AP_MISSION_CACHE_ENABLED
+        // skip straight over "do" commands
+        if (cmd_index < _cache_size) {
+            cmd_index = _cache_next_nav[cmd_index];
+            if (cmd_index >= (unsigned)_cmd_total) {
+                return false;
+            }
+        }
+#endif
         // get next command
         if (!get_next_cmd(cmd_index, cmd, false)) {
             // no more commands so return failure
@@ -419,23 +433,35 @@ bool AP_Mission::read_cmd_from_storage(uint16_t index, Mission_Command& cmd) con
         cmd.p1 = 0;
         cmd.content.location = _ahrs.get_home();
     }else{
-        // Find out proper location in memory by using the start_byte position + the index
-        // we can load a command, we don't process it yet
-        // read WP position
-        uint16_t pos_in_storage = 4 + (index * AP_MISSION_EEPROM_COMMAND_SIZE);
-
-        cmd.id = _storage.read_byte(pos_in_storage);
-        cmd.p1 = _storage.read_uint16(pos_in_storage+1);
-        _storage.read_block(cmd.content.bytes, pos_in_storage+3, 12);
-
-        // set command's index to it's position in eeprom
-        cmd.index = index;
+#if AP_MISSION_CACHE_ENABLED
+        if (index < _cache_size) {
+            cmd = _cache[index];
+            return true;
+        }
+#endif
+        load_cmd_from_storage_slot(index, cmd);
     }
 
     // return success
     return true;
 }
 
+/// load_cmd_from_storage_slot - reads the command in a storage slot, without any checks
+void AP_Mission::load_cmd_from_storage_slot(uint16_t index, Mission_Command& cmd) const
+{
+    // Find out proper location in memory by using the start_byte position + the index
+    // we can load a command, we don't process it yet
+    // read WP position
+    uint16_t pos_in_storage = 4 + (index * AP_MISSION_EEPROM_COMMAND_SIZE);
+
+    cmd.id = _storage.read_byte(pos_in_storage);
+    cmd.p1 = _storage.read_uint16(pos_in_storage+1);
+    _storage.read_block(cmd.content.bytes, pos_in_storage+3, 12);
+
+    // set command's index to it's position in eeprom
+    cmd.index = index;
+}
+
 /// write_cmd_to_storage - write a command to storage
 ///     index is used to calculate the storage location
 ///     true is returned if successful
@@ -453,6 +479,15 @@ bool AP_Mission::write_cmd_to_storage(uint16_t index, Mission_Command& cmd)
     _storage.write_uint16(pos_in_storage+1, cmd.p1);
     _storage.write_block(pos_in_storage+3, cmd.content.bytes, 12);
 
+#if AP_MISSION_CACHE_ENABLED
+    // keep the cache the same as storage
+    if (index < _cache_size) {
+        _cache[index] = cmd;
+        _cache[index].index = index;
+        cache_update_next_nav(index);
+    }
+#endif
+
     // remember when the mission last changed
     _last_change_time_ms = AP_HAL::millis();
 
@@ -1402,6 +1437,60 @@ void AP_Mission::check_eeprom_version()
     }
 }
 
+#if AP_MISSION_CACHE_ENABLED
+/*
+  allocate the cache and fill it from storage. Every slot is loaded,
+  not just the first MIS_TOTAL, so the cache stays the same as storage
+  whatever MIS_TOTAL is later set to. If there isn't the memory for it
+  commands continue to be read from storage
+ */
+void AP_Mission::cache_load()
+{
+    const uint16_t size = num_commands_max();
+    if (_cache == NULL) {
+        _cache = (Mission_Command *)calloc(size, sizeof(_cache[0]));
+        _cache_next_nav = (uint16_t *)calloc(size, sizeof(_cache_next_nav[0]));
+        if (_cache == NULL || _cache_next_nav == NULL) {
+            free(_cache);
+            free(_cache_next_nav);
+            _cache = NULL;
+            _cache_next_nav = NULL;
+            return;
+        }
+    }
+
+    uint16_t next_nav = AP_MISSION_CMD_INDEX_NONE;
+    for (int32_t i=size-1; i>=0; i--) {
+        load_cmd_from_storage_slot(i, _cache[i]);
+        if (cache_stops_nav_search(i)) {
+            next_nav = i;
+        }
+        _cache_next_nav[i] = next_nav;
+    }
+    _cache_size = size;
+}
+
+/*
+  the slots before index which pointed past it in the next nav table
+  may now need to point to it, or past it, as far back as the previous
+  nav or do-jump command
+ */
+void AP_Mission::cache_update_next_nav(uint16_t index)
+{
+    uint16_t next_nav = (index+1 < _cache_size) ? _cache_next_nav[index+1] : AP_MISSION_CMD_INDEX_NONE;
+    for (int32_t i=index; i>=0; i--) {
+        if (cache_stops_nav_search(i)) {
+            if (i < index) {
+                // slots before this one already point to it
+                break;
+            }
+            next_nav = i;
+        }
+        _cache_next_nav[i] = next_nav;
+    }
+}
+#endif // AP_MISSION_CACHE_ENABLED
+
 /*
   return total number of commands that can fit in storage space
  */
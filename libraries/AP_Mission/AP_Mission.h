@@ -7,6 +7,7 @@
  *   The AP_Mission library:
  *   - responsible for managing a list of commands made up of "nav", "do" and "conditional" commands
  *   - reads and writes the mission commands to storage.
+ *   - keeps a copy of the commands in RAM on boards with memory to spare, so storage is only read at boot
  *   - provides easy acces to current, previous and upcoming waypoints
  *   - calls main program's command execution and verify functions.
  *   - accounts for the DO_JUMP command
@@ -40,6 +41,13 @@
 
 #define AP_MISSION_RESTART_DEFAULT          0       // resume the mission from the last command run by default
 
+// keep a copy of every command slot in RAM (17 bytes each, plus 2 for
+// the next nav command table) so the mission is never read from
+// storage in flight
+#ifndef AP_MISSION_CACHE_ENABLED
+#define AP_MISSION_CACHE_ENABLED (HAL_CPU_CLASS >= HAL_CPU_CLASS_1000)
+#endif
+
 /// @class    AP_Mission
 /// @brief    Object managing Mission
 class AP_Mission {
@@ -253,6 +261,12 @@ public:
         _flags.state = MISSION_STOPPED;
         _flags.nav_cmd_loaded = false;
         _flags.do_cmd_loaded = false;
+
+#if AP_MISSION_CACHE_ENABLED
+        _cache = NULL;
+        _cache_next_nav = NULL;
+        _cache_size = 0;
+#endif
     }
 
     ///
@@ -440,6 +454,22 @@ private:
     /// command list will be cleared if they do not match
     void check_eeprom_version();
 
+    /// load_cmd_from_storage_slot - reads the command in a storage slot, without any checks
+    void load_cmd_from_storage_slot(uint16_t index, Mission_Command& cmd) const;
+
+#if AP_MISSION_CACHE_ENABLED
+    /// cache_load - allocates the cache and reads every command slot from storage into it
+    void cache_load();
+
+    /// cache_update_next_nav - updates the next nav command table after the command at index has changed
+    void cache_update_next_nav(uint16_t index);
+
+    /// cache_stops_nav_search - returns true if get_next_nav_cmd() must look at this slot rather than skip over it
+    bool cache_stops_nav_search(uint16_t index) const {
+        return index == 0 || is_nav_cmd(_cache[index]) || _cache[index].id == MAV_CMD_DO_JUMP;
+    }
+#endif
+
     // references to external libraries
     const AP_AHRS&   _ahrs;      // used only for home position
 
@@ -466,6 +496,13 @@ private:
 
     // last time that mission changed
     uint32_t _last_change_time_ms;
+
+#if AP_MISSION_CACHE_ENABLED
+    // copy of the commands in storage
+    Mission_Command *_cache;        // every command slot in storage, NULL if it could not be allocated
+    uint16_t *_cache_next_nav;      // for each slot, the first slot at or after it holding a nav or do-jump command
+    uint16_t _cache_size;           // number of slots in the cache, zero until it is loaded
+#endif
 };
 
 #endif
@@ -185,11 +185,16 @@ void AP_MotorsHeli::Init()
 // output_min - sets servos to neutral point with motors stopped
 void AP_MotorsHeli::output_min()
 {
+    // send the servo and rotor outputs together
+    hal.rcout->cork();
+
     // move swash to mid
     move_actuators(0,0,500,0);
 
     update_motor_control(ROTOR_CONTROL_STOP);
 
+    hal.rcout->push();
+
     // override limits flags
     limit.roll_pitch = true;
     limit.yaw = true;
@@ -203,6 +208,9 @@ void AP_MotorsHeli::output()
     // update throttle filter
     update_throttle_filter();
 
+    // send the swash, tail, aux and rotor outputs together
+    hal.rcout->cork();
+
     if (_flags.armed) {
         calculate_armed_scalars();
         if (!_flags.interlock) {
@@ -215,6 +223,8 @@ void AP_MotorsHeli::output()
     } else {
         output_disarmed();
     }
+
+    hal.rcout->push();
 };
 
 // sends commands to the motors
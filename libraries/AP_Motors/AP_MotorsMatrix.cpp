@@ -176,24 +176,10 @@ void AP_MotorsMatrix::output_armed_not_stabilizing()
 void AP_MotorsMatrix::output_armed_stabilizing()
 {
     int8_t i;
-    int16_t roll_pwm;                                               // roll pwm value, initially calculated by calc_roll_pwm() but may be modified after, +/- 400
-    int16_t pitch_pwm;                                              // pitch pwm value, initially calculated by calc_roll_pwm() but may be modified after, +/- 400
-    int16_t yaw_pwm;                                                // yaw pwm value, initially calculated by calc_yaw_pwm() but may be modified after, +/- 400
-    int16_t throttle_radio_output;                                  // total throttle pwm value, summed onto throttle channel minimum, typically ~1100-1900
     int16_t out_min_pwm = _throttle_radio_min + _min_throttle;      // minimum pwm value we can send to the motors
     int16_t out_max_pwm = _throttle_radio_max;                      // maximum pwm value we can send to the motors
-    int16_t out_mid_pwm = (out_min_pwm+out_max_pwm)/2;              // mid pwm value we can send to the motors
-    int16_t out_best_thr_pwm;                                       // the is the best throttle we can come up which provides good control without climbing
-    float rpy_scale = 1.0;                                          // this is used to scale the roll, pitch and yaw to fit within the motor limits
-
-    int16_t rpy_out[AP_MOTORS_MAX_NUM_MOTORS]; // buffer so we don't have to multiply coefficients multiple times.
     int16_t motor_out[AP_MOTORS_MAX_NUM_MOTORS];    // final outputs sent to the motors
 
-    int16_t rpy_low = 0;    // lowest motor value
-    int16_t rpy_high = 0;   // highest motor value
-    int16_t yaw_allowed;    // amount of yaw we can fit in
-    int16_t thr_adj;        // the difference between the pilot's desired throttle and out_best_thr_pwm (the throttle that is actually provided)
-
     // initialize limits flags
     limit.roll_pitch = false;
     limit.yaw = false;
@@ -211,137 +197,30 @@ void AP_MotorsMatrix::output_armed_stabilizing()
         limit.throttle_upper = true;
     }
 
-    roll_pwm = calc_roll_pwm();
-    pitch_pwm = calc_pitch_pwm();
-    yaw_pwm = calc_yaw_pwm();
-    throttle_radio_output = calc_throttle_radio_output();
-
-    // calculate roll and pitch for each motor
-    // set rpy_low and rpy_high to the lowest and highest values of the motors
-    for (i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
-        if (motor_enabled[i]) {
-            rpy_out[i] = roll_pwm * _roll_factor[i] * get_compensation_gain() +
-                            pitch_pwm * _pitch_factor[i] * get_compensation_gain();
-
-            // record lowest roll pitch command
-            if (rpy_out[i] < rpy_low) {
-                rpy_low = rpy_out[i];
-            }
-            // record highest roll pich command
-            if (rpy_out[i] > rpy_high) {
-                rpy_high = rpy_out[i];
-            }
-        }
-    }
-
-    // calculate throttle that gives most possible room for yaw (range 1000 ~ 2000) which is the lower of:
-    //      1. mid throttle - average of highest and lowest motor (this would give the maximum possible room margin above the highest motor and below the lowest)
-    //      2. the higher of:
-    //            a) the pilot's throttle input
-    //            b) the mid point between the pilot's input throttle and hover-throttle
-    //      Situation #2 ensure we never increase the throttle above hover throttle unless the pilot has commanded this.
-    //      Situation #2b allows us to raise the throttle above what the pilot commanded but not so far that it would actually cause the copter to rise.
-    //      We will choose #1 (the best throttle for yaw control) if that means reducing throttle to the motors (i.e. we favour reducing throttle *because* it provides better yaw control)
-    //      We will choose #2 (a mix of pilot and hover throttle) only when the throttle is quite low.  We favour reducing throttle instead of better yaw control because the pilot has commanded it
-    int16_t motor_mid = (rpy_low+rpy_high)/2;
-    out_best_thr_pwm = MIN(out_mid_pwm - motor_mid, MAX(throttle_radio_output, throttle_radio_output*MAX(0,1.0f-_throttle_thr_mix)+get_hover_throttle_as_pwm()*_throttle_thr_mix));
-
-    // calculate amount of yaw we can fit into the throttle range
-    // this is always equal to or less than the requested yaw from the pilot or rate controller
-    yaw_allowed = MIN(out_max_pwm - out_best_thr_pwm, out_best_thr_pwm - out_min_pwm) - (rpy_high-rpy_low)/2;
-    yaw_allowed = MAX(yaw_allowed, _yaw_headroom);
-
-    if (yaw_pwm >= 0) {
-        // if yawing right
-        if (yaw_allowed > yaw_pwm * get_compensation_gain()) {
-            yaw_allowed = yaw_pwm * get_compensation_gain(); // to-do: this is bad form for yaw_allows to change meaning to become the amount that we are going to output
-        }else{
-            limit.yaw = true;
-        }
-    }else{
-        // if yawing left
-        yaw_allowed = -yaw_allowed;
-        if (yaw_allowed < yaw_pwm * get_compensation_gain()) {
-            yaw_allowed = yaw_pwm * get_compensation_gain(); // to-do: this is bad form for yaw_allows to change meaning to become the amount that we are going to output
-        }else{
-            limit.yaw = true;
-        }
-    }
-
-    // add yaw to intermediate numbers for each motor
-    rpy_low = 0;
-    rpy_high = 0;
-    for (i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
-        if (motor_enabled[i]) {
-            rpy_out[i] =    rpy_out[i] +
-                            yaw_allowed * _yaw_factor[i];
-
-            // record lowest roll+pitch+yaw command
-            if( rpy_out[i] < rpy_low ) {
-                rpy_low = rpy_out[i];
-            }
-            // record highest roll+pitch+yaw command
-            if( rpy_out[i] > rpy_high) {
-                rpy_high = rpy_out[i];
-            }
-        }
-    }
-
-    // check everything fits
-    thr_adj = throttle_radio_output - out_best_thr_pwm;
-
-    // calculate upper and lower limits of thr_adj
-    int16_t thr_adj_max = MAX(out_max_pwm-(out_best_thr_pwm+rpy_high),0);
-
-    // if we are increasing the throttle (situation #2 above)..
-    if (thr_adj > 0) {
-        // increase throttle as close as possible to requested throttle
-        // without going over out_max_pwm
-        if (thr_adj > thr_adj_max){
-            thr_adj = thr_adj_max;
-            // we haven't even been able to apply full throttle command
-            limit.throttle_upper = true;
-        }
-    }else if(thr_adj < 0){
-        // decrease throttle as close as possible to requested throttle
-        // without going under out_min_pwm or over out_max_pwm
-        // earlier code ensures we can't break both boundaries
-        int16_t thr_adj_min = MIN(out_min_pwm-(out_best_thr_pwm+rpy_low),0);
-        if (thr_adj > thr_adj_max) {
-            thr_adj = thr_adj_max;
-            limit.throttle_upper = true;
-        }
-        if (thr_adj < thr_adj_min) {
-            thr_adj = thr_adj_min;
-        }
-    }
-
-    // do we need to reduce roll, pitch, yaw command
-    // earlier code does not allow both limit's to be passed simultaneously with abs(_yaw_factor)<1
-    if ((rpy_low+out_best_thr_pwm)+thr_adj < out_min_pwm){
-        // protect against divide by zero
-        if (rpy_low != 0) {
-            rpy_scale = (float)(out_min_pwm-thr_adj-out_best_thr_pwm)/rpy_low;
-        }
-        // we haven't even been able to apply full roll, pitch and minimal yaw without scaling
-        limit.roll_pitch = true;
-        limit.yaw = true;
-    }else if((rpy_high+out_best_thr_pwm)+thr_adj > out_max_pwm){
-        // protect against divide by zero
-        if (rpy_high != 0) {
-            rpy_scale = (float)(out_max_pwm-thr_adj-out_best_thr_pwm)/rpy_high;
-        }
-        // we haven't even been able to apply full roll, pitch and minimal yaw without scaling
+    AP_MotorsMixer::inputs in;
+    in.roll = calc_roll_pwm();
+    in.pitch = calc_pitch_pwm();
+    in.yaw = calc_yaw_pwm();
+    in.throttle = calc_throttle_radio_output();
+    in.gain = get_compensation_gain();
+    in.out_min = out_min_pwm;
+    in.out_max = out_max_pwm;
+    in.hover_throttle = get_hover_throttle_as_pwm();
+    in.throttle_thr_mix = _throttle_thr_mix;
+    in.yaw_headroom = _yaw_headroom;
+
+    // mix roll, pitch and yaw for each motor around the throttle which
+    // leaves the most room for them, scaling them down if they don't fit
+    AP_MotorsMixer::limits mix_limit;
+    _mixer.mix(in, motor_out, mix_limit);
+    if (mix_limit.roll_pitch) {
         limit.roll_pitch = true;
+    }
+    if (mix_limit.yaw) {
         limit.yaw = true;
     }
-
-    // add scaled roll, pitch, constrained yaw and throttle for each motor
-    for (i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
-        if (motor_enabled[i]) {
-            motor_out[i] = out_best_thr_pwm+thr_adj +
-                            rpy_scale*rpy_out[i];
-        }
+    if (mix_limit.throttle_upper) {
+        limit.throttle_upper = true;
     }
 
     // apply thrust curve and voltage scaling
@@ -408,9 +287,7 @@ void AP_MotorsMatrix::add_motor_raw(int8_t motor_num, float roll_fac, float pitc
         }
 
         // set roll, pitch, thottle factors and opposite motor (for stability patch)
-        _roll_factor[motor_num] = roll_fac;
-        _pitch_factor[motor_num] = pitch_fac;
-        _yaw_factor[motor_num] = yaw_fac;
+        _mixer.set_motor(motor_num, roll_fac, pitch_fac, yaw_fac);
 
         // set order that motor appears in test
         _test_order[motor_num] = testing_order;
@@ -444,9 +321,7 @@ void AP_MotorsMatrix::remove_motor(int8_t motor_num)
     if( motor_num >= 0 && motor_num < AP_MOTORS_MAX_NUM_MOTORS ) {
         // disable the motor, set all factors to zero
         motor_enabled[motor_num] = false;
-        _roll_factor[motor_num] = 0;
-        _pitch_factor[motor_num] = 0;
-        _yaw_factor[motor_num] = 0;
+        _mixer.clear_motor(motor_num);
     }
 }
 
@@ -0,0 +1,242 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ *       AP_MotorsMixer.cpp - roll, pitch and yaw mixing for matrix frames
+ */
+
+#include <string.h>
+
+#include "AP_MotorsMixer.h"
+
+static_assert(AP_MotorsMixer::LANES % 4 == 0, "mixer lanes must be whole vectors");
+
+/*
+  four float lanes. Only operations which round exactly as the scalar
+  code does are used: no fused multiply-add and no reassociation
+ */
+#if defined(__SSE2__)
+#include <emmintrin.h>
+
+typedef __m128 vec4;
+
+static inline vec4 v_load(const float *p) { return _mm_loadu_ps(p); }
+static inline void v_store(float *p, vec4 a) { _mm_storeu_ps(p, a); }
+static inline vec4 v_set(float f) { return _mm_set1_ps(f); }
+static inline vec4 v_add(vec4 a, vec4 b) { return _mm_add_ps(a, b); }
+static inline vec4 v_mul(vec4 a, vec4 b) { return _mm_mul_ps(a, b); }
+static inline vec4 v_min(vec4 a, vec4 b) { return _mm_min_ps(a, b); }
+static inline vec4 v_max(vec4 a, vec4 b) { return _mm_max_ps(a, b); }
+// round towards zero, as assigning to an int16_t does
+static inline vec4 v_trunc(vec4 a) { return _mm_cvtepi32_ps(_mm_cvttps_epi32(a)); }
+
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+
+typedef float32x4_t vec4;
+
+static inline vec4 v_load(const float *p) { return vld1q_f32(p); }
+static inline void v_store(float *p, vec4 a) { vst1q_f32(p, a); }
+static inline vec4 v_set(float f) { return vdupq_n_f32(f); }
+static inline vec4 v_add(vec4 a, vec4 b) { return vaddq_f32(a, b); }
+static inline vec4 v_mul(vec4 a, vec4 b) { return vmulq_f32(a, b); }
+static inline vec4 v_min(vec4 a, vec4 b) { return vminq_f32(a, b); }
+static inline vec4 v_max(vec4 a, vec4 b) { return vmaxq_f32(a, b); }
+static inline vec4 v_trunc(vec4 a) { return vcvtq_f32_s32(vcvtq_s32_f32(a)); }
+
+#else
+
+struct vec4 {
+    float v[4];
+};
+
+static inline vec4 v_load(const float *p) { vec4 r; memcpy(r.v, p, sizeof(r.v)); return r; }
+static inline void v_store(float *p, vec4 a) { memcpy(p, a.v, sizeof(a.v)); }
+static inline vec4 v_set(float f) { vec4 r = {{ f, f, f, f }}; return r; }
+static inline vec4 v_add(vec4 a, vec4 b) { for (uint8_t i=0; i<4; i++) { a.v[i] += b.v[i]; } return a; }
+static inline vec4 v_mul(vec4 a, vec4 b) { for (uint8_t i=0; i<4; i++) { a.v[i] *= b.v[i]; } return a; }
+static inline vec4 v_min(vec4 a, vec4 b) { for (uint8_t i=0; i<4; i++) { a.v[i] = MIN(a.v[i], b.v[i]); } return a; }
+static inline vec4 v_max(vec4 a, vec4 b) { for (uint8_t i=0; i<4; i++) { a.v[i] = MAX(a.v[i], b.v[i]); } return a; }
+static inline vec4 v_trunc(vec4 a) { for (uint8_t i=0; i<4; i++) { a.v[i] = (int32_t)a.v[i]; } return a; }
+
+#endif
+
+static inline float v_hmin(vec4 a)
+{
+    float f[4];
+    v_store(f, a);
+    return MIN(MIN(f[0], f[1]), MIN(f[2], f[3]));
+}
+
+static inline float v_hmax(vec4 a)
+{
+    float f[4];
+    v_store(f, a);
+    return MAX(MAX(f[0], f[1]), MAX(f[2], f[3]));
+}
+
+void AP_MotorsMixer::set_motor(uint8_t motor, float roll_fac, float pitch_fac, float yaw_fac)
+{
+    if (motor >= AP_MOTORS_MAX_NUM_MOTORS) {
+        return;
+    }
+    _factor[AXIS_ROLL][motor] = roll_fac;
+    _factor[AXIS_PITCH][motor] = pitch_fac;
+    _factor[AXIS_YAW][motor] = yaw_fac;
+}
+
+void AP_MotorsMixer::clear()
+{
+    memset(_factor, 0, sizeof(_factor));
+}
+
+/*
+  The unused lanes come out as zero, and the lowest and highest values
+  start from zero, so they can be included in every pass without
+  changing the result
+ */
+void AP_MotorsMixer::mix(const struct inputs &in, int16_t motor_out[AP_MOTORS_MAX_NUM_MOTORS], struct limits &limit) const
+{
+    float rpy_out[LANES];       // roll, pitch and yaw of each motor, truncated to whole pwm values
+    float out[LANES];
+    int16_t out_mid_pwm = (in.out_min+in.out_max)/2;
+    int16_t out_best_thr_pwm;
+    float rpy_scale = 1.0;
+    int16_t yaw_allowed;
+    int16_t thr_adj;
+    uint8_t i;
+
+    limit.roll_pitch = false;
+    limit.yaw = false;
+    limit.throttle_upper = false;
+
+    // calculate roll and pitch for each motor and the lowest and highest of them
+    const vec4 roll = v_set(in.roll);
+    const vec4 pitch = v_set(in.pitch);
+    const vec4 gain = v_set(in.gain);
+    vec4 low = v_set(0);
+    vec4 high = v_set(0);
+    for (i=0; i<LANES; i+=4) {
+        const vec4 rp = v_trunc(v_add(v_mul(v_mul(roll, v_load(&_factor[AXIS_ROLL][i])), gain),
+                                      v_mul(v_mul(pitch, v_load(&_factor[AXIS_PITCH][i])), gain)));
+        v_store(&rpy_out[i], rp);
+        low = v_min(low, rp);
+        high = v_max(high, rp);
+    }
+    int16_t rpy_low = v_hmin(low);
+    int16_t rpy_high = v_hmax(high);
+
+    // calculate throttle that gives most possible room for yaw (range 1000 ~ 2000) which is the lower of:
+    //      1. mid throttle - average of highest and lowest motor (this would give the maximum possible room margin above the highest motor and below the lowest)
+    //      2. the higher of:
+    //            a) the pilot's throttle input
+    //            b) the mid point between the pilot's input throttle and hover-throttle
+    //      Situation #2 ensure we never increase the throttle above hover throttle unless the pilot has commanded this.
+    //      Situation #2b allows us to raise the throttle above what the pilot commanded but not so far that it would actually cause the copter to rise.
+    //      We will choose #1 (the best throttle for yaw control) if that means reducing throttle to the motors (i.e. we favour reducing throttle *because* it provides better yaw control)
+    //      We will choose #2 (a mix of pilot and hover throttle) only when the throttle is quite low.  We favour reducing throttle instead of better yaw control because the pilot has commanded it
+    int16_t motor_mid = (rpy_low+rpy_high)/2;
+    out_best_thr_pwm = MIN(out_mid_pwm - motor_mid, MAX(in.throttle, in.throttle*MAX(0,1.0f-in.throttle_thr_mix)+in.hover_throttle*in.throttle_thr_mix));
+
+    // calculate amount of yaw we can fit into the throttle range
+    // this is always equal to or less than the requested yaw from the pilot or rate controller
+    yaw_allowed = MIN(in.out_max - out_best_thr_pwm, out_best_thr_pwm - in.out_min) - (rpy_high-rpy_low)/2;
+    yaw_allowed = MAX(yaw_allowed, in.yaw_headroom);
+
+    if (in.yaw >= 0) {
+        // if yawing right
+        if (yaw_allowed > in.yaw * in.gain) {
+            yaw_allowed = in.yaw * in.gain;
+        }else{
+            limit.yaw = true;
+        }
+    }else{
+        // if yawing left
+        yaw_allowed = -yaw_allowed;
+        if (yaw_allowed < in.yaw * in.gain) {
+            yaw_allowed = in.yaw * in.gain;
+        }else{
+            limit.yaw = true;
+        }
+    }
+
+    // add yaw to each motor
+    const vec4 yaw = v_set(yaw_allowed);
+    low = v_set(0);
+    high = v_set(0);
+    for (i=0; i<LANES; i+=4) {
+        const vec4 rpy = v_trunc(v_add(v_load(&rpy_out[i]), v_mul(yaw, v_load(&_factor[AXIS_YAW][i]))));
+        v_store(&rpy_out[i], rpy);
+        low = v_min(low, rpy);
+        high = v_max(high, rpy);
+    }
+    rpy_low = v_hmin(low);
+    rpy_high = v_hmax(high);
+
+    // check everything fits
+    thr_adj = in.throttle - out_best_thr_pwm;
+
+    // calculate upper and lower limits of thr_adj
+    int16_t thr_adj_max = MAX(in.out_max-(out_best_thr_pwm+rpy_high),0);
+
+    // if we are increasing the throttle (situation #2 above)..
+    if (thr_adj > 0) {
+        // increase throttle as close as possible to requested throttle
+        // without going over out_max
+        if (thr_adj > thr_adj_max){
+            thr_adj = thr_adj_max;
+            limit.throttle_upper = true;
+        }
+    }else if(thr_adj < 0){
+        // decrease throttle as close as possible to requested throttle
+        // without going under out_min or over out_max
+        int16_t thr_adj_min = MIN(in.out_min-(out_best_thr_pwm+rpy_low),0);
+        if (thr_adj > thr_adj_max) {
+            thr_adj = thr_adj_max;
+            limit.throttle_upper = true;
+        }
+        if (thr_adj < thr_adj_min) {
+            thr_adj = thr_adj_min;
+        }
+    }
+
+    // do we need to reduce roll, pitch, yaw command
+    if ((rpy_low+out_best_thr_pwm)+thr_adj < in.out_min){
+        // protect against divide by zero
+        if (rpy_low != 0) {
+            rpy_scale = (float)(in.out_min-thr_adj-out_best_thr_pwm)/rpy_low;
+        }
+        limit.roll_pitch = true;
+        limit.yaw = true;
+    }else if((rpy_high+out_best_thr_pwm)+thr_adj > in.out_max){
+        // protect against divide by zero
+        if (rpy_high != 0) {
+            rpy_scale = (float)(in.out_max-thr_adj-out_best_thr_pwm)/rpy_high;
+        }
+        limit.roll_pitch = true;
+        limit.yaw = true;
+    }
+
+    // add scaled roll, pitch, constrained yaw and throttle for each motor
+    const vec4 thr = v_set(out_best_thr_pwm+thr_adj);
+    const vec4 scale = v_set(rpy_scale);
+    for (i=0; i<LANES; i+=4) {
+        v_store(&out[i], v_add(thr, v_mul(scale, v_load(&rpy_out[i]))));
+    }
+    for (i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
+        motor_out[i] = out[i];
+    }
+}
@@ -0,0 +1,75 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+/// @file	AP_MotorsMixer.h
+/// @brief	Roll, pitch and yaw mixing for AP_MotorsMatrix
+
+#ifndef __AP_MOTORS_MIXER_H__
+#define __AP_MOTORS_MIXER_H__
+
+#include <AP_Common/AP_Common.h>
+#include "AP_Motors_Class.h"
+
+/// @class      AP_MotorsMixer
+/// @brief      The mixing matrix of a multicopter and the solver which fits
+///             its output within the range of the motors
+///
+/// The factors are kept as one column per axis, padded with zeros to a
+/// whole number of four float lanes, so each pass over the motors is a
+/// few vector operations on CPUs with SSE or NEON. Motors which aren't
+/// in use have zero factors and so don't affect the result. The output
+/// is the same, bit for bit, as the per motor loops AP_MotorsMatrix
+/// used before, including the truncation to whole pwm values between
+/// passes.
+class AP_MotorsMixer {
+public:
+    // motors rounded up to a whole number of vectors
+    static const uint8_t LANES = (AP_MOTORS_MAX_NUM_MOTORS + 3) & ~3;
+
+    enum axis {
+        AXIS_ROLL = 0,
+        AXIS_PITCH,
+        AXIS_YAW,
+        AXIS_COUNT
+    };
+
+    // everything mix() needs to know for one output, in pwm
+    struct inputs {
+        int16_t roll;               // roll command, +/- 400 typically
+        int16_t pitch;              // pitch command
+        int16_t yaw;                // yaw command
+        int16_t throttle;           // throttle output requested, 1000 ~ 2000 typically
+        float   gain;               // compensation gain applied to roll, pitch and yaw
+        int16_t out_min;            // lowest pwm the motors may be sent
+        int16_t out_max;            // highest pwm the motors may be sent
+        int16_t hover_throttle;     // throttle needed to hover
+        float   throttle_thr_mix;   // mix between throttle and hover throttle
+        int16_t yaw_headroom;       // yaw is given at least this range
+    };
+
+    // which commands couldn't be met in full
+    struct limits {
+        bool roll_pitch;
+        bool yaw;
+        bool throttle_upper;
+    };
+
+    AP_MotorsMixer() { clear(); }
+
+    // set the factors of one motor
+    void set_motor(uint8_t motor, float roll_fac, float pitch_fac, float yaw_fac);
+
+    // zero the factors of one motor or of all motors
+    void clear_motor(uint8_t motor) { set_motor(motor, 0, 0, 0); }
+    void clear();
+
+    float get_factor(enum axis a, uint8_t motor) const { return _factor[a][motor]; }
+
+    // mix the inputs into a pwm value for each motor, before the
+    // thrust curve. Entries for motors not in use should be ignored
+    void mix(const struct inputs &in, int16_t motor_out[AP_MOTORS_MAX_NUM_MOTORS], struct limits &limit) const;
+
+private:
+    float _factor[AXIS_COUNT][LANES];
+};
+
+#endif  // __AP_MOTORS_MIXER_H__
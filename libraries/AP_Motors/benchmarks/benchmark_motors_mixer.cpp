@@ -0,0 +1,58 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_Math/AP_Math.h>
+#include <AP_Motors/AP_MotorsMixer.h>
+
+/*
+  mix one output of a quad and an octa, as AP_MotorsMatrix does on
+  every loop. The roll command alternates between a request which fits
+  and one which has to be scaled down
+ */
+static void setup_frame(AP_MotorsMixer &mixer, uint8_t num_motors)
+{
+    for (uint8_t i=0; i<num_motors; i++) {
+        const float angle = 45 + i * 360.0f / num_motors;
+        mixer.set_motor(i, cosf(radians(angle + 90)), cosf(radians(angle)), (i & 1) ? 1 : -1);
+    }
+}
+
+static void mix_frame(benchmark::State& state, uint8_t num_motors)
+{
+    AP_MotorsMixer mixer;
+    setup_frame(mixer, num_motors);
+
+    AP_MotorsMixer::inputs in;
+    in.roll = 120;
+    in.pitch = -80;
+    in.yaw = 40;
+    in.throttle = 1450;
+    in.gain = 1.05f;
+    in.out_min = 1130;
+    in.out_max = 1900;
+    in.hover_throttle = 1500;
+    in.throttle_thr_mix = 0.5f;
+    in.yaw_headroom = 200;
+
+    int16_t motor_out[AP_MOTORS_MAX_NUM_MOTORS];
+    AP_MotorsMixer::limits limit;
+    while (state.KeepRunning()) {
+        mixer.mix(in, motor_out, limit);
+        gbenchmark_escape(motor_out);
+        in.roll = in.roll == 120 ? 900 : 120;
+    }
+}
+
+static void BM_MotorsMixerQuad(benchmark::State& state)
+{
+    mix_frame(state, 4);
+}
+
+static void BM_MotorsMixerOcta(benchmark::State& state)
+{
+    mix_frame(state, 8);
+}
+
+BENCHMARK(BM_MotorsMixerQuad);
+BENCHMARK(BM_MotorsMixerOcta);
+
+BENCHMARK_MAIN()
@@ -0,0 +1,246 @@
+#include <AP_gtest.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <AP_Math/AP_Math.h>
+#include <AP_Motors/AP_MotorsMixer.h>
+
+#define NUM_SAMPLES 20000
+
+/*
+  the per motor mixing AP_MotorsMatrix::output_armed_stabilizing() did
+  before AP_MotorsMixer, kept to check the mixer against
+ */
+class ReferenceMixer {
+public:
+    ReferenceMixer() {
+        memset(enabled, 0, sizeof(enabled));
+    }
+
+    void add_motor(uint8_t motor, float angle_degrees, float yaw_fac) {
+        enabled[motor] = true;
+        roll_factor[motor] = cosf(radians(angle_degrees + 90));
+        pitch_factor[motor] = cosf(radians(angle_degrees));
+        yaw_factor[motor] = yaw_fac;
+    }
+
+    void mix(const AP_MotorsMixer::inputs &in, int16_t motor_out[], AP_MotorsMixer::limits &limit) const {
+        int16_t out_mid_pwm = (in.out_min+in.out_max)/2;
+        int16_t out_best_thr_pwm;
+        float rpy_scale = 1.0;
+        int16_t rpy_out[AP_MOTORS_MAX_NUM_MOTORS];
+        int16_t rpy_low = 0;
+        int16_t rpy_high = 0;
+        int16_t yaw_allowed;
+        int16_t thr_adj;
+        uint8_t i;
+
+        limit.roll_pitch = false;
+        limit.yaw = false;
+        limit.throttle_upper = false;
+
+        for (i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
+            if (enabled[i]) {
+                rpy_out[i] = in.roll * roll_factor[i] * in.gain +
+                             in.pitch * pitch_factor[i] * in.gain;
+                if (rpy_out[i] < rpy_low) {
+                    rpy_low = rpy_out[i];
+                }
+                if (rpy_out[i] > rpy_high) {
+                    rpy_high = rpy_out[i];
+                }
+            }
+        }
+
+        int16_t motor_mid = (rpy_low+rpy_high)/2;
+        out_best_thr_pwm = MIN(out_mid_pwm - motor_mid, MAX(in.throttle, in.throttle*MAX(0,1.0f-in.throttle_thr_mix)+in.hover_throttle*in.throttle_thr_mix));
+
+        yaw_allowed = MIN(in.out_max - out_best_thr_pwm, out_best_thr_pwm - in.out_min) - (rpy_high-rpy_low)/2;
+        yaw_allowed = MAX(yaw_allowed, in.yaw_headroom);
+
+        if (in.yaw >= 0) {
+            if (yaw_allowed > in.yaw * in.gain) {
+                yaw_allowed = in.yaw * in.gain;
+            }else{
+                limit.yaw = true;
+            }
+        }else{
+            yaw_allowed = -yaw_allowed;
+            if (yaw_allowed < in.yaw * in.gain) {
+                yaw_allowed = in.yaw * in.gain;
+            }else{
+                limit.yaw = true;
+            }
+        }
+
+        rpy_low = 0;
+        rpy_high = 0;
+        for (i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
+            if (enabled[i]) {
+                rpy_out[i] = rpy_out[i] + yaw_allowed * yaw_factor[i];
+                if (rpy_out[i] < rpy_low) {
+                    rpy_low = rpy_out[i];
+                }
+                if (rpy_out[i] > rpy_high) {
+                    rpy_high = rpy_out[i];
+                }
+            }
+        }
+
+        thr_adj = in.throttle - out_best_thr_pwm;
+        int16_t thr_adj_max = MAX(in.out_max-(out_best_thr_pwm+rpy_high),0);
+        if (thr_adj > 0) {
+            if (thr_adj > thr_adj_max){
+                thr_adj = thr_adj_max;
+                limit.throttle_upper = true;
+            }
+        }else if(thr_adj < 0){
+            int16_t thr_adj_min = MIN(in.out_min-(out_best_thr_pwm+rpy_low),0);
+            if (thr_adj > thr_adj_max) {
+                thr_adj = thr_adj_max;
+                limit.throttle_upper = true;
+            }
+            if (thr_adj < thr_adj_min) {
+                thr_adj = thr_adj_min;
+            }
+        }
+
+        if ((rpy_low+out_best_thr_pwm)+thr_adj < in.out_min){
+            if (rpy_low != 0) {
+                rpy_scale = (float)(in.out_min-thr_adj-out_best_thr_pwm)/rpy_low;
+            }
+            limit.roll_pitch = true;
+            limit.yaw = true;
+        }else if((rpy_high+out_best_thr_pwm)+thr_adj > in.out_max){
+            if (rpy_high != 0) {
+                rpy_scale = (float)(in.out_max-thr_adj-out_best_thr_pwm)/rpy_high;
+            }
+            limit.roll_pitch = true;
+            limit.yaw = true;
+        }
+
+        for (i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
+            if (enabled[i]) {
+                motor_out[i] = out_best_thr_pwm+thr_adj + rpy_scale*rpy_out[i];
+            }
+        }
+    }
+
+    bool enabled[AP_MOTORS_MAX_NUM_MOTORS];
+    float roll_factor[AP_MOTORS_MAX_NUM_MOTORS];
+    float pitch_factor[AP_MOTORS_MAX_NUM_MOTORS];
+    float yaw_factor[AP_MOTORS_MAX_NUM_MOTORS];
+};
+
+struct frame_motor {
+    uint8_t motor;
+    float angle;
+    float yaw;
+};
+
+static const frame_motor quad_x[] = {
+    { 0, 45, 1 }, { 1, -135, 1 }, { 2, -45, -1 }, { 3, 135, -1 },
+};
+
+static const frame_motor hexa_plus[] = {
+    { 0, 0, -1 }, { 1, 180, 1 }, { 2, -120, -1 }, { 3, 60, 1 }, { 4, -60, 1 }, { 5, 120, -1 },
+};
+
+static const frame_motor octa_plus[] = {
+    { 0, 0, -1 }, { 1, 180, -1 }, { 2, 45, 1 }, { 3, 135, 1 },
+    { 4, -45, 1 }, { 5, -135, 1 }, { 6, -90, -1 }, { 7, 90, -1 },
+};
+
+// a quad on outputs which aren't the first four
+static const frame_motor quad_sparse[] = {
+    { 1, 45, 1 }, { 3, -135, 1 }, { 6, -45, -1 }, { 7, 135, -1 },
+};
+
+static int16_t random_int16(int16_t low, int16_t high)
+{
+    return low + (int16_t)(rand() % (high - low + 1));
+}
+
+static void check_frame(const frame_motor *frame, uint8_t num_motors)
+{
+    ReferenceMixer reference;
+    AP_MotorsMixer mixer;
+    for (uint8_t i=0; i<num_motors; i++) {
+        reference.add_motor(frame[i].motor, frame[i].angle, frame[i].yaw);
+        mixer.set_motor(frame[i].motor, reference.roll_factor[frame[i].motor],
+                        reference.pitch_factor[frame[i].motor], frame[i].yaw);
+    }
+
+    srand(1);
+    uint32_t saturated = 0;
+    for (uint32_t n=0; n<NUM_SAMPLES; n++) {
+        AP_MotorsMixer::inputs in;
+        // every fourth sample asks for far more than the motors can give
+        const int16_t range = (n % 4 == 0) ? 4500 : 450;
+        in.roll = random_int16(-range, range);
+        in.pitch = random_int16(-range, range);
+        in.yaw = random_int16(-range, range);
+        in.out_min = 1000 + random_int16(0, 150);
+        in.out_max = 2000 - random_int16(0, 100);
+        in.throttle = random_int16(in.out_min, in.out_max);
+        in.gain = 1.0f + random_int16(0, 250) * 0.001f;
+        in.hover_throttle = random_int16(1300, 1600);
+        in.throttle_thr_mix = random_int16(0, 100) * 0.01f;
+        in.yaw_headroom = random_int16(0, 200);
+
+        int16_t expected[AP_MOTORS_MAX_NUM_MOTORS];
+        int16_t result[AP_MOTORS_MAX_NUM_MOTORS];
+        AP_MotorsMixer::limits expected_limit, result_limit;
+        reference.mix(in, expected, expected_limit);
+        mixer.mix(in, result, result_limit);
+
+        for (uint8_t i=0; i<num_motors; i++) {
+            const uint8_t m = frame[i].motor;
+            ASSERT_EQ(expected[m], result[m]) << "motor " << (unsigned)m << " sample " << n;
+        }
+        ASSERT_EQ(expected_limit.roll_pitch, result_limit.roll_pitch) << "sample " << n;
+        ASSERT_EQ(expected_limit.yaw, result_limit.yaw) << "sample " << n;
+        ASSERT_EQ(expected_limit.throttle_upper, result_limit.throttle_upper) << "sample " << n;
+        if (result_limit.roll_pitch) {
+            saturated++;
+        }
+    }
+    // make sure the scaling was exercised
+    EXPECT_GT(saturated, NUM_SAMPLES / 10u);
+}
+
+TEST(AP_MotorsMixerTest, QuadX)
+{
+    check_frame(quad_x, ARRAY_SIZE(quad_x));
+}
+
+TEST(AP_MotorsMixerTest, HexaPlus)
+{
+    check_frame(hexa_plus, ARRAY_SIZE(hexa_plus));
+}
+
+TEST(AP_MotorsMixerTest, OctaPlus)
+{
+    check_frame(octa_plus, ARRAY_SIZE(octa_plus));
+}
+
+TEST(AP_MotorsMixerTest, SparseOutputs)
+{
+    check_frame(quad_sparse, ARRAY_SIZE(quad_sparse));
+}
+
+TEST(AP_MotorsMixerTest, ClearMotor)
+{
+    AP_MotorsMixer mixer;
+    mixer.set_motor(2, 0.5f, -0.5f, 1);
+    EXPECT_EQ(0.5f, mixer.get_factor(AP_MotorsMixer::AXIS_ROLL, 2));
+    EXPECT_EQ(-0.5f, mixer.get_factor(AP_MotorsMixer::AXIS_PITCH, 2));
+    EXPECT_EQ(1.0f, mixer.get_factor(AP_MotorsMixer::AXIS_YAW, 2));
+    mixer.clear_motor(2);
+    for (uint8_t a=0; a<AP_MotorsMixer::AXIS_COUNT; a++) {
+        EXPECT_EQ(0.0f, mixer.get_factor((AP_MotorsMixer::axis)a, 2));
+    }
+}
+
+AP_GTEST_MAIN()
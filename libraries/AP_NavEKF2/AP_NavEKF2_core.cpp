@@ -1106,39 +1106,14 @@ void NavEKF2_core::CovariancePrediction()
         }
     }
 
-    // Copy upper diagonal to lower diagonal taking advantage of symmetry
-    for (uint8_t colIndex=0; colIndex<=stateIndexLim; colIndex++)
-    {
-        for (uint8_t rowIndex=0; rowIndex<colIndex; rowIndex++)
-        {
-            nextP[colIndex][rowIndex] = nextP[rowIndex][colIndex];
-        }
-    }
-
-    // add the general state process noise variances
-    for (uint8_t i=0; i<=stateIndexLim; i++)
-    {
-        nextP[i][i] = nextP[i][i] + processNoise[i];
-    }
-
     // if the total position variance exceeds 1e4 (100m), then stop covariance
-    // growth by setting the predicted to the previous values
+    // growth by keeping the previous values for the horizontal position states
     // This prevent an ill conditioned matrix from occurring for long periods
     // without GPS
-    if ((P[6][6] + P[7][7]) > 1e4f)
-    {
-        for (uint8_t i=6; i<=7; i++)
-        {
-            for (uint8_t j=0; j<=stateIndexLim; j++)
-            {
-                nextP[i][j] = P[i][j];
-                nextP[j][i] = P[j][i];
-            }
-        }
-    }
+    bool holdPosCovariance = (P[6][6] + P[7][7]) > 1e4f;
 
-    // copy covariances to output
-    CopyCovariances();
+    // copy covariances to output, adding the general state process noise variances
+    CopyCovariances(P, nextP, processNoise, stateIndexLim, holdPosCovariance);
 
     // constrain diagonals to prevent ill-conditioning
     ConstrainVariances();
@@ -1226,13 +1201,24 @@ void NavEKF2_core::ForceSymmetry()
 }
 
 // copy covariances across from covariance prediction calculation
-void NavEKF2_core::CopyCovariances()
+// only the upper diagonal of predCov has been calculated, so copy it to both
+// halves of the covariance matrix in one pass
+void NavEKF2_core::CopyCovariances(Matrix24 &covMat, const Matrix24 &predCov, const Vector24 &noiseVar,
+                                   uint8_t lastIndex, bool holdPos)
 {
-    // copy predicted covariances
-    for (uint8_t i=0; i<=stateIndexLim; i++) {
-        for (uint8_t j=0; j<=stateIndexLim; j++)
+    for (uint8_t rowIndex=0; rowIndex<=lastIndex; rowIndex++)
+    {
+        if (holdPos && (rowIndex == 6 || rowIndex == 7)) {
+            continue;
+        }
+        covMat[rowIndex][rowIndex] = predCov[rowIndex][rowIndex] + noiseVar[rowIndex];
+        for (uint8_t colIndex=rowIndex+1; colIndex<=lastIndex; colIndex++)
         {
-            P[i][j] = nextP[i][j];
+            if (holdPos && (colIndex == 6 || colIndex == 7)) {
+                continue;
+            }
+            covMat[rowIndex][colIndex] = predCov[rowIndex][colIndex];
+            covMat[colIndex][rowIndex] = predCov[rowIndex][colIndex];
         }
     }
 }
@@ -47,6 +47,56 @@ class AP_AHRS;
 
 class NavEKF2_core
 {
+    typedef float ftype;
+#if defined(MATH_CHECK_INDEXES) && (MATH_CHECK_INDEXES == 1)
+    typedef VectorN<ftype,2> Vector2;
+    typedef VectorN<ftype,3> Vector3;
+    typedef VectorN<ftype,4> Vector4;
+    typedef VectorN<ftype,5> Vector5;
+    typedef VectorN<ftype,6> Vector6;
+    typedef VectorN<ftype,7> Vector7;
+    typedef VectorN<ftype,8> Vector8;
+    typedef VectorN<ftype,9> Vector9;
+    typedef VectorN<ftype,10> Vector10;
+    typedef VectorN<ftype,11> Vector11;
+    typedef VectorN<ftype,13> Vector13;
+    typedef VectorN<ftype,14> Vector14;
+    typedef VectorN<ftype,15> Vector15;
+    typedef VectorN<ftype,22> Vector22;
+    typedef VectorN<ftype,23> Vector23;
+    typedef VectorN<ftype,24> Vector24;
+    typedef VectorN<ftype,25> Vector25;
+    typedef VectorN<ftype,31> Vector31;
+    typedef VectorN<ftype,28> Vector28;
+    typedef VectorN<VectorN<ftype,3>,3> Matrix3;
+    typedef VectorN<VectorN<ftype,24>,24> Matrix24;
+    typedef VectorN<VectorN<ftype,34>,50> Matrix34_50;
+    typedef VectorN<uint32_t,50> Vector_u32_50;
+#else
+    typedef ftype Vector2[2];
+    typedef ftype Vector3[3];
+    typedef ftype Vector4[4];
+    typedef ftype Vector5[5];
+    typedef ftype Vector6[6];
+    typedef ftype Vector7[7];
+    typedef ftype Vector8[8];
+    typedef ftype Vector9[9];
+    typedef ftype Vector10[10];
+    typedef ftype Vector11[11];
+    typedef ftype Vector13[13];
+    typedef ftype Vector14[14];
+    typedef ftype Vector15[15];
+    typedef ftype Vector22[22];
+    typedef ftype Vector23[23];
+    typedef ftype Vector24[24];
+    typedef ftype Vector25[25];
+    typedef ftype Vector28[28];
+    typedef ftype Matrix3[3][3];
+    typedef ftype Matrix24[24][24];
+    typedef ftype Matrix34_50[34][50];
+    typedef uint32_t Vector_u32_50[50];
+#endif
+
 public:
     // Constructor
     NavEKF2_core(void);
@@ -261,6 +311,13 @@ public:
     // this is used by other instances to level load
     uint8_t getFramesSincePredict(void) const;
 
+    // copy the upper diagonal of the predicted covariance matrix predCov into
+    // both halves of covMat, adding the process noise variances to the
+    // diagonal. The horizontal position states keep their previous
+    // covariances if holdPos is true. Static so it can be tested on its own
+    static void CopyCovariances(Matrix24 &covMat, const Matrix24 &predCov, const Vector24 &noiseVar,
+                                uint8_t lastIndex, bool holdPos);
+
 private:
     // Reference to the global EKF frontend for parameters
     NavEKF2 *frontend;
@@ -268,56 +325,6 @@ private:
     uint8_t core_index;
     uint8_t imu_buffer_length;
 
-    typedef float ftype;
-#if defined(MATH_CHECK_INDEXES) && (MATH_CHECK_INDEXES == 1)
-    typedef VectorN<ftype,2> Vector2;
-    typedef VectorN<ftype,3> Vector3;
-    typedef VectorN<ftype,4> Vector4;
-    typedef VectorN<ftype,5> Vector5;
-    typedef VectorN<ftype,6> Vector6;
-    typedef VectorN<ftype,7> Vector7;
-    typedef VectorN<ftype,8> Vector8;
-    typedef VectorN<ftype,9> Vector9;
-    typedef VectorN<ftype,10> Vector10;
-    typedef VectorN<ftype,11> Vector11;
-    typedef VectorN<ftype,13> Vector13;
-    typedef VectorN<ftype,14> Vector14;
-    typedef VectorN<ftype,15> Vector15;
-    typedef VectorN<ftype,22> Vector22;
-    typedef VectorN<ftype,23> Vector23;
-    typedef VectorN<ftype,24> Vector24;
-    typedef VectorN<ftype,25> Vector25;
-    typedef VectorN<ftype,31> Vector31;
-    typedef VectorN<ftype,28> Vector28;
-    typedef VectorN<VectorN<ftype,3>,3> Matrix3;
-    typedef VectorN<VectorN<ftype,24>,24> Matrix24;
-    typedef VectorN<VectorN<ftype,34>,50> Matrix34_50;
-    typedef VectorN<uint32_t,50> Vector_u32_50;
-#else
-    typedef ftype Vector2[2];
-    typedef ftype Vector3[3];
-    typedef ftype Vector4[4];
-    typedef ftype Vector5[5];
-    typedef ftype Vector6[6];
-    typedef ftype Vector7[7];
-    typedef ftype Vector8[8];
-    typedef ftype Vector9[9];
-    typedef ftype Vector10[10];
-    typedef ftype Vector11[11];
-    typedef ftype Vector13[13];
-    typedef ftype Vector14[14];
-    typedef ftype Vector15[15];
-    typedef ftype Vector22[22];
-    typedef ftype Vector23[23];
-    typedef ftype Vector24[24];
-    typedef ftype Vector25[25];
-    typedef ftype Vector28[28];
-    typedef ftype Matrix3[3][3];
-    typedef ftype Matrix24[24][24];
-    typedef ftype Matrix34_50[34][50];
-    typedef uint32_t Vector_u32_50[50];
-#endif
-
     const AP_AHRS *_ahrs;
 
     // the states are available in two forms, either as a Vector31, or
@@ -393,9 +400,6 @@ private:
     // force symmetry on the state covariance matrix
     void ForceSymmetry();
 
-    // copy covariances across from covariance prediction calculation and fix numerical errors
-    void CopyCovariances();
-
     // constrain variances (diagonal terms) in the state covariance matrix
     void ConstrainVariances();
 
@@ -692,7 +696,7 @@ private:
     uint32_t lastHealthyMagTime_ms; // time the magnetometer was last declared healthy
     bool allMagSensorsFailed;       // true if all magnetometer sensors have timed out on this flight and we are no longer using magnetometer data
     uint32_t ekfStartTime_ms;       // time the EKF was started (msec)
-    Matrix24 nextP;                 // Predicted covariance matrix before addition of process noise to diagonals
+    Matrix24 nextP;                 // Predicted covariance matrix before addition of process noise to diagonals. Only the upper diagonal is used
     Vector24 processNoise;          // process noise added to diagonals of predicted covariance matrix
     Vector25 SF;                    // intermediate variables used to calculate predicted covariance matrix
     Vector5 SG;                     // intermediate variables used to calculate predicted covariance matrix
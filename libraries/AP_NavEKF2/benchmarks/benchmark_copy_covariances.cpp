@@ -0,0 +1,78 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_NavEKF2/AP_NavEKF2_core.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if defined(MATH_CHECK_INDEXES) && (MATH_CHECK_INDEXES == 1)
+typedef VectorN<float,24> Vector24;
+typedef VectorN<VectorN<float,24>,24> Matrix24;
+#else
+typedef float Vector24[24];
+typedef float Matrix24[24][24];
+#endif
+
+static Matrix24 P, nextP;
+static Vector24 processNoise;
+
+static void setup_state(void)
+{
+    for (uint8_t i=0; i<24; i++) {
+        for (uint8_t j=0; j<24; j++) {
+            P[i][j] = 0.01f * (i + j);
+            nextP[i][j] = 0.02f * (i + j);
+        }
+        processNoise[i] = 0.001f * i;
+    }
+}
+
+/*
+  the four passes CovariancePrediction() made over the matrix before
+  CopyCovariances() did it in one
+ */
+static void BM_CopyCovariancesFourPass(benchmark::State& state)
+{
+    const uint8_t stateIndexLim = state.range_x();
+    setup_state();
+    while (state.KeepRunning()) {
+        for (uint8_t colIndex=0; colIndex<=stateIndexLim; colIndex++) {
+            for (uint8_t rowIndex=0; rowIndex<colIndex; rowIndex++) {
+                nextP[colIndex][rowIndex] = nextP[rowIndex][colIndex];
+            }
+        }
+        for (uint8_t i=0; i<=stateIndexLim; i++) {
+            nextP[i][i] = nextP[i][i] + processNoise[i];
+        }
+        if ((P[6][6] + P[7][7]) > 1e4f) {
+            for (uint8_t i=6; i<=7; i++) {
+                for (uint8_t j=0; j<=stateIndexLim; j++) {
+                    nextP[i][j] = P[i][j];
+                    nextP[j][i] = P[j][i];
+                }
+            }
+        }
+        for (uint8_t i=0; i<=stateIndexLim; i++) {
+            for (uint8_t j=0; j<=stateIndexLim; j++) {
+                P[i][j] = nextP[i][j];
+            }
+        }
+        gbenchmark_escape(&P);
+        gbenchmark_escape(&nextP);
+    }
+}
+
+static void BM_CopyCovariances(benchmark::State& state)
+{
+    const uint8_t stateIndexLim = state.range_x();
+    setup_state();
+    while (state.KeepRunning()) {
+        NavEKF2_core::CopyCovariances(P, nextP, processNoise, stateIndexLim, (P[6][6] + P[7][7]) > 1e4f);
+        gbenchmark_escape(&P);
+        gbenchmark_escape(&nextP);
+    }
+}
+
+BENCHMARK(BM_CopyCovariancesFourPass)->Arg(15)->Arg(21)->Arg(23);
+BENCHMARK(BM_CopyCovariances)->Arg(15)->Arg(21)->Arg(23);
+
+BENCHMARK_MAIN()
@@ -0,0 +1,127 @@
+#include <AP_gtest.h>
+
+#include <string.h>
+
+#include <AP_NavEKF2/AP_NavEKF2_core.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#define NUM_SAMPLES 2000
+
+// the same types as NavEKF2_core uses
+#if defined(MATH_CHECK_INDEXES) && (MATH_CHECK_INDEXES == 1)
+typedef VectorN<float,24> Vector24;
+typedef VectorN<VectorN<float,24>,24> Matrix24;
+#else
+typedef float Vector24[24];
+typedef float Matrix24[24][24];
+#endif
+
+/*
+  the end of NavEKF2_core::CovariancePrediction() before the copy was
+  done in one pass, kept to check CopyCovariances() against
+ */
+static void reference_copy(Matrix24 &P, Matrix24 &nextP, const Vector24 &processNoise, uint8_t stateIndexLim)
+{
+    // Copy upper diagonal to lower diagonal taking advantage of symmetry
+    for (uint8_t colIndex=0; colIndex<=stateIndexLim; colIndex++)
+    {
+        for (uint8_t rowIndex=0; rowIndex<colIndex; rowIndex++)
+        {
+            nextP[colIndex][rowIndex] = nextP[rowIndex][colIndex];
+        }
+    }
+
+    // add the general state process noise variances
+    for (uint8_t i=0; i<=stateIndexLim; i++)
+    {
+        nextP[i][i] = nextP[i][i] + processNoise[i];
+    }
+
+    // if the total position variance exceeds 1e4 (100m), then stop covariance
+    // growth by setting the predicted to the previous values
+    if ((P[6][6] + P[7][7]) > 1e4f)
+    {
+        for (uint8_t i=6; i<=7; i++)
+        {
+            for (uint8_t j=0; j<=stateIndexLim; j++)
+            {
+                nextP[i][j] = P[i][j];
+                nextP[j][i] = P[j][i];
+            }
+        }
+    }
+
+    // copy covariances to output
+    for (uint8_t i=0; i<=stateIndexLim; i++) {
+        for (uint8_t j=0; j<=stateIndexLim; j++)
+        {
+            P[i][j] = nextP[i][j];
+        }
+    }
+}
+
+static uint32_t seed = 1;
+
+static float random_float(float range)
+{
+    seed = seed * 1103515245U + 12345U;
+    return (((seed >> 8) & 0xFFFF) / 32768.0f - 1.0f) * range;
+}
+
+/*
+  a random covariance matrix, which need not be symmetric as the
+  fusion steps can leave it slightly asymmetric, and a random
+  prediction of which only the upper diagonal is meaningful
+ */
+static void random_state(Matrix24 &P, Matrix24 &nextP, Vector24 &processNoise, bool largePosVariance)
+{
+    for (uint8_t i=0; i<24; i++) {
+        for (uint8_t j=0; j<24; j++) {
+            P[i][j] = random_float(10);
+            nextP[i][j] = random_float(10);
+        }
+        P[i][i] = fabsf(P[i][i]);
+        processNoise[i] = fabsf(random_float(0.01f));
+    }
+    if (largePosVariance) {
+        P[6][6] = 6000 + random_float(1000);
+        P[7][7] = 6000 + random_float(1000);
+    }
+}
+
+static void check_same(uint8_t stateIndexLim, bool largePosVariance)
+{
+    static Matrix24 P, nextP, refP, refNextP;
+    static Vector24 processNoise;
+
+    for (uint16_t n=0; n<NUM_SAMPLES; n++) {
+        random_state(P, nextP, processNoise, largePosVariance);
+        memcpy(&refP, &P, sizeof(P));
+        memcpy(&refNextP, &nextP, sizeof(nextP));
+
+        const bool holdPos = (P[6][6] + P[7][7]) > 1e4f;
+        NavEKF2_core::CopyCovariances(P, nextP, processNoise, stateIndexLim, holdPos);
+        reference_copy(refP, refNextP, processNoise, stateIndexLim);
+
+        // all of P must match, including the states beyond stateIndexLim,
+        // which are left alone
+        ASSERT_EQ(0, memcmp(&P, &refP, sizeof(P))) << "stateIndexLim " << (unsigned)stateIndexLim << " sample " << n;
+    }
+}
+
+TEST(CopyCovariancesTest, MatchesReference)
+{
+    check_same(23, false);
+    check_same(21, false);
+    check_same(15, false);
+}
+
+TEST(CopyCovariancesTest, HoldPosition)
+{
+    check_same(23, true);
+    check_same(21, true);
+    check_same(15, true);
+}
+
+AP_GTEST_MAIN()
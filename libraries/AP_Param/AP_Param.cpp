@@ -80,6 +80,21 @@ const AP_Param::Info *AP_Param::_var_info;
 struct AP_Param::param_override *AP_Param::param_overrides = NULL;
 uint16_t AP_Param::num_param_overrides = 0;
 
+#if AP_PARAM_INDEX_ENABLED
+struct AP_Param::IndexEntry *AP_Param::_index = NULL;
+uint16_t *AP_Param::_index_hash = NULL;
+uint16_t AP_Param::_index_count = 0;
+uint16_t AP_Param::_index_hash_mask = 0;
+uint8_t AP_Param::_index_building;
+#endif
+
+#if AP_PARAM_STORAGE_MAP_ENABLED
+struct AP_Param::StorageMapEntry *AP_Param::_storage_map = NULL;
+uint16_t AP_Param::_storage_map_mask = 0;
+uint16_t AP_Param::_sentinal_ofs = 0xFFFF;
+bool AP_Param::_storage_map_valid = false;
+#endif
+
 // storage object
 StorageAccess AP_Param::_storage(StorageManager::StorageParam);
 
@@ -117,6 +132,11 @@ void AP_Param::erase_all(void)
 
     // add a sentinal directly after the header
     write_sentinal(sizeof(struct EEPROM_header));
+
+#if AP_PARAM_STORAGE_MAP_ENABLED
+    // rebuilt on the next scan()
+    _storage_map_valid = false;
+#endif
 }
 
 // validate a group info table
@@ -240,6 +260,11 @@ bool AP_Param::setup(void)
         erase_all();
     }
 
+#if AP_PARAM_INDEX_ENABLED
+    // build the index while only the main thread is using parameters
+    build_index();
+#endif
+
     return true;
 }
 
@@ -470,6 +495,11 @@ uint8_t AP_Param::type_size(enum ap_var_type type)
 // if the sentinal isn't found either, the offset is set to 0xFFFF
 bool AP_Param::scan(const AP_Param::Param_header *target, uint16_t *pofs)
 {
+#if AP_PARAM_STORAGE_MAP_ENABLED
+    if (_storage_map_valid || storage_map_build()) {
+        return storage_map_find(*target, pofs);
+    }
+#endif
     struct Param_header phdr;
     uint16_t ofs = sizeof(AP_Param::EEPROM_header);
     while (ofs < _storage.size()) {
@@ -497,6 +527,100 @@ bool AP_Param::scan(const AP_Param::Param_header *target, uint16_t *pofs)
     return false;
 }
 
+#if AP_PARAM_STORAGE_MAP_ENABLED
+static uint32_t storage_map_hash(uint32_t header)
+{
+    header ^= header >> 16;
+    header *= 0x45d9f3bUL;
+    header ^= header >> 16;
+    return header;
+}
+
+/*
+  allocate the storage map if needed and empty it. The map is sized
+  so it is at most half full when storage is full of the smallest
+  variables
+ */
+bool AP_Param::storage_map_reset(void)
+{
+    _storage_map_valid = false;
+    if (_storage_map == NULL) {
+        const uint16_t max_entries = _storage.size() / (sizeof(struct Param_header) + 1);
+        uint32_t map_size = 16;
+        while (map_size < 2*max_entries) {
+            map_size <<= 1;
+        }
+        if (map_size > 0x10000) {
+            return false;
+        }
+        _storage_map = new StorageMapEntry[map_size];
+        if (_storage_map == NULL) {
+            return false;
+        }
+        _storage_map_mask = map_size - 1;
+    }
+    memset(_storage_map, 0, (_storage_map_mask + 1UL) * sizeof(StorageMapEntry));
+    _sentinal_ofs = 0xFFFF;
+    return true;
+}
+
+// add a variable to the storage map. As with scan(), the first copy wins
+void AP_Param::storage_map_add(const struct Param_header &phdr, uint16_t ofs)
+{
+    uint32_t header;
+    memcpy(&header, &phdr, sizeof(header));
+    uint16_t slot = storage_map_hash(header) & _storage_map_mask;
+    while (_storage_map[slot].ofs != 0) {
+        if (_storage_map[slot].header == header) {
+            return;
+        }
+        slot = (slot + 1) & _storage_map_mask;
+    }
+    _storage_map[slot].header = header;
+    _storage_map[slot].ofs = ofs;
+}
+
+// build the storage map with the same walk through storage as scan()
+bool AP_Param::storage_map_build(void)
+{
+    if (!storage_map_reset()) {
+        return false;
+    }
+    struct Param_header phdr;
+    uint16_t ofs = sizeof(AP_Param::EEPROM_header);
+    while (ofs < _storage.size()) {
+        _storage.read_block(&phdr, ofs, sizeof(phdr));
+        storage_map_add(phdr, ofs);
+        if (phdr.type == _sentinal_type ||
+            phdr.key == _sentinal_key ||
+            phdr.group_element == _sentinal_group) {
+            _sentinal_ofs = ofs;
+            break;
+        }
+        ofs += type_size((enum ap_var_type)phdr.type) + sizeof(phdr);
+    }
+    _storage_map_valid = true;
+    return true;
+}
+
+// scan() using the storage map
+bool AP_Param::storage_map_find(const struct Param_header &phdr, uint16_t *pofs)
+{
+    uint32_t header;
+    memcpy(&header, &phdr, sizeof(header));
+    uint16_t slot = storage_map_hash(header) & _storage_map_mask;
+    while (_storage_map[slot].ofs != 0) {
+        if (_storage_map[slot].header == header) {
+            *pofs = _storage_map[slot].ofs;
+            return true;
+        }
+        slot = (slot + 1) & _storage_map_mask;
+    }
+    *pofs = _sentinal_ofs;
+    return false;
+}
+#endif // AP_PARAM_STORAGE_MAP_ENABLED
+
 /**
  * add a _X, _Y, _Z suffix to the name of a Vector3f element
  * @param buffer
@@ -597,11 +721,159 @@ AP_Param::find_group(const char *name, uint8_t vindex, const struct GroupInfo *g
 }
 
 
+#if AP_PARAM_INDEX_ENABLED
+/*
+  FNV-1a hash of a parameter name
+ */
+uint32_t AP_Param::hash_name(const char *name)
+{
+    uint32_t hash = 2166136261UL;
+    while (*name) {
+        hash ^= (uint8_t)*name++;
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+/*
+  build the parameter index. This walks the parameters once in
+  first()/next_scalar() order, so positions in _index are the
+  parameter indexes used by find_by_index()
+ */
+bool AP_Param::build_index(void)
+{
+    if (__atomic_load_n(&_index, __ATOMIC_ACQUIRE) != NULL) {
+        return true;
+    }
+    if (_var_info == NULL) {
+        return false;
+    }
+    /*
+      only one thread builds the index, and only once. Any other
+      thread uses the linear search until the index is published, as
+      does everyone if building it fails
+     */
+    if (__atomic_test_and_set(&_index_building, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+
+    ParamToken token;
+    enum ap_var_type type;
+    uint16_t count = 0;
+    for (AP_Param *ap=first(&token, &type); ap; ap=next_scalar(&token, &type)) {
+        if (count == 0x7FFF) {
+            return false;
+        }
+        count++;
+    }
+
+    // keep the hash table at most half full
+    uint32_t hash_size = 16;
+    while (hash_size < 2*count) {
+        hash_size <<= 1;
+    }
+
+    struct IndexEntry *index = new IndexEntry[count];
+    uint16_t *index_hash = new uint16_t[hash_size];
+    if (index == NULL || index_hash == NULL) {
+        delete[] index;
+        delete[] index_hash;
+        return false;
+    }
+    memset(index_hash, 0, hash_size * sizeof(uint16_t));
+    const uint16_t mask = hash_size - 1;
+
+    uint16_t i = 0;
+    for (AP_Param *ap=first(&token, &type);
+         ap && i < count;
+         ap=next_scalar(&token, &type), i++) {
+        struct IndexEntry &e = index[i];
+        e.ap = ap;
+        e.token = token;
+        e.type = type;
+
+        char name[AP_MAX_NAME_SIZE+1];
+        ap->copy_name_token(token, name, AP_MAX_NAME_SIZE, true);
+        name[AP_MAX_NAME_SIZE] = 0;
+        e.name_hash = hash_name(name);
+
+        /*
+          find() doesn't see the elements of a top level Vector3f, and
+          unnamed variables can't be found at all
+         */
+        if (name[0] == 0 ||
+            PGM_UINT8(&_var_info[token.key].type) == AP_PARAM_VECTOR3F) {
+            continue;
+        }
+
+        // as with a linear search, the first of any duplicate names wins
+        uint16_t slot = e.name_hash & mask;
+        bool duplicate = false;
+        while (index_hash[slot] != 0) {
+            const struct IndexEntry &other = index[index_hash[slot]-1];
+            if (other.name_hash == e.name_hash) {
+                char other_name[AP_MAX_NAME_SIZE+1];
+                other.ap->copy_name_token(other.token, other_name, AP_MAX_NAME_SIZE, true);
+                other_name[AP_MAX_NAME_SIZE] = 0;
+                if (strcmp(name, other_name) == 0) {
+                    duplicate = true;
+                    break;
+                }
+            }
+            slot = (slot + 1) & mask;
+        }
+        if (!duplicate) {
+            index_hash[slot] = i + 1;
+        }
+    }
+
+    _index_count = i;
+    _index_hash_mask = mask;
+    _index_hash = index_hash;
+    __atomic_store_n(&_index, index, __ATOMIC_RELEASE);
+    return true;
+}
+
+/*
+  look up a name in the index. Only exact matches are found, anything
+  else is left to the linear search in find()
+ */
+AP_Param *
+AP_Param::find_indexed(const char *name, enum ap_var_type *ptype)
+{
+    const uint32_t hash = hash_name(name);
+    for (uint16_t slot = hash & _index_hash_mask;
+         _index_hash[slot] != 0;
+         slot = (slot + 1) & _index_hash_mask) {
+        const struct IndexEntry &e = _index[_index_hash[slot]-1];
+        if (e.name_hash != hash) {
+            continue;
+        }
+        char entry_name[AP_MAX_NAME_SIZE+1];
+        e.ap->copy_name_token(e.token, entry_name, AP_MAX_NAME_SIZE, true);
+        entry_name[AP_MAX_NAME_SIZE] = 0;
+        if (strcmp(name, entry_name) == 0) {
+            *ptype = e.type;
+            return e.ap;
+        }
+    }
+    return NULL;
+}
+#endif // AP_PARAM_INDEX_ENABLED
+
 // Find a variable by name.
 //
 AP_Param *
 AP_Param::find(const char *name, enum ap_var_type *ptype)
 {
+#if AP_PARAM_INDEX_ENABLED
+    if (build_index()) {
+        AP_Param *ap = find_indexed(name, ptype);
+        if (ap != NULL) {
+            return ap;
+        }
+    }
+#endif
     for (uint8_t i=0; i<_num_vars; i++) {
         uint8_t type = PGM_UINT8(&_var_info[i].type);
         if (type == AP_PARAM_GROUP) {
@@ -649,11 +921,24 @@ AP_Param::find_def_value_ptr(const char *name)
     return &info->def_value;
 }
 
-// Find a variable by index. Note that this is quite slow.
+// Find a variable by index. Without the index this is quite slow.
 //
 AP_Param *
 AP_Param::find_by_index(uint16_t idx, enum ap_var_type *ptype, ParamToken *token)
 {
+#if AP_PARAM_INDEX_ENABLED
+    if (build_index()) {
+        if (idx >= _index_count) {
+            return NULL;
+        }
+        const struct IndexEntry &e = _index[idx];
+        *token = e.token;
+        if (ptype != NULL) {
+            *ptype = e.type;
+        }
+        return e.ap;
+    }
+#endif
     AP_Param *ap;
     uint16_t count=0;
     for (ap=AP_Param::first(token, ptype);
@@ -786,6 +1071,13 @@ bool AP_Param::save(bool force_save)
     eeprom_write_check(ap, ofs+sizeof(phdr), type_size((enum ap_var_type)phdr.type));
     eeprom_write_check(&phdr, ofs, sizeof(phdr));
 
+#if AP_PARAM_STORAGE_MAP_ENABLED
+    if (_storage_map_valid) {
+        storage_map_add(phdr, ofs);
+        _sentinal_ofs = ofs + sizeof(phdr) + type_size((enum ap_var_type)phdr.type);
+    }
+#endif
+
     send_parameter(name, (enum ap_var_type)phdr.type);
     return true;
 }
@@ -981,6 +1273,12 @@ bool AP_Param::load_all(void)
     struct Param_header phdr;
     uint16_t ofs = sizeof(AP_Param::EEPROM_header);
 
+#if AP_PARAM_INDEX_ENABLED
+    // build the index while only the main thread is using parameters,
+    // rather than on a first find() from some other thread
+    build_index();
+#endif
+
     /*
       if the HAL specifies a defaults parameter file then override
       defaults using that file
@@ -989,14 +1287,31 @@ bool AP_Param::load_all(void)
     load_defaults_file(HAL_PARAM_DEFAULTS_PATH);
 #endif
 
+#if AP_PARAM_STORAGE_MAP_ENABLED
+    // fill in the storage map on the way, rather than walking
+    // storage again on the first scan()
+    const bool build_map = storage_map_reset();
+#endif
+
     while (ofs < _storage.size()) {
         _storage.read_block(&phdr, ofs, sizeof(phdr));
+#if AP_PARAM_STORAGE_MAP_ENABLED
+        if (build_map) {
+            storage_map_add(phdr, ofs);
+        }
+#endif
         // note that this is an || not an && for robustness
         // against power off while adding a variable
         if (phdr.type == _sentinal_type ||
             phdr.key == _sentinal_key ||
             phdr.group_element == _sentinal_group) {
             // we've reached the sentinal
+#if AP_PARAM_STORAGE_MAP_ENABLED
+            if (build_map) {
+                _sentinal_ofs = ofs;
+                _storage_map_valid = true;
+            }
+#endif
             return true;
         }
 
@@ -1012,6 +1327,9 @@ bool AP_Param::load_all(void)
     }
 
     // we didn't find the sentinal
+#if AP_PARAM_STORAGE_MAP_ENABLED
+    _storage_map_valid = build_map;
+#endif
     Debug("no sentinal in load_all");
     return false;
 }
@@ -34,6 +34,18 @@
 #define AP_MAX_NAME_SIZE 16
 #define AP_NESTED_GROUPS_ENABLED
 
+// keep a hashed index of parameter names for find() and
+// find_by_index(). It costs about 20 bytes of RAM per parameter
+#ifndef AP_PARAM_INDEX_ENABLED
+#define AP_PARAM_INDEX_ENABLED (HAL_CPU_CLASS >= HAL_CPU_CLASS_1000)
+#endif
+
+// keep a map of where each variable is in storage, so load() and
+// save() don't have to walk the storage area
+#ifndef AP_PARAM_STORAGE_MAP_ENABLED
+#define AP_PARAM_STORAGE_MAP_ENABLED (HAL_CPU_CLASS >= HAL_CPU_CLASS_1000)
+#endif
+
 // a variant of offsetof() to work around C++ restrictions.
 // this can only be used when the offset of a variable in a object
 // is constant and known at compile time
@@ -402,6 +414,54 @@ private:
     static struct param_override *param_overrides;
     static uint16_t num_param_overrides;
 
+#if AP_PARAM_INDEX_ENABLED
+    /*
+      index of the scalar parameters, in first()/next_scalar() order,
+      built by setup() or load_all(), or else by the first call to
+      find() or find_by_index(). The parameter tables are fixed at
+      compile time, so it never needs rebuilding. _index_hash is an
+      open addressing table of positions in _index plus one, keyed by
+      the hash of the full parameter name
+     */
+    struct IndexEntry {
+        AP_Param *ap;
+        ParamToken token;
+        uint32_t name_hash;
+        enum ap_var_type type;
+    };
+    static struct IndexEntry *_index;
+    static uint16_t *_index_hash;
+    static uint16_t _index_count;
+    static uint16_t _index_hash_mask;
+    static uint8_t _index_building;
+
+    static bool build_index(void);
+    static uint32_t hash_name(const char *name);
+    static AP_Param *find_indexed(const char *name, enum ap_var_type *ptype);
+#endif
+
+#if AP_PARAM_STORAGE_MAP_ENABLED
+    /*
+      open addressing table from the header of each variable in
+      storage to its offset, built by the first scan() or load_all()
+      and kept up to date by save(). _sentinal_ofs is the offset of
+      the sentinal, or 0xFFFF if there isn't one
+     */
+    struct StorageMapEntry {
+        uint32_t header;
+        uint16_t ofs; // zero for an empty slot
+    };
+    static struct StorageMapEntry *_storage_map;
+    static uint16_t _storage_map_mask;
+    static uint16_t _sentinal_ofs;
+    static bool _storage_map_valid;
+
+    static bool storage_map_reset(void);
+    static void storage_map_add(const struct Param_header &phdr, uint16_t ofs);
+    static bool storage_map_build(void);
+    static bool storage_map_find(const struct Param_header &phdr, uint16_t *pofs);
+#endif
+
     // values filled into the EEPROM header
     static const uint8_t        k_EEPROM_magic0      = 0x50;
     static const uint8_t        k_EEPROM_magic1      = 0x41; ///< "AP"
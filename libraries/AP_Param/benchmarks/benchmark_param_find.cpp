@@ -0,0 +1,126 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Param/AP_Param.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+/*
+  a parameter table shaped like ArduCopter's: 40 groups of 20
+  parameters plus 100 top level parameters, 900 in all
+ */
+#define NUM_GROUPS  40
+#define GROUP_SIZE  20
+#define NUM_SCALARS 100
+
+class BenchGroup {
+public:
+    static const struct AP_Param::GroupInfo var_info[];
+    AP_Float p[GROUP_SIZE];
+};
+
+#define BENCH_PARAM(n) AP_GROUPINFO("P" #n, n, BenchGroup, p[n], 0)
+
+const AP_Param::GroupInfo BenchGroup::var_info[] = {
+    BENCH_PARAM(0),  BENCH_PARAM(1),  BENCH_PARAM(2),  BENCH_PARAM(3),
+    BENCH_PARAM(4),  BENCH_PARAM(5),  BENCH_PARAM(6),  BENCH_PARAM(7),
+    BENCH_PARAM(8),  BENCH_PARAM(9),  BENCH_PARAM(10), BENCH_PARAM(11),
+    BENCH_PARAM(12), BENCH_PARAM(13), BENCH_PARAM(14), BENCH_PARAM(15),
+    BENCH_PARAM(16), BENCH_PARAM(17), BENCH_PARAM(18), BENCH_PARAM(19),
+    AP_GROUPEND
+};
+
+static BenchGroup groups[NUM_GROUPS];
+static AP_Int16 scalars[NUM_SCALARS];
+
+#define G10(n) G(n##0), G(n##1), G(n##2), G(n##3), G(n##4), \
+               G(n##5), G(n##6), G(n##7), G(n##8), G(n##9)
+#define S10(n) S(n##0), S(n##1), S(n##2), S(n##3), S(n##4), \
+               S(n##5), S(n##6), S(n##7), S(n##8), S(n##9)
+
+#define G(n) { AP_PARAM_GROUP, "G" #n "_", n, &groups[n], {group_info : BenchGroup::var_info} }
+#define S(n) { AP_PARAM_INT16, "S" #n, NUM_GROUPS+n, &scalars[n], {def_value : 0} }
+
+static const AP_Param::Info var_info[] = {
+    G10(),  G10(1), G10(2), G10(3),
+    S10(),  S10(1), S10(2), S10(3), S10(4),
+    S10(5), S10(6), S10(7), S10(8), S10(9),
+    AP_VAREND
+};
+
+static AP_Param param_loader(var_info);
+
+static uint16_t count_params(void)
+{
+    AP_Param::ParamToken token;
+    enum ap_var_type type;
+    uint16_t count = 0;
+    for (AP_Param *ap = AP_Param::first(&token, &type);
+         ap != NULL;
+         ap = AP_Param::next_scalar(&token, &type)) {
+        count++;
+    }
+    return count;
+}
+
+/*
+  walking first()/next_scalar() to an index, as a GCS parameter
+  download did before the index
+ */
+static void BM_ParamIterateToIndex(benchmark::State& state)
+{
+    const uint16_t count = count_params();
+    uint16_t idx = 0;
+    while (state.KeepRunning()) {
+        AP_Param::ParamToken token;
+        enum ap_var_type type;
+        AP_Param *ap = AP_Param::first(&token, &type);
+        for (uint16_t i=0; ap != NULL && i < idx; i++) {
+            ap = AP_Param::next_scalar(&token, &type);
+        }
+        gbenchmark_escape(ap);
+        idx = (idx + 1) % count;
+    }
+}
+
+static void BM_ParamFindByIndex(benchmark::State& state)
+{
+    const uint16_t count = count_params();
+    uint16_t idx = 0;
+    while (state.KeepRunning()) {
+        AP_Param::ParamToken token;
+        enum ap_var_type type;
+        AP_Param *ap = AP_Param::find_by_index(idx, &type, &token);
+        gbenchmark_escape(ap);
+        idx = (idx + 1) % count;
+    }
+}
+
+static void BM_ParamFind(benchmark::State& state)
+{
+    const uint16_t count = count_params();
+    char (*names)[AP_MAX_NAME_SIZE+1] = new char[count][AP_MAX_NAME_SIZE+1];
+    AP_Param::ParamToken token;
+    enum ap_var_type type;
+    uint16_t i = 0;
+    for (AP_Param *ap = AP_Param::first(&token, &type);
+         ap != NULL && i < count;
+         ap = AP_Param::next_scalar(&token, &type), i++) {
+        memset(names[i], 0, sizeof(names[i]));
+        ap->copy_name_token(token, names[i], AP_MAX_NAME_SIZE, true);
+    }
+
+    uint16_t idx = 0;
+    while (state.KeepRunning()) {
+        AP_Param *ap = AP_Param::find(names[idx], &type);
+        gbenchmark_escape(ap);
+        idx = (idx + 1) % count;
+    }
+    delete[] names;
+}
+
+BENCHMARK(BM_ParamIterateToIndex);
+BENCHMARK(BM_ParamFindByIndex);
+BENCHMARK(BM_ParamFind);
+
+BENCHMARK_MAIN()
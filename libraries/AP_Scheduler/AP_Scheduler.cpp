@@ -22,6 +22,7 @@
 #include "AP_Scheduler.h"
 
 #include <AP_HAL/AP_HAL.h>
+#include <AP_HAL/utility/TraceEvents.h>
 #include <AP_Param/AP_Param.h>
 #include <AP_Progmem/AP_Progmem.h>
 
@@ -32,10 +33,17 @@ int8_t AP_Scheduler::current_task = -1;
 const AP_Param::GroupInfo AP_Scheduler::var_info[] = {
     // @Param: DEBUG
     // @DisplayName: Scheduler debug level
-    // @Description: Set to non-zero to enable scheduler debug messages. When set to show "Slips" the scheduler will display a message whenever a scheduled task is delayed due to too much CPU load. When set to ShowOverruns the scheduled will display a message whenever a task takes longer than the limit promised in the task table.
+    // @Description: Set to non-zero to enable scheduler debug messages. When set to show "Slips" the scheduler will display a message whenever a scheduled task is delayed due to too much CPU load. When set to ShowOverruns the scheduled will display a message whenever a task takes longer than the limit promised in the task table. When non-zero per-task runtime statistics are also streamed to the ground station, if the vehicle supports it.
     // @Values: 0:Disabled,2:ShowSlips,3:ShowOverruns
     // @User: Advanced
     AP_GROUPINFO("DEBUG",    0, AP_Scheduler, _debug, 0),
+
+    // @Param: MODE
+    // @DisplayName: Scheduling mode
+    // @Description: Order in which due tasks are run. TableOrder runs due tasks in the order of the task table. Deadline runs due tasks with the highest urgency first, where urgency is the task priority plus how far the task has slipped relative to its interval, so that tasks which have been starved by overruns earlier in the table get serviced before tasks that are merely due.
+    // @Values: 0:TableOrder,1:Deadline
+    // @User: Advanced
+    AP_GROUPINFO("MODE",     1, AP_Scheduler, _mode, MODE_TABLE_ORDER),
     AP_GROUPEND
 };
 
@@ -47,6 +55,59 @@ void AP_Scheduler::init(const AP_Scheduler::Task *tasks, uint8_t num_tasks)
     _last_run = new uint16_t[_num_tasks];
     memset(_last_run, 0, sizeof(_last_run[0]) * _num_tasks);
     _tick_counter = 0;
+    _run_order = new uint8_t[_num_tasks];
+    _urgency = new uint16_t[_num_tasks];
+#if AP_SCHEDULER_TASK_STATS
+    _task_stats = new TaskStats[_num_tasks];
+    reset_task_stats();
+    _worker_time_us = new uint32_t[_num_tasks];
+    for (uint8_t i=0; i<_num_tasks; i++) {
+        _worker_time_us[i] = AP_SCHEDULER_NO_WORKER_TIME;
+    }
+#endif
+}
+
+// clear all task statistics
+void AP_Scheduler::reset_task_stats(void)
+{
+    if (_task_stats == NULL) {
+        return;
+    }
+    memset(_task_stats, 0, sizeof(_task_stats[0]) * _num_tasks);
+    for (uint8_t i=0; i<_num_tasks; i++) {
+        _task_stats[i].min_us = UINT32_MAX;
+    }
+}
+
+/*
+  record the runtime of one run of a task
+ */
+void AP_Scheduler::update_task_stats(uint8_t i, uint32_t time_taken)
+{
+    if (_task_stats == NULL) {
+        return;
+    }
+    TaskStats &stats = _task_stats[i];
+    stats.count++;
+    stats.total_us += time_taken;
+    if (time_taken < stats.min_us) {
+        stats.min_us = time_taken;
+    }
+    if (time_taken > stats.max_us) {
+        stats.max_us = time_taken;
+    }
+    if (time_taken > _task_time_allowed) {
+        stats.overruns++;
+    }
+
+    // log2 bucket, with bucket 0 holding everything under 32us
+    uint8_t bucket = 0;
+    time_taken >>= 5;
+    while (time_taken != 0 && bucket < AP_SCHEDULER_HISTOGRAM_BUCKETS-1) {
+        time_taken >>= 1;
+        bucket++;
+    }
+    stats.histogram[bucket]++;
 }
 
 // one tick has passed
@@ -55,6 +116,41 @@ void AP_Scheduler::tick(void)
     _tick_counter++;
 }
 
+/*
+  fill _run_order with the tasks that are due, most urgent first, and
+  return how many there are. A task's urgency is its static priority
+  plus 16 for each whole interval it has slipped. Tasks of equal
+  urgency stay in table order
+ */
+uint8_t AP_Scheduler::order_due_tasks(void)
+{
+    uint8_t num_due = 0;
+    for (uint8_t i=0; i<_num_tasks; i++) {
+        uint16_t dt = _tick_counter - _last_run[i];
+        uint16_t interval_ticks = pgm_read_word(&_tasks[i].interval_ticks);
+        if (dt < interval_ticks) {
+            continue;
+        }
+        uint32_t urgency = pgm_read_byte(&_tasks[i].priority);
+        if (interval_ticks > 0) {
+            urgency += (uint32_t)(dt - interval_ticks) * 16 / interval_ticks;
+        }
+        if (urgency > UINT16_MAX) {
+            urgency = UINT16_MAX;
+        }
+        // insertion sort, the list is short and mostly in order
+        uint8_t n = num_due++;
+        while (n > 0 && _urgency[n-1] < urgency) {
+            _urgency[n] = _urgency[n-1];
+            _run_order[n] = _run_order[n-1];
+            n--;
+        }
+        _urgency[n] = urgency;
+        _run_order[n] = i;
+    }
+    return num_due;
+}
+
 /*
   run one tick
   this will run as many scheduler tasks as we can in the specified time
@@ -64,7 +160,15 @@ void AP_Scheduler::run(uint16_t time_available)
     uint32_t run_started_usec = AP_HAL::micros();
     uint32_t now = run_started_usec;
 
-    for (uint8_t i=0; i<_num_tasks; i++) {
+    TRACE_BEGIN("scheduler");
+
+    // in deadline mode we walk the due tasks in order of urgency,
+    // otherwise we walk the whole task table
+    bool deadline = (_mode == MODE_DEADLINE && _run_order != NULL);
+    uint8_t num_to_check = deadline ? order_due_tasks() : _num_tasks;
+
+    for (uint8_t n=0; n<num_to_check; n++) {
+        uint8_t i = deadline ? _run_order[n] : n;
         uint16_t dt = _tick_counter - _last_run[i];
         uint16_t interval_ticks = pgm_read_word(&_tasks[i].interval_ticks);
         if (dt >= interval_ticks) {
@@ -73,6 +177,9 @@ void AP_Scheduler::run(uint16_t time_available)
 
             if (dt >= interval_ticks*2) {
                 // we've slipped a whole run of this task!
+                if (_task_stats != NULL) {
+                    _task_stats[i].slips++;
+                }
                 if (_debug > 1) {
                     hal.console->printf("Scheduler slip task[%u-%s] (%u/%u/%u)\n",
                                           (unsigned)i,
@@ -83,13 +190,43 @@ void AP_Scheduler::run(uint16_t time_available)
                 }
             }
             
+            task_fn_t func;
+            pgm_read_block(&_tasks[i].function, &func, sizeof(func));
+
             if (_task_time_allowed <= time_available) {
+                if (pgm_read_byte(&_tasks[i].thread_safe)) {
+                    uint32_t *worker_time = NULL;
+                    if (_worker_time_us != NULL) {
+                        // account for the last worker run of this task
+                        worker_time = &_worker_time_us[i];
+                        uint32_t last_time = __atomic_exchange_n(worker_time, AP_SCHEDULER_NO_WORKER_TIME,
+                                                                 __ATOMIC_ACQUIRE);
+                        if (last_time != AP_SCHEDULER_NO_WORKER_TIME) {
+                            update_task_stats(i, last_time);
+                        }
+                    }
+                    uint32_t dispatch_started = AP_HAL::micros();
+                    if (hal.scheduler->run_on_worker(func, worker_time)) {
+                        // handed to a worker thread, which doesn't
+                        // use any of our time budget beyond the
+                        // dispatch itself
+                        _last_run[i] = _tick_counter;
+                        now = AP_HAL::micros();
+                        uint32_t time_taken = now - dispatch_started;
+                        if (time_taken >= time_available) {
+                            goto update_spare_ticks;
+                        }
+                        time_available -= time_taken;
+                        continue;
+                    }
+                }
+
                 // run it
                 _task_time_started = now;
-                task_fn_t func;
-                pgm_read_block(&_tasks[i].function, &func, sizeof(func));
                 current_task = i;
+                TRACE_BEGIN(_tasks[i].name);
                 func();
+                TRACE_END(_tasks[i].name);
                 current_task = -1;
                 
                 // record the tick counter when we ran. This drives
@@ -99,7 +236,8 @@ void AP_Scheduler::run(uint16_t time_available)
                 // work out how long the event actually took
                 now = AP_HAL::micros();
                 uint32_t time_taken = now - _task_time_started;
-                
+                update_task_stats(i, time_taken);
+
                 if (time_taken > _task_time_allowed) {
                     // the event overran!
                     if (_debug > 2) {
@@ -122,6 +260,7 @@ void AP_Scheduler::run(uint16_t time_available)
     _spare_micros += time_available;
 
 update_spare_ticks:
+    TRACE_END("scheduler");
     _spare_ticks++;
     if (_spare_ticks == 32) {
         _spare_ticks /= 2;
@@ -27,6 +27,19 @@
 
 #define AP_SCHEDULER_NAME_INITIALIZER(_name) .name = #_name,
 
+// number of log2 buckets in the per-task runtime histogram. Bucket 0
+// counts runs shorter than 32us, bucket n counts runs of
+// [2^(n+4), 2^(n+5)) us and the last bucket counts everything longer
+#define AP_SCHEDULER_HISTOGRAM_BUCKETS 8
+
+// per-task runtime statistics cost around 60 bytes per task, so are
+// not kept on the smallest boards
+#ifndef AP_SCHEDULER_TASK_STATS
+#define AP_SCHEDULER_TASK_STATS (HAL_CPU_CLASS > HAL_CPU_CLASS_16)
+#endif
+
+#define AP_SCHEDULER_NO_WORKER_TIME UINT32_MAX
+
 /*
   A task scheduler for APM main loops
 
@@ -50,6 +63,37 @@ public:
         const char *name;
         uint16_t interval_ticks;
         uint16_t max_time_micros;
+        // static priority used in deadline scheduling mode. Higher
+        // values run first. Tables that don't set it get 0
+        uint8_t priority;
+        // task may be run on a HAL worker thread, concurrently with
+        // the main loop. Only set this for tasks that don't touch
+        // state shared with other tasks without locking
+        bool thread_safe;
+    };
+
+    // scheduling modes, selected with SCHED_MODE
+    enum SchedulingMode {
+        MODE_TABLE_ORDER = 0,
+        MODE_DEADLINE    = 1
+    };
+
+    /*
+      runtime statistics for one task, kept in a table indexed like
+      the task table passed to init()
+     */
+    struct TaskStats {
+        uint32_t count;         // number of times the task has run
+        uint32_t min_us;        // shortest run
+        uint32_t max_us;        // longest run
+        uint64_t total_us;      // sum of all runs, for the mean
+        uint32_t slips;         // ticks where the task was due but had slipped a whole interval
+        uint32_t overruns;      // runs that took longer than max_time_micros
+        uint32_t histogram[AP_SCHEDULER_HISTOGRAM_BUCKETS];
+
+        uint32_t mean_us(void) const {
+            return count ? total_us / count : 0;
+        }
     };
 
     // initialise scheduler
@@ -74,6 +118,25 @@ public:
     // end of a run()
     float load_average(uint32_t tick_time_usec) const;
 
+    // number of tasks in the task table
+    uint8_t num_tasks(void) const { return _num_tasks; }
+
+    // name of a task in the task table
+    const char *task_name(uint8_t i) const {
+        return i < _num_tasks ? _tasks[i].name : NULL;
+    }
+
+    // runtime statistics for a task, or NULL if not available
+    const TaskStats *task_stats(uint8_t i) const {
+        if (_task_stats == NULL || i >= _num_tasks) {
+            return NULL;
+        }
+        return &_task_stats[i];
+    }
+
+    // clear all task statistics
+    void reset_task_stats(void);
+
     static const struct AP_Param::GroupInfo var_info[];
 
     // current running task, or -1 if none. Used to debug stuck tasks
@@ -83,6 +146,9 @@ private:
     // used to enable scheduler debugging
     AP_Int8 _debug;
 
+    // scheduling mode, one of SchedulingMode
+    AP_Int8 _mode;
+
     // progmem list of tasks to run
     const struct Task *_tasks;
 
@@ -107,6 +173,23 @@ private:
 
     // number of ticks that _spare_micros is counted over
     uint8_t _spare_ticks;
+
+    // runtime statistics for each task, NULL if not kept
+    TaskStats *_task_stats;
+
+    void update_task_stats(uint8_t i, uint32_t time_taken);
+
+    // runtime of the last worker run of each thread-safe task, stored
+    // by the worker thread and folded into _task_stats when the task
+    // next comes due. AP_SCHEDULER_NO_WORKER_TIME when there is none
+    uint32_t *_worker_time_us;
+
+    // due tasks sorted by urgency, and their urgency, for deadline
+    // scheduling mode
+    uint8_t *_run_order;
+    uint16_t *_urgency;
+
+    uint8_t order_due_tasks(void);
 };
 
 #endif // AP_SCHEDULER_H
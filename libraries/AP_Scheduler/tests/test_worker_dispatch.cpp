@@ -0,0 +1,187 @@
+#include <AP_gtest.h>
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Scheduler/AP_Scheduler.h>
+
+/*
+  a HAL scheduler with a worker pool that only runs a proc when the
+  test tells it to, reporting a made up runtime for it
+ */
+class WorkerScheduler : public AP_HAL::Scheduler {
+public:
+    void init() {}
+    void delay(uint16_t ms) {}
+    void delay_microseconds(uint16_t us) {}
+    void register_delay_callback(AP_HAL::Proc, uint16_t min_time_ms) {}
+    void register_timer_process(AP_HAL::MemberProc) {}
+    void register_io_process(AP_HAL::MemberProc) {}
+    void suspend_timer_procs() {}
+    void resume_timer_procs() {}
+    bool in_timerprocess() { return false; }
+    void register_timer_failsafe(AP_HAL::Proc, uint32_t period_us) {}
+    bool system_initializing() { return false; }
+    void system_initialized() {}
+    void reboot(bool hold_in_bootloader) {}
+
+    bool run_on_worker(AP_HAL::MemberProc proc, uint32_t *run_time_us) {
+        if (!have_worker) {
+            return false;
+        }
+        dispatches++;
+        if (!queued) {
+            queued = true;
+            queued_proc = proc;
+            queued_run_time = run_time_us;
+        }
+        return true;
+    }
+
+    // run the queued proc as the worker would, taking run_time us
+    void finish(uint32_t run_time) {
+        ASSERT_TRUE(queued);
+        queued = false;
+        queued_proc();
+        if (queued_run_time != NULL) {
+            __atomic_store_n(queued_run_time, run_time, __ATOMIC_RELEASE);
+        }
+    }
+
+    bool have_worker = true;
+    bool queued = false;
+    unsigned dispatches = 0;
+
+private:
+    AP_HAL::MemberProc queued_proc;
+    uint32_t *queued_run_time;
+};
+
+static WorkerScheduler worker_scheduler;
+
+/*
+  the board's HAL, with the scheduler replaced
+ */
+class TestHAL : public AP_HAL::HAL {
+public:
+    TestHAL(const AP_HAL::HAL &board) :
+        AP_HAL::HAL(board.uartA, board.uartB, board.uartC, board.uartD, board.uartE,
+                    board.i2c, board.i2c1, board.i2c2, board.spi, board.analogin,
+                    board.storage, board.console, board.gpio, board.rcin, board.rcout,
+                    &worker_scheduler, board.util, board.opticalflow)
+    {}
+
+    void run(int argc, char * const argv[], Callbacks* callbacks) const {}
+};
+
+static TestHAL test_hal(AP_HAL::get_HAL());
+const AP_HAL::HAL& hal = test_hal;
+
+class Tasks {
+public:
+    void safe_task(void) { safe_runs++; }
+    void task(void) { runs++; }
+
+    unsigned safe_runs = 0;
+    unsigned runs = 0;
+};
+
+static Tasks tasks;
+
+static const AP_Scheduler::Task task_table[] = {
+    {
+        .function = FUNCTOR_BIND(&tasks, &Tasks::safe_task, void),
+        AP_SCHEDULER_NAME_INITIALIZER(safe_task)
+        .interval_ticks = 1,
+        .max_time_micros = 500,
+        .priority = 0,
+        .thread_safe = true,
+    },
+    {
+        .function = FUNCTOR_BIND(&tasks, &Tasks::task, void),
+        AP_SCHEDULER_NAME_INITIALIZER(task)
+        .interval_ticks = 1,
+        .max_time_micros = 10,
+    },
+};
+
+// each test gets a freshly initialised scheduler
+static AP_Scheduler schedulers[4];
+static uint8_t next_scheduler;
+
+static AP_Scheduler &new_scheduler(void)
+{
+    AP_Scheduler &sched = schedulers[next_scheduler++];
+    sched.init(task_table, sizeof(task_table) / sizeof(task_table[0]));
+    tasks.safe_runs = 0;
+    tasks.runs = 0;
+    worker_scheduler.have_worker = true;
+    worker_scheduler.queued = false;
+    worker_scheduler.dispatches = 0;
+    return sched;
+}
+
+TEST(AP_Scheduler, WorkerRunTimeInStats)
+{
+    AP_Scheduler &sched = new_scheduler();
+
+    sched.tick();
+    sched.run(20000);
+    EXPECT_EQ(1U, worker_scheduler.dispatches);
+    EXPECT_EQ(0U, tasks.safe_runs);
+    EXPECT_EQ(1U, tasks.runs);
+
+    // the dispatch itself is not a run of the task
+    EXPECT_EQ(0U, sched.task_stats(0)->count);
+
+    worker_scheduler.finish(1234);
+    EXPECT_EQ(1U, tasks.safe_runs);
+
+    // the worker's runtime is recorded when the task next comes due
+    sched.tick();
+    sched.run(20000);
+    EXPECT_EQ(2U, worker_scheduler.dispatches);
+    const AP_Scheduler::TaskStats *stats = sched.task_stats(0);
+    EXPECT_EQ(1U, stats->count);
+    EXPECT_EQ(1234U, stats->min_us);
+    EXPECT_EQ(1234U, stats->max_us);
+    EXPECT_EQ(1234U, stats->total_us);
+    EXPECT_EQ(1U, stats->overruns);
+
+    // and only once
+    sched.tick();
+    sched.run(20000);
+    EXPECT_EQ(1U, sched.task_stats(0)->count);
+}
+
+TEST(AP_Scheduler, WorkerDispatchKeepsTimeBudget)
+{
+    AP_Scheduler &sched = new_scheduler();
+
+    // not enough time left for the task's max_time_micros
+    sched.tick();
+    sched.run(100);
+    EXPECT_EQ(0U, worker_scheduler.dispatches);
+    EXPECT_EQ(0U, tasks.safe_runs);
+
+    // still due, and dispatched once there is time
+    sched.tick();
+    sched.run(20000);
+    EXPECT_EQ(1U, worker_scheduler.dispatches);
+}
+
+TEST(AP_Scheduler, RunInlineWithoutWorker)
+{
+    AP_Scheduler &sched = new_scheduler();
+    worker_scheduler.have_worker = false;
+
+    sched.tick();
+    sched.run(20000);
+    EXPECT_EQ(1U, tasks.safe_runs);
+    EXPECT_EQ(1U, tasks.runs);
+    EXPECT_EQ(1U, sched.task_stats(0)->count);
+
+    sched.tick();
+    sched.run(100);
+    EXPECT_EQ(1U, tasks.safe_runs);
+}
+
+AP_GTEST_MAIN()
@@ -16,6 +16,22 @@ const AP_Param::GroupInfo DataFlash_Class::var_info[] = {
     // @User: Standard
     AP_GROUPINFO("_FILE_BUFSIZE",  1, DataFlash_Class, _params.file_bufsize,       16),
 
+    // @Param: _FILE_SYNC_KB
+    // @DisplayName: DataFlash File Backend fsync interval in kilobytes
+    // @Description: The DataFlash_File backend calls fsync on the log file once at least this many kilobytes have been written since the last fsync. Larger values give higher log throughput at the risk of losing more of the log on power loss. If both this and LOG_FILE_SYNC_MS are zero the log is synced after every write.
+    // @Units: kilobytes
+    // @Range: 0 1024
+    // @User: Advanced
+    AP_GROUPINFO("_FILE_SYNC_KB",  2, DataFlash_Class, _params.file_sync_kb,       0),
+
+    // @Param: _FILE_SYNC_MS
+    // @DisplayName: DataFlash File Backend fsync interval in milliseconds
+    // @Description: The DataFlash_File backend calls fsync on the log file once this long has passed since the last fsync. If both this and LOG_FILE_SYNC_KB are zero the log is synced after every write.
+    // @Units: milliseconds
+    // @Range: 0 10000
+    // @User: Advanced
+    AP_GROUPINFO("_FILE_SYNC_MS",  3, DataFlash_Class, _params.file_sync_ms,       0),
+
     AP_GROUPEND
 };
 
@@ -20,6 +20,7 @@
 #include <AP_BattMonitor/AP_BattMonitor.h>
 #include <AP_RPM/AP_RPM.h>
 #include <AP_RangeFinder/AP_RangeFinder.h>
+#include <AP_Scheduler/AP_Scheduler.h>
 #include <DataFlash/LogStructure.h>
 #include <stdint.h>
 
@@ -122,6 +123,7 @@ public:
                                const AP_Mission::Mission_Command &cmd);
     void Log_Write_Origin(uint8_t origin_type, const Location &loc);
     void Log_Write_RPM(const AP_RPM &rpm_sensor);
+    void Log_Write_Scheduler(const AP_Scheduler &scheduler);
 
     // This structure provides information on the internal member data of a PID for logging purposes
     struct PID_Info {
@@ -161,6 +163,8 @@ public:
     struct {
         AP_Int8 backend_types;
         AP_Int8 file_bufsize; // in kilobytes
+        AP_Int16 file_sync_kb;
+        AP_Int16 file_sync_ms;
     } _params;
 
     const struct LogStructure *structure(uint16_t num) const;
@@ -60,7 +60,7 @@ DataFlash_File::DataFlash_File(DataFlash_Class &front,
     _open_error(false),
     _log_directory(log_directory),
     _cached_oldest_log(0),
-    _writebuf(NULL),
+    _writebuf(0),
 #if defined(CONFIG_ARCH_BOARD_PX4FMU_V1)
     // V1 gets IO errors with larger than 512 byte writes
     _writebuf_chunk(512),
@@ -79,13 +79,17 @@ DataFlash_File::DataFlash_File(DataFlash_Class &front,
 #else
     _writebuf_chunk(4096),
 #endif
-    _writebuf_head(0),
-    _writebuf_tail(0),
     _last_write_time(0),
+    _writebuf_clear_pending(false),
+    _unsynced_bytes(0),
+    _last_fsync_ms(0),
+    _written_bytes_remainder(0),
     _perf_write(hal.util->perf_alloc(AP_HAL::Util::PC_ELAPSED, "DF_write")),
     _perf_fsync(hal.util->perf_alloc(AP_HAL::Util::PC_ELAPSED, "DF_fsync")),
     _perf_errors(hal.util->perf_alloc(AP_HAL::Util::PC_COUNT, "DF_errors")),
-    _perf_overruns(hal.util->perf_alloc(AP_HAL::Util::PC_COUNT, "DF_overruns"))
+    _perf_overruns(hal.util->perf_alloc(AP_HAL::Util::PC_COUNT, "DF_overruns")),
+    _perf_dropped(hal.util->perf_alloc(AP_HAL::Util::PC_COUNT, "DF_dropped")),
+    _perf_kbytes(hal.util->perf_alloc(AP_HAL::Util::PC_COUNT, "DF_kbytes"))
 {}
 
 
@@ -134,36 +138,30 @@ void DataFlash_File::Init()
     }
 #endif
     
-    if (_writebuf != NULL) {
-        free(_writebuf);
-        _writebuf = NULL;
-    }
-
     // determine and limit file backend buffersize
     uint8_t bufsize = _front._params.file_bufsize;
     if (bufsize > 64) {
-        // we currently use uint16_t for the ringbuffer.  Also,
         // PixHawk has DMA limitaitons.
         bufsize = 64;
     }
-    _writebuf_size = bufsize * 1024;
+    uint32_t bufsize_bytes = bufsize * 1024;
 
     /*
       if we can't allocate the full writebuf then try reducing it
       until we can allocate it
      */
-    while (_writebuf == NULL && _writebuf_size >= _writebuf_chunk) {
-        hal.console->printf("DataFlash_File: buffer size=%u\n", (unsigned)_writebuf_size);
-        _writebuf = (uint8_t *)malloc(_writebuf_size);
-        if (_writebuf == NULL) {
-            _writebuf_size /= 2;
+    _writebuf.set_size(0);
+    while (bufsize_bytes >= _writebuf_chunk) {
+        hal.console->printf("DataFlash_File: buffer size=%u\n", (unsigned)bufsize_bytes);
+        if (_writebuf.set_size(bufsize_bytes)) {
+            break;
         }
+        bufsize_bytes /= 2;
     }
-    if (_writebuf == NULL) {
+    if (_writebuf.get_size() == 0) {
         hal.console->printf("Out of memory for logging\n");
         return;        
     }
-    _writebuf_head = _writebuf_tail = 0;
     _initialised = true;
     hal.scheduler->register_io_process(FUNCTOR_BIND_MEMBER(&DataFlash_File::_io_timer, void));
 }
@@ -206,8 +204,7 @@ void DataFlash_File::periodic_fullrate(const uint32_t now)
 
 uint16_t DataFlash_File::bufferspace_available()
 {
-    uint16_t _head;
-    return (BUF_SPACE(_writebuf)) - critical_message_reserved_space();
+    return _writebuf.space() - critical_message_reserved_space();
 }
 
 // return true for CardInserted() if we successfully initialised
@@ -480,12 +477,12 @@ bool DataFlash_File::WritePrioritisedBlock(const void *pBuffer, uint16_t size, b
     
     if (! WriteBlockCheckStartupMessages()) {
         _dropped++;
+        hal.util->perf_count(_perf_dropped);
         semaphore->give();
         return false;
     }
 
-    uint16_t _head;
-    uint16_t space = BUF_SPACE(_writebuf);
+    uint32_t space = _writebuf.space();
 
     if (_writing_startup_messages &&
         _startup_messagewriter->fmt_done()) {
@@ -502,6 +499,7 @@ bool DataFlash_File::WritePrioritisedBlock(const void *pBuffer, uint16_t size, b
         // we reserve some amount of space for critical messages:
         if (!is_critical && space < critical_message_reserved_space()) {
             _dropped++;
+            hal.util->perf_count(_perf_dropped);
             semaphore->give();
             return false;
         }
@@ -511,30 +509,12 @@ bool DataFlash_File::WritePrioritisedBlock(const void *pBuffer, uint16_t size, b
     if (space < size) {
         hal.util->perf_count(_perf_overruns);
         _dropped++;
+        hal.util->perf_count(_perf_dropped);
         semaphore->give();
         return false;
     }
 
-    if (_writebuf_tail < _head) {
-        // perform as single memcpy
-        assert(((uint32_t)_writebuf_tail)+size <= _writebuf_size);
-        memcpy(&_writebuf[_writebuf_tail], pBuffer, size);
-        BUF_ADVANCETAIL(_writebuf, size);
-    } else {
-        // perform as two memcpy calls
-        uint32_t n = _writebuf_size - _writebuf_tail;
-        if (n > size) n = size;
-        assert(((uint32_t)_writebuf_tail)+n <= _writebuf_size);
-        memcpy(&_writebuf[_writebuf_tail], pBuffer, n);
-        BUF_ADVANCETAIL(_writebuf, n);
-        pBuffer = (const void *)(((const uint8_t *)pBuffer) + n);
-        n = size - n;
-        if (n > 0) {
-            assert(((uint32_t)_writebuf_tail)+n <= _writebuf_size);
-            memcpy(&_writebuf[_writebuf_tail], pBuffer, n);
-            BUF_ADVANCETAIL(_writebuf, n);
-        }
-    }
+    _writebuf.write((const uint8_t *)pBuffer, size);
     semaphore->give();
     return true;
 }
@@ -797,6 +777,35 @@ void DataFlash_File::stop_logging(void)
 }
 
 
+/*
+  discard whatever is left of the old log in the write buffer. Only
+  the IO timer consumes from the buffer, so it does the clear and we
+  wait for it. stop_logging() must have been called first so that no
+  new data is written meanwhile. Returns false if the IO timer did not
+  get to it in time, in which case the clear is still done later
+ */
+bool DataFlash_File::_clear_writebuf(void)
+{
+    if (_writebuf.get_size() == 0) {
+        // the buffer was never allocated, so the IO timer was never
+        // registered either
+        return true;
+    }
+    __atomic_store_n(&_writebuf_clear_pending, true, __ATOMIC_RELEASE);
+    for (uint16_t i=0; i<DATAFLASH_FILE_CLEAR_TIMEOUT_MS; i++) {
+        if (!__atomic_load_n(&_writebuf_clear_pending, __ATOMIC_ACQUIRE)) {
+            return true;
+        }
+        if (hal.scheduler->in_timerprocess()) {
+            // the IO timer can't run until we return
+            break;
+        }
+        hal.scheduler->delay(1);
+    }
+    hal.console->printf("DataFlash_File: timed out clearing buffer\n");
+    return false;
+}
+
 /*
   start writing to a new log file
  */
@@ -817,6 +826,10 @@ uint16_t DataFlash_File::start_new_log(void)
         _read_fd = -1;
     }
 
+    if (!_clear_writebuf()) {
+        return 0xFFFF;
+    }
+
     uint16_t log_num = find_last_log();
     // re-use empty logs if possible
     if (_get_log_size(log_num) > 0 || log_num == 0) {
@@ -845,8 +858,6 @@ uint16_t DataFlash_File::start_new_log(void)
     }
     free(fname);
     _write_offset = 0;
-    _writebuf_head = 0;
-    _writebuf_tail = 0;
     log_write_started = true;
 
     // now update lastlog.txt with the new log number
@@ -1019,11 +1030,10 @@ void DataFlash_File::ListAvailableLogs(AP_HAL::BetterStream *port)
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX
 void DataFlash_File::flush(void)
 {
-    uint16_t _tail;
     uint32_t tnow = AP_HAL::micros();
     hal.scheduler->suspend_timer_procs();
     while (_write_fd != -1 && _initialised && !_open_error &&
-           BUF_AVAILABLE(_writebuf)) {
+           _writebuf.available()) {
         // convince the IO timer that it really is OK to write out
         // less than _writebuf_chunk bytes:
         _last_write_time = tnow - 2000000;
@@ -1036,36 +1046,45 @@ void DataFlash_File::flush(void)
 }
 #endif
 
-void DataFlash_File::_io_timer(void)
+/*
+  return true if the log file should be fsynced now, given the
+  LOG_FILE_SYNC_KB and LOG_FILE_SYNC_MS policy. With both at zero the
+  file is synced after every write
+ */
+bool DataFlash_File::_fsync_due(uint32_t tnow_ms) const
 {
-    uint16_t _tail;
-    if (_write_fd == -1 || !_initialised || _open_error) {
-        return;
+    const uint32_t sync_bytes = (uint32_t)_front._params.file_sync_kb * 1024UL;
+    const uint32_t sync_ms = (uint16_t)_front._params.file_sync_ms;
+    if (_unsynced_bytes == 0) {
+        return false;
     }
-
-    uint16_t nbytes = BUF_AVAILABLE(_writebuf);
-    if (nbytes == 0) {
-        return;
+    if (sync_bytes == 0 && sync_ms == 0) {
+        return true;
     }
-    uint32_t tnow = AP_HAL::micros();
-    if (nbytes < _writebuf_chunk && 
-        tnow - _last_write_time < 2000000UL) {
-        // write in _writebuf_chunk-sized chunks, but always write at
-        // least once per 2 seconds if data is available
-        return;
+    if (sync_bytes != 0 && _unsynced_bytes >= sync_bytes) {
+        return true;
     }
+    if (sync_ms != 0 && tnow_ms - _last_fsync_ms >= sync_ms) {
+        return true;
+    }
+    return false;
+}
 
-    hal.util->perf_begin(_perf_write);
-
-    _last_write_time = tnow;
+/*
+  write out up to one chunk of the write buffer. Returns the number of
+  bytes written, or -1 on error, in which case logging is stopped
+ */
+ssize_t DataFlash_File::_write_chunk(void)
+{
+    uint32_t nbytes = _writebuf.available();
     if (nbytes > _writebuf_chunk) {
         // be kind to the FAT PX4 filesystem
         nbytes = _writebuf_chunk;
     }
-    if (_writebuf_head > _tail) {
-        // only write to the end of the buffer
-        nbytes = MIN(nbytes, _writebuf_size - _writebuf_head);
-    }
+    // only write to the end of the buffer
+    uint32_t contiguous;
+    const uint8_t *head = _writebuf.readptr(contiguous);
+    nbytes = MIN(nbytes, contiguous);
 
     // try to align writes on a 512 byte boundary to avoid filesystem
     // reads
@@ -1076,26 +1095,84 @@ void DataFlash_File::_io_timer(void)
         }
     }
 
-    assert(((uint32_t)_writebuf_head)+nbytes <= _writebuf_size);
-    ssize_t nwritten = ::write(_write_fd, &_writebuf[_writebuf_head], nbytes);
+    ssize_t nwritten = ::write(_write_fd, head, nbytes);
     if (nwritten <= 0) {
         hal.util->perf_count(_perf_errors);
         close(_write_fd);
         _write_fd = -1;
         _initialised = false;
-    } else {
-        _write_offset += nwritten;
+        return -1;
+    }
+
+    _write_offset += nwritten;
+    _writebuf.advance(nwritten);
+    _unsynced_bytes += nwritten;
+
+    // DF_kbytes counts kilobytes written, giving the log throughput
+    _written_bytes_remainder += nwritten;
+    while (_written_bytes_remainder >= 1024) {
+        _written_bytes_remainder -= 1024;
+        hal.util->perf_count(_perf_kbytes);
+    }
+    return nwritten;
+}
+
+void DataFlash_File::_io_timer(void)
+{
+    if (__atomic_load_n(&_writebuf_clear_pending, __ATOMIC_ACQUIRE)) {
+        _writebuf.clear();
+        __atomic_store_n(&_writebuf_clear_pending, false, __ATOMIC_RELEASE);
+    }
+
+    if (_write_fd == -1 || !_initialised || _open_error) {
+        return;
+    }
+
+    uint32_t nbytes = _writebuf.available();
+    if (nbytes == 0) {
+        return;
+    }
+    uint32_t tnow = AP_HAL::micros();
+    if (nbytes < _writebuf_chunk &&
+        tnow - _last_write_time < 2000000UL) {
+        // write in _writebuf_chunk-sized chunks, but always write at
+        // least once per 2 seconds if data is available
+        return;
+    }
+
+    hal.util->perf_begin(_perf_write);
+
+    _last_write_time = tnow;
+
+    /*
+      keep writing while there is at least a full chunk buffered, for
+      up to DATAFLASH_FILE_IO_BUDGET_US. A single chunk per IO tick
+      caps the log rate below what high rate IMU logging produces
+     */
+    do {
+        if (_write_chunk() <= 0) {
+            break;
+        }
+#if CONFIG_HAL_BOARD != HAL_BOARD_SITL && CONFIG_HAL_BOARD_SUBTYPE != HAL_BOARD_SUBTYPE_LINUX_NONE && CONFIG_HAL_BOARD != HAL_BOARD_QURT
         /*
           the best strategy for minimising corruption on microSD cards
           seems to be to write in 4k chunks and fsync the file on each
           chunk, ensuring the directory entry is updated after each
-          write.
+          write. LOG_FILE_SYNC_KB and LOG_FILE_SYNC_MS allow batching
+          the fsync calls for more throughput
          */
-        BUF_ADVANCEHEAD(_writebuf, nwritten);
-#if CONFIG_HAL_BOARD != HAL_BOARD_SITL && CONFIG_HAL_BOARD_SUBTYPE != HAL_BOARD_SUBTYPE_LINUX_NONE && CONFIG_HAL_BOARD != HAL_BOARD_QURT
-        ::fsync(_write_fd);
+        uint32_t tnow_ms = AP_HAL::millis();
+        if (_fsync_due(tnow_ms)) {
+            hal.util->perf_begin(_perf_fsync);
+            ::fsync(_write_fd);
+            hal.util->perf_end(_perf_fsync);
+            _unsynced_bytes = 0;
+            _last_fsync_ms = tnow_ms;
+        }
 #endif
-    }
+    } while (_writebuf.available() >= _writebuf_chunk &&
+             AP_HAL::micros() - tnow < DATAFLASH_FILE_IO_BUDGET_US);
+
     hal.util->perf_end(_perf_write);
 }
 
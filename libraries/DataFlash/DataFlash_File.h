@@ -12,6 +12,8 @@
 
 #if HAL_OS_POSIX_IO
 
+#include <AP_HAL/utility/RingBuffer.h>
+
 #include "DataFlash_Backend.h"
 
 #if CONFIG_HAL_BOARD == HAL_BOARD_QURT
@@ -26,6 +28,16 @@
 #define DATAFLASH_FILE_MINIMAL 0
 #endif
 
+// how long the IO timer may spend writing out the log each time it runs
+#ifndef DATAFLASH_FILE_IO_BUDGET_US
+#define DATAFLASH_FILE_IO_BUDGET_US 10000
+#endif
+
+// how long start_new_log() waits for the IO timer to discard the old log
+#ifndef DATAFLASH_FILE_CLEAR_TIMEOUT_MS
+#define DATAFLASH_FILE_CLEAR_TIMEOUT_MS 1000
+#endif
+
 class DataFlash_File : public DataFlash_Backend
 {
 public:
@@ -105,13 +117,19 @@ private:
     const float min_avail_space_percent = 10.0f;
 #endif
     // write buffer
-    uint8_t *_writebuf;
-    uint32_t _writebuf_size; // in bytes; may be == 65536, thus 32-bits
+    ByteBuffer _writebuf;
     const uint16_t _writebuf_chunk;
-    volatile uint16_t _writebuf_head;
-    volatile uint16_t _writebuf_tail;
     uint32_t _last_write_time;
 
+    // set by start_new_log() to have the IO timer, which is the only
+    // consumer of _writebuf, discard what is left of the old log
+    volatile bool _writebuf_clear_pending;
+
+    // bytes written since the last fsync, and when that was
+    uint32_t _unsynced_bytes;
+    uint32_t _last_fsync_ms;
+    uint16_t _written_bytes_remainder;
+
     /* construct a file name given a log number. Caller must free. */
     char *_log_file_name(const uint16_t log_num) const;
     char *_lastlog_file_name() const;
@@ -120,21 +138,24 @@ private:
 
     void stop_logging(void);
 
+    bool _clear_writebuf(void);
     void _io_timer(void);
+    ssize_t _write_chunk(void);
+    bool _fsync_due(uint32_t tnow_ms) const;
 
     uint16_t critical_message_reserved_space() const {
         // possibly make this a proportional to buffer size?
         uint16_t ret = 1024;
-        if (ret > _writebuf_size) {
+        if (ret > _writebuf.get_size()) {
             // in this case you will only get critical messages
-            ret = _writebuf_size;
+            ret = _writebuf.get_size();
         }
         return ret;
     };
     uint16_t non_messagewriter_message_reserved_space() const {
         // possibly make this a proportional to buffer size?
         uint16_t ret = 1024;
-        if (ret >= _writebuf_size) {
+        if (ret >= _writebuf.get_size()) {
             // need to allow messages out from the messagewriters.  In
             // this case while you have a messagewriter you won't get
             // any other messages.  This should be a corner case!
@@ -150,6 +171,8 @@ private:
     AP_HAL::Util::perf_counter_t  _perf_fsync;
     AP_HAL::Util::perf_counter_t  _perf_errors;
     AP_HAL::Util::perf_counter_t  _perf_overruns;
+    AP_HAL::Util::perf_counter_t  _perf_dropped;
+    AP_HAL::Util::perf_counter_t  _perf_kbytes;
 };
 
 #endif // HAL_OS_POSIX_IO
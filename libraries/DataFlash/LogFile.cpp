@@ -1782,3 +1782,42 @@ void DataFlash_Class::Log_Write_RPM(const AP_RPM &rpm_sensor)
     };
     WriteBlock(&pkt, sizeof(pkt));
 }
+
+// Write per-task scheduler statistics, one SCHD and one SCHH
+// message per task
+void DataFlash_Class::Log_Write_Scheduler(const AP_Scheduler &scheduler)
+{
+    uint64_t now = AP_HAL::micros64();
+    for (uint8_t i=0; i<scheduler.num_tasks(); i++) {
+        const AP_Scheduler::TaskStats *stats = scheduler.task_stats(i);
+        if (stats == NULL) {
+            return;
+        }
+        struct log_Sched pkt = {
+            LOG_PACKET_HEADER_INIT(LOG_SCHED_MSG),
+            time_us  : now,
+            task     : i,
+            name     : {},
+            count    : stats->count,
+            min_us   : stats->count ? stats->min_us : 0,
+            max_us   : stats->max_us,
+            mean_us  : stats->mean_us(),
+            slips    : stats->slips,
+            overruns : stats->overruns
+        };
+        // the name was zeroed above, so it stays NUL terminated
+        strncpy(pkt.name, scheduler.task_name(i), sizeof(pkt.name)-1);
+        WriteBlock(&pkt, sizeof(pkt));
+
+        struct log_SchedHist hist = {
+            LOG_PACKET_HEADER_INIT(LOG_SCHED_HIST_MSG),
+            time_us  : now,
+            task     : i,
+            bucket   : {}
+        };
+        for (uint8_t b=0; b<sizeof(hist.bucket)/sizeof(hist.bucket[0]) && b<AP_SCHEDULER_HISTOGRAM_BUCKETS; b++) {
+            hist.bucket[b] = stats->histogram[b];
+        }
+        WriteBlock(&hist, sizeof(hist));
+    }
+}
@@ -588,6 +588,26 @@ struct PACKED log_RPM {
     float rpm2;
 };
 
+struct PACKED log_Sched {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint8_t  task;
+    char     name[16];
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint32_t mean_us;
+    uint32_t slips;
+    uint32_t overruns;
+};
+
+struct PACKED log_SchedHist {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint8_t  task;
+    uint32_t bucket[8];
+};
+
 // #if SBP_HW_LOGGING
 
 struct PACKED log_SbpLLH {
@@ -814,7 +834,11 @@ Format characters in the format string for binary log messages
     { LOG_ORGN_MSG, sizeof(log_ORGN), \
       "ORGN","QBLLe","TimeUS,Type,Lat,Lng,Alt" }, \
     { LOG_RPM_MSG, sizeof(log_RPM), \
-      "RPM",  "Qff", "TimeUS,rpm1,rpm2" }
+      "RPM",  "Qff", "TimeUS,rpm1,rpm2" }, \
+    { LOG_SCHED_MSG, sizeof(log_Sched), \
+      "SCHD", "QBNIIIIII", "TimeUS,Task,Name,N,Min,Max,Mean,Slip,Ovr" }, \
+    { LOG_SCHED_HIST_MSG, sizeof(log_SchedHist), \
+      "SCHH", "QBIIIIIIII", "TimeUS,Task,H0,H1,H2,H3,H4,H5,H6,H7" }
 
 // #if SBP_HW_LOGGING
 #define LOG_SBP_STRUCTURES \
@@ -925,6 +949,9 @@ enum LogMessages {
 
 // message types 211 to 220 reversed for autotune use
 
+    LOG_SCHED_MSG = 221,
+    LOG_SCHED_HIST_MSG,
+
 };
 
 enum LogOriginType {
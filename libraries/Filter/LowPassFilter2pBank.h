@@ -0,0 +1,141 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LOWPASSFILTER2PBANK_H
+#define LOWPASSFILTER2PBANK_H
+
+#include <AP_Math/AP_Math.h>
+#include <string.h>
+
+#include "LowPassFilter2p.h"
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#define LPF2P_BANK_SSE 1
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define LPF2P_BANK_NEON 1
+#endif
+
+/// @file   LowPassFilter2pBank.h
+/// @brief  A bank of second order low pass filters on Vector3f channels
+///
+/// This gives the same results as an array of LowPassFilter2pVector3f,
+/// bit for bit, but keeps the delay elements and coefficients of all
+/// channels in one block of four float lanes per value (x, y, z and an
+/// unused lane). On CPUs with SSE or NEON each step of the filter is
+/// then one vector operation for all three axes of a channel. Other
+/// CPUs use the same arithmetic a lane at a time.
+template <uint8_t N>
+class LowPassFilter2pVector3fBank {
+public:
+    LowPassFilter2pVector3fBank() {
+        memset(_state, 0, sizeof(_state));
+        memset(_coeffs, 0, sizeof(_coeffs));
+        memset(_params, 0, sizeof(_params));
+    }
+
+    // change parameters of one channel
+    void set_cutoff_frequency(uint8_t chan, float sample_freq, float cutoff_freq) {
+        DigitalBiquadFilter<Vector3f>::compute_params(sample_freq, cutoff_freq, _params[chan]);
+        const struct DigitalBiquadFilter<Vector3f>::biquad_params &p = _params[chan];
+        const float c[COEFF_COUNT] = { p.a1, p.a2, p.b0, p.b1, p.b2 };
+        for (uint8_t i=0; i<COEFF_COUNT; i++) {
+            for (uint8_t l=0; l<4; l++) {
+                _coeffs[chan][i][l] = c[i];
+            }
+        }
+    }
+
+    float get_cutoff_freq(uint8_t chan) const { return _params[chan].cutoff_freq; }
+    float get_sample_freq(uint8_t chan) const { return _params[chan].sample_freq; }
+
+    // filter one sample of a channel
+    Vector3f apply(uint8_t chan, const Vector3f &sample) {
+        const struct DigitalBiquadFilter<Vector3f>::biquad_params &p = _params[chan];
+        if (is_zero(p.cutoff_freq) || is_zero(p.sample_freq)) {
+            return sample;
+        }
+        float *d1 = _state[chan][0];
+        float *d2 = _state[chan][1];
+        const float (*c)[4] = _coeffs[chan];
+        float out[4];
+
+#if LPF2P_BANK_SSE
+        const __m128 in = _mm_setr_ps(sample.x, sample.y, sample.z, 0.0f);
+        const __m128 v1 = _mm_loadu_ps(d1);
+        const __m128 v2 = _mm_loadu_ps(d2);
+        const __m128 v0 = _mm_sub_ps(_mm_sub_ps(in, _mm_mul_ps(v1, _mm_loadu_ps(c[COEFF_A1]))),
+                                     _mm_mul_ps(v2, _mm_loadu_ps(c[COEFF_A2])));
+        const __m128 o = _mm_add_ps(_mm_add_ps(_mm_mul_ps(v0, _mm_loadu_ps(c[COEFF_B0])),
+                                               _mm_mul_ps(v1, _mm_loadu_ps(c[COEFF_B1]))),
+                                    _mm_mul_ps(v2, _mm_loadu_ps(c[COEFF_B2])));
+        _mm_storeu_ps(d2, v1);
+        _mm_storeu_ps(d1, v0);
+        _mm_storeu_ps(out, o);
+#elif LPF2P_BANK_NEON
+        // separate multiplies and adds, as a fused multiply-add
+        // rounds differently from the scalar filter
+        const float s[4] = { sample.x, sample.y, sample.z, 0.0f };
+        const float32x4_t in = vld1q_f32(s);
+        const float32x4_t v1 = vld1q_f32(d1);
+        const float32x4_t v2 = vld1q_f32(d2);
+        const float32x4_t v0 = vsubq_f32(vsubq_f32(in, vmulq_f32(v1, vld1q_f32(c[COEFF_A1]))),
+                                         vmulq_f32(v2, vld1q_f32(c[COEFF_A2])));
+        const float32x4_t o = vaddq_f32(vaddq_f32(vmulq_f32(v0, vld1q_f32(c[COEFF_B0])),
+                                                  vmulq_f32(v1, vld1q_f32(c[COEFF_B1]))),
+                                        vmulq_f32(v2, vld1q_f32(c[COEFF_B2])));
+        vst1q_f32(d2, v1);
+        vst1q_f32(d1, v0);
+        vst1q_f32(out, o);
+#else
+        const float s[3] = { sample.x, sample.y, sample.z };
+        for (uint8_t l=0; l<3; l++) {
+            float v0 = s[l] - d1[l] * c[COEFF_A1][l] - d2[l] * c[COEFF_A2][l];
+            out[l] = v0 * c[COEFF_B0][l] + d1[l] * c[COEFF_B1][l] + d2[l] * c[COEFF_B2][l];
+            d2[l] = d1[l];
+            d1[l] = v0;
+        }
+#endif
+        return Vector3f(out[0], out[1], out[2]);
+    }
+
+    // clear the delay elements of one channel
+    void reset(uint8_t chan) {
+        memset(_state[chan], 0, sizeof(_state[chan]));
+    }
+
+private:
+    enum {
+        COEFF_A1 = 0,
+        COEFF_A2,
+        COEFF_B0,
+        COEFF_B1,
+        COEFF_B2,
+        COEFF_COUNT
+    };
+
+    // the two delay elements of each channel
+    float _state[N][2][4];
+
+    // coefficients of each channel, repeated in every lane
+    float _coeffs[N][COEFF_COUNT][4];
+
+    struct DigitalBiquadFilter<Vector3f>::biquad_params _params[N];
+};
+
+#endif // LOWPASSFILTER2PBANK_H
@@ -0,0 +1,47 @@
+#include <AP_gbenchmark.h>
+
+#include <Filter/LowPassFilter2p.h>
+#include <Filter/LowPassFilter2pBank.h>
+
+/*
+  filter one sample for the accel and gyro of three IMUs, as
+  AP_InertialSensor does each time every sensor has a new sample
+ */
+#define NUM_CHANNELS 6
+
+static void BM_LowPassFilter2pVector3f(benchmark::State& state)
+{
+    LowPassFilter2pVector3f filter[NUM_CHANNELS];
+    for (uint8_t c=0; c<NUM_CHANNELS; c++) {
+        filter[c].set_cutoff_frequency(1000, 20);
+    }
+    Vector3f s(0.1f, -0.2f, -9.8f);
+    while (state.KeepRunning()) {
+        for (uint8_t c=0; c<NUM_CHANNELS; c++) {
+            Vector3f out = filter[c].apply(s);
+            gbenchmark_escape(&out);
+        }
+        s.x = -s.x;
+    }
+}
+
+static void BM_LowPassFilter2pVector3fBank(benchmark::State& state)
+{
+    LowPassFilter2pVector3fBank<NUM_CHANNELS> bank;
+    for (uint8_t c=0; c<NUM_CHANNELS; c++) {
+        bank.set_cutoff_frequency(c, 1000, 20);
+    }
+    Vector3f s(0.1f, -0.2f, -9.8f);
+    while (state.KeepRunning()) {
+        for (uint8_t c=0; c<NUM_CHANNELS; c++) {
+            Vector3f out = bank.apply(c, s);
+            gbenchmark_escape(&out);
+        }
+        s.x = -s.x;
+    }
+}
+
+BENCHMARK(BM_LowPassFilter2pVector3f);
+BENCHMARK(BM_LowPassFilter2pVector3fBank);
+
+BENCHMARK_MAIN()
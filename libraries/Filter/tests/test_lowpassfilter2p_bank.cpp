@@ -0,0 +1,84 @@
+#include <AP_gtest.h>
+
+#include <string.h>
+
+#include <Filter/LowPassFilter2p.h>
+#include <Filter/LowPassFilter2pBank.h>
+
+#define NUM_CHANNELS 6
+#define NUM_SAMPLES 2000
+
+static bool same_bits(const Vector3f &a, const Vector3f &b)
+{
+    return memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+/*
+  a repeatable signal with some noise, different on each channel
+ */
+static Vector3f sample(uint8_t chan, uint16_t i)
+{
+    static uint32_t seed = 1;
+    seed = seed * 1103515245U + 12345U;
+    float noise = ((seed >> 16) & 0x7FFF) / 32768.0f - 0.5f;
+    return Vector3f(sinf(i * 0.01f * (chan+1)) * 9.8f + noise,
+                    cosf(i * 0.03f) * 2.0f - noise,
+                    -9.8f + noise * (chan+1));
+}
+
+TEST(LowPassFilter2pBankTest, MatchesLowPassFilter2p)
+{
+    const float rates[NUM_CHANNELS][2] = {
+        { 1000, 20 }, { 800, 20 }, { 1000, 188 },
+        { 8000, 98 }, { 400, 5 }, { 1000, 0 },
+    };
+    LowPassFilter2pVector3f filter[NUM_CHANNELS];
+    LowPassFilter2pVector3fBank<NUM_CHANNELS> bank;
+
+    for (uint8_t c=0; c<NUM_CHANNELS; c++) {
+        filter[c].set_cutoff_frequency(rates[c][0], rates[c][1]);
+        bank.set_cutoff_frequency(c, rates[c][0], rates[c][1]);
+        EXPECT_EQ(filter[c].get_cutoff_freq(), bank.get_cutoff_freq(c));
+        EXPECT_EQ(filter[c].get_sample_freq(), bank.get_sample_freq(c));
+    }
+
+    for (uint16_t i=0; i<NUM_SAMPLES; i++) {
+        for (uint8_t c=0; c<NUM_CHANNELS; c++) {
+            if (i == NUM_SAMPLES/2 && c == 2) {
+                filter[c].reset();
+                bank.reset(c);
+            }
+            const Vector3f s = sample(c, i);
+            const Vector3f expected = filter[c].apply(s);
+            const Vector3f result = bank.apply(c, s);
+            ASSERT_TRUE(same_bits(expected, result)) << "channel " << (unsigned)c << " sample " << i;
+        }
+    }
+}
+
+TEST(LowPassFilter2pBankTest, ChangeCutoff)
+{
+    LowPassFilter2pVector3f filter(1000, 20);
+    LowPassFilter2pVector3fBank<1> bank;
+    bank.set_cutoff_frequency(0, 1000, 20);
+
+    for (uint16_t i=0; i<NUM_SAMPLES; i++) {
+        if (i == NUM_SAMPLES/2) {
+            filter.set_cutoff_frequency(1000, 42);
+            bank.set_cutoff_frequency(0, 1000, 42);
+        }
+        const Vector3f s = sample(0, i);
+        const Vector3f expected = filter.apply(s);
+        const Vector3f result = bank.apply(0, s);
+        ASSERT_TRUE(same_bits(expected, result)) << "sample " << i;
+    }
+}
+
+TEST(LowPassFilter2pBankTest, Unconfigured)
+{
+    LowPassFilter2pVector3fBank<2> bank;
+    const Vector3f s(1.5f, -2.0f, 9.8f);
+    EXPECT_TRUE(same_bits(s, bank.apply(1, s)));
+}
+
+AP_GTEST_MAIN()
@@ -23,6 +23,15 @@
 #define CHECK_PAYLOAD_SIZE(id) if (comm_get_txspace(chan) < MAVLINK_NUM_NON_PAYLOAD_BYTES+MAVLINK_MSG_ID_ ## id ## _LEN) return false
 #define CHECK_PAYLOAD_SIZE2(id) if (!HAVE_PAYLOAD_SPACE(chan, id)) return false
 
+// number of bytes read from the UART at a time in GCS_MAVLINK::update()
+#ifndef GCS_MAVLINK_RX_CHUNK
+#if HAL_CPU_CLASS > HAL_CPU_CLASS_16
+#define GCS_MAVLINK_RX_CHUNK 256
+#else
+#define GCS_MAVLINK_RX_CHUNK 32
+#endif
+#endif
+
 //  GCS Message ID's
 /// NOTE: to ensure we never block on sending MAVLink messages
 /// please keep each MSG_ to a single MAVLink message. If need be
@@ -69,9 +78,21 @@ enum ap_message {
     MSG_VIBRATION,
     MSG_RPM,
     MSG_MISSION_ITEM_REACHED,
+    MSG_SCHEDULER_STATS,
+    MSG_STREAM_STATS,
+    MSG_ROUTE_STATS,
+    MSG_PERF_STATS,
     MSG_RETRY_DEFERRED // this must be last
 };
 
+// keep per-message statistics of requested and achieved rates
+#ifndef GCS_STREAM_STATS_ENABLED
+#define GCS_STREAM_STATS_ENABLED (HAL_CPU_CLASS >= HAL_CPU_CLASS_150)
+#endif
+
+// period over which the stream statistics are measured
+#define GCS_STREAM_STATS_WINDOW_MS 10000
+
 
 ///
 /// @class	GCS_MAVLINK
@@ -90,6 +111,10 @@ public:
     void        data_stream_send(void);
     void        queued_param_send();
     void        queued_waypoint_send();
+
+    // true if a parameter download should be sent on every
+    // data_stream_send() rather than at the STREAM_PARAMS rate
+    bool        param_streaming(void);
     void        set_snoop(void (*_msg_snoop)(const mavlink_message_t* msg)) {
         msg_snoop = _msg_snoop;
     }
@@ -119,6 +144,14 @@ public:
     // see if we should send a stream now. Called at 50Hz
     bool        stream_trigger(enum streams stream_num);
 
+    // send the requested and achieved rate of one message type as a
+    // DEBUG_VECT, cycling through the types on each call
+    bool        send_stream_stats(void);
+
+    // send the statistics of one HAL perf counter as a DEBUG_VECT,
+    // cycling through the counters on each call
+    bool        send_perf_stats(void);
+
 	// this costs us 51 bytes per instance, but means that low priority
 	// messages don't block the CPU
     mavlink_statustext_t pending_status;
@@ -153,6 +186,7 @@ public:
     void send_local_position(const AP_AHRS &ahrs) const;
     void send_vibration(const AP_InertialSensor &ins) const;
     void send_home(const Location &home) const;
+    void send_scheduler_stats(const AP_Scheduler &scheduler);
     static void send_home_all(const Location &home);
 
     // return a bitmap of active channels. Used by libraries to loop
@@ -183,6 +217,7 @@ public:
 
 private:
     void        handleMessage(mavlink_message_t * msg);
+    void        packetReceived(mavlink_message_t &msg);
 
     /// The stream we are communicating over
     AP_HAL::UARTDriver *_port;
@@ -202,6 +237,20 @@ private:
                                                          // queued send
     uint32_t                    _queued_parameter_send_time_ms;
 
+    // on links with flow control, parameters are streamed in bursts
+    // of up to _queued_parameter_burst messages, which grow after a
+    // burst is sent in full and halve on signs of loss
+    uint16_t                    _queued_parameter_burst;
+    bool                        _queued_parameter_burst_sent; ///< last call
+                                                              // sent a whole
+                                                              // burst
+    uint8_t                     _queued_parameter_slowdown; ///< stream_slowdown
+                                                            // at the last burst
+    bool                        _queued_parameter_rerequested; ///< GCS asked
+                                                               // for a single
+                                                               // parameter
+    void                        update_param_burst(void);
+
     /// Count the number of reportable parameters.
     ///
     /// Not all parameters can be reported via MAVlink.  We count the number
@@ -241,9 +290,18 @@ private:
     // number of 50Hz ticks until we next send this stream
     uint8_t         stream_ticks[NUM_STREAMS];
 
+    // common part of stream_trigger(), for a stream at rate Hz
+    bool            stream_due(enum streams stream_num, float rate);
+
     // number of extra ticks to add to slow things down for the radio
     uint8_t         stream_slowdown;
 
+    // next scheduler task to report in send_scheduler_stats()
+    uint8_t         sched_stats_next_task;
+
+    // next perf counter to report in send_perf_stats()
+    uint16_t        perf_stats_next;
+
     // millis value to calculate cli timeout relative to.
     // exists so we can separate the cli entry time from the system start time
     uint32_t _cli_timeout;
@@ -275,10 +333,48 @@ private:
     // start page of log data
     uint16_t _log_data_page;
 
-    // deferred message handling
-    enum ap_message deferred_messages[MSG_RETRY_DEFERRED];
-    uint8_t next_deferred_message;
-    uint8_t num_deferred_messages;
+    /*
+      outgoing message scheduling. send_message() marks a message as
+      pending, and pending messages are sent in priority order as
+      transmit space and the link's byte budget allow. A message asked
+      for again while it is pending is only sent once
+     */
+    uint64_t _pending_messages;
+    static_assert(MSG_RETRY_DEFERRED <= 64, "too many ap_message values for _pending_messages");
+    uint16_t _pending_since_ms[MSG_RETRY_DEFERRED];
+    uint8_t  _next_pending;
+    int8_t   next_pending_message(void) const;
+    void     send_pending_messages(void);
+
+    /*
+      token bucket holding the number of bytes we may send, filled at
+      _tx_capacity bytes per second and drained by everything sent on
+      the channel. Once a radio reports its status the capacity starts
+      at the port's baudrate and follows the radio's buffer level. Zero
+      means unlimited, as for links without a radio
+     */
+    uint32_t _tx_capacity;
+    uint32_t _tx_capacity_max;
+    float    _tx_tokens;
+    uint32_t _tx_bucket_us;
+    uint32_t _tx_bucket_bytes;
+    bool     tx_limited(void);
+    void     update_tx_bucket(void);
+    void     update_tx_capacity(uint8_t txbuf);
+
+#if GCS_STREAM_STATS_ENABLED
+    // number of times each message was asked for and sent, in the
+    // current window and the last complete one
+    struct message_counts {
+        uint16_t requested;
+        uint16_t sent;
+    };
+    message_counts _msg_counts[MSG_RETRY_DEFERRED];
+    message_counts _msg_counts_last[MSG_RETRY_DEFERRED];
+    uint32_t _msg_stats_start_ms;
+    uint32_t _msg_stats_window_ms;
+    uint8_t  _msg_stats_next;
+#endif
 
     // bitmask of what mavlink channels are active
     static uint8_t mavlink_active;
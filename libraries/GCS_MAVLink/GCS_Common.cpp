@@ -50,6 +50,11 @@ GCS_MAVLINK::init(AP_HAL::UARTDriver *port, mavlink_channel_t mav_chan)
     initialised = true;
     _queued_parameter = NULL;
     reset_cli_timeout();
+
+    // stagger the streams, see stream_due()
+    for (uint8_t i=0; i<NUM_STREAMS; i++) {
+        stream_ticks[i] = i;
+    }
 }
 
 
@@ -97,7 +102,12 @@ GCS_MAVLINK::setup_uart(const AP_SerialManager& serial_manager, AP_SerialManager
     uart->set_flow_control(old_flow_control);
 
     // now change back to desired baudrate
-    uart->begin(serial_manager.find_baudrate(protocol, instance));
+    const uint32_t baudrate = serial_manager.find_baudrate(protocol, instance);
+    uart->begin(baudrate);
+
+    // a serial port sends at most a byte per 10 bits. The link is only
+    // limited to this once a radio reports its status
+    _tx_capacity_max = baudrate / 10;
 
     // and init the gcs instance
     init(uart, mav_chan);
@@ -119,6 +129,47 @@ GCS_MAVLINK::_count_parameters()
     return _parameter_count;
 }
 
+/*
+  limits on the number of PARAM_VALUE messages in one burst when
+  streaming parameters on a link with flow control
+ */
+#define PARAM_STREAM_BURST_MIN 5
+#define PARAM_STREAM_BURST_MAX 500
+
+/*
+  time in microseconds one call of queued_param_send() may spend
+  sending parameters. It runs inside the deferred message send, so
+  this keeps a big burst on a fast link from overrunning that task
+ */
+#define PARAM_SEND_TIME_BUDGET_US 200
+
+/*
+  adapt the parameter burst size to the link. Bursts grow by a
+  quarter after a call that sent its whole burst, and are halved if
+  the radio reports its buffer filling (stream_slowdown going up) or
+  the GCS re-requests a parameter it missed
+ */
+void
+GCS_MAVLINK::update_param_burst(void)
+{
+    if (_queued_parameter_rerequested || stream_slowdown > _queued_parameter_slowdown) {
+        _queued_parameter_burst /= 2;
+    } else if (_queued_parameter_burst_sent) {
+        _queued_parameter_burst += _queued_parameter_burst / 4 + 1;
+    }
+    _queued_parameter_burst = constrain_int16(_queued_parameter_burst,
+                                              PARAM_STREAM_BURST_MIN,
+                                              PARAM_STREAM_BURST_MAX);
+    _queued_parameter_slowdown = stream_slowdown;
+    _queued_parameter_rerequested = false;
+}
+
+bool
+GCS_MAVLINK::param_streaming(void)
+{
+    return _queued_parameter != NULL && have_flow_control();
+}
+
 /**
  * @brief Send the next pending parameter, called from deferred message
  * handling code
@@ -130,25 +181,33 @@ GCS_MAVLINK::queued_param_send()
         return;
     }
 
-    uint16_t bytes_allowed;
-    uint8_t count;
+    const uint16_t packet_len = MAVLINK_MSG_ID_PARAM_VALUE_LEN + MAVLINK_NUM_NON_PAYLOAD_BYTES;
+    const uint32_t send_started_us = AP_HAL::micros();
     uint32_t tnow = AP_HAL::millis();
+    uint16_t count;
 
-    // use at most 30% of bandwidth on parameters. The constant 26 is
-    // 1/(1000 * 1/8 * 0.001 * 0.3)
-    bytes_allowed = 57 * (tnow - _queued_parameter_send_time_ms) * 26;
-    if (bytes_allowed > comm_get_txspace(chan)) {
-        bytes_allowed = comm_get_txspace(chan);
-    }
-    count = bytes_allowed / (MAVLINK_MSG_ID_PARAM_VALUE_LEN + MAVLINK_NUM_NON_PAYLOAD_BYTES);
+    if (have_flow_control()) {
+        // fill the transmit buffer, up to the current burst size
+        update_param_burst();
+        count = MIN(comm_get_txspace(chan) / packet_len, _queued_parameter_burst);
+    } else {
+        // use at most 30% of bandwidth on parameters. The constant 26 is
+        // 1/(1000 * 1/8 * 0.001 * 0.3)
+        uint32_t bytes_allowed = 57 * (tnow - _queued_parameter_send_time_ms) * 26;
+        if (bytes_allowed > comm_get_txspace(chan)) {
+            bytes_allowed = comm_get_txspace(chan);
+        }
+        count = bytes_allowed / packet_len;
 
-    // when we don't have flow control we really need to keep the
-    // param download very slow, or it tends to stall
-    if (!have_flow_control() && count > 5) {
-        count = 5;
+        // when we don't have flow control we really need to keep the
+        // param download very slow, or it tends to stall
+        if (count > 5) {
+            count = 5;
+        }
     }
 
-    while (_queued_parameter != NULL && count--) {
+    uint16_t sent = 0;
+    while (_queued_parameter != NULL && sent < count) {
         AP_Param      *vp;
         float value;
 
@@ -171,7 +230,13 @@ GCS_MAVLINK::queued_param_send()
 
         _queued_parameter = AP_Param::next_scalar(&_queued_parameter_token, &_queued_parameter_type);
         _queued_parameter_index++;
+        sent++;
+
+        if (AP_HAL::micros() - send_started_us >= PARAM_SEND_TIME_BUDGET_US) {
+            break;
+        }
     }
+    _queued_parameter_burst_sent = (sent == _queued_parameter_burst);
     _queued_parameter_send_time_ms = tnow;
 }
 
@@ -521,6 +586,10 @@ void GCS_MAVLINK::handle_param_request_list(mavlink_message_t *msg)
     _queued_parameter = AP_Param::first(&_queued_parameter_token, &_queued_parameter_type);
     _queued_parameter_index = 0;
     _queued_parameter_count = _count_parameters();
+    _queued_parameter_burst = PARAM_STREAM_BURST_MIN;
+    _queued_parameter_burst_sent = false;
+    _queued_parameter_slowdown = stream_slowdown;
+    _queued_parameter_rerequested = false;
 }
 
 void GCS_MAVLINK::handle_param_request_read(mavlink_message_t *msg)
@@ -528,6 +597,11 @@ void GCS_MAVLINK::handle_param_request_read(mavlink_message_t *msg)
     mavlink_param_request_read_t packet;
     mavlink_msg_param_request_read_decode(msg, &packet);
 
+    if (_queued_parameter != NULL) {
+        // the GCS is filling in a gap in the download
+        _queued_parameter_rerequested = true;
+    }
+
     enum ap_var_type p_type;
     AP_Param *vp;
     char param_name[AP_MAX_NAME_SIZE+1];
@@ -643,6 +717,7 @@ void GCS_MAVLINK::handle_radio_status(mavlink_message_t *msg, DataFlash_Class &d
         // the buffer has enough space, speed up a bit
         stream_slowdown--;
     }
+    update_tx_capacity(packet.txbuf);
 
     //log rssi, noise, etc if logging Performance monitoring data
     if (log_radio) {
@@ -776,53 +851,327 @@ GCS_MAVLINK::handle_gps_inject(const mavlink_message_t *msg, AP_GPS &gps)
 
 }
 
-// send a message using mavlink, handling message queueing
-void GCS_MAVLINK::send_message(enum ap_message id)
+/*
+  message priorities, lowest first. A message which has been pending
+  for GCS_MESSAGE_MAX_WAIT_MS goes ahead of all of them, so a busy
+  link can't starve the low priority messages entirely
+ */
+#define GCS_PRIORITY_CRITICAL 1 // mission and parameter protocol, text and heartbeat
+#define GCS_PRIORITY_STATE    2 // the vehicle's attitude, position and status
+#define GCS_PRIORITY_BULK     3 // raw sensor, RC and diagnostic data
+
+#define GCS_MESSAGE_MAX_WAIT_MS 1000
+
+// depth of the token bucket, as time at the link capacity
+#define GCS_TX_BUCKET_MS 100
+
+#define MSG_SIZE(id) (MAVLINK_NUM_NON_PAYLOAD_BYTES + MAVLINK_MSG_ID_ ## id ## _LEN)
+
+/*
+  the usual size on the wire and the priority of each ap_message. The
+  size is only used to decide if a message fits the byte budget; the
+  bucket is charged with the bytes actually sent
+ */
+static const struct {
+    uint8_t size;
+    uint8_t priority;
+} ap_message_info[] = {
+    { MSG_SIZE(HEARTBEAT),              GCS_PRIORITY_CRITICAL }, // MSG_HEARTBEAT
+    { MSG_SIZE(ATTITUDE),               GCS_PRIORITY_STATE },    // MSG_ATTITUDE
+    { MSG_SIZE(GLOBAL_POSITION_INT),    GCS_PRIORITY_STATE },    // MSG_LOCATION
+    { MSG_SIZE(SYS_STATUS) + MSG_SIZE(POWER_STATUS), GCS_PRIORITY_STATE }, // MSG_EXTENDED_STATUS1
+    { MSG_SIZE(MEMINFO),                GCS_PRIORITY_BULK },     // MSG_EXTENDED_STATUS2
+    { MSG_SIZE(NAV_CONTROLLER_OUTPUT),  GCS_PRIORITY_STATE },    // MSG_NAV_CONTROLLER_OUTPUT
+    { MSG_SIZE(MISSION_CURRENT),        GCS_PRIORITY_STATE },    // MSG_CURRENT_WAYPOINT
+    { MSG_SIZE(VFR_HUD),                GCS_PRIORITY_STATE },    // MSG_VFR_HUD
+    { MSG_SIZE(SERVO_OUTPUT_RAW),       GCS_PRIORITY_BULK },     // MSG_RADIO_OUT
+    { MSG_SIZE(RC_CHANNELS_RAW) + MSG_SIZE(RC_CHANNELS), GCS_PRIORITY_BULK }, // MSG_RADIO_IN
+    { MSG_SIZE(RAW_IMU),                GCS_PRIORITY_BULK },     // MSG_RAW_IMU1
+    { MSG_SIZE(SCALED_PRESSURE),        GCS_PRIORITY_BULK },     // MSG_RAW_IMU2
+    { MSG_SIZE(SENSOR_OFFSETS),         GCS_PRIORITY_BULK },     // MSG_RAW_IMU3
+    { MSG_SIZE(GPS_RAW_INT),            GCS_PRIORITY_STATE },    // MSG_GPS_RAW
+    { MSG_SIZE(SYSTEM_TIME),            GCS_PRIORITY_BULK },     // MSG_SYSTEM_TIME
+    { MSG_SIZE(RC_CHANNELS_SCALED),     GCS_PRIORITY_BULK },     // MSG_SERVO_OUT
+    { MSG_SIZE(MISSION_REQUEST),        GCS_PRIORITY_CRITICAL }, // MSG_NEXT_WAYPOINT
+    { MSG_SIZE(PARAM_VALUE),            GCS_PRIORITY_CRITICAL }, // MSG_NEXT_PARAM
+    { MSG_SIZE(STATUSTEXT),             GCS_PRIORITY_CRITICAL }, // MSG_STATUSTEXT
+    { MSG_SIZE(LIMITS_STATUS),          GCS_PRIORITY_STATE },    // MSG_LIMITS_STATUS
+    { MSG_SIZE(FENCE_STATUS),           GCS_PRIORITY_STATE },    // MSG_FENCE_STATUS
+    { MSG_SIZE(AHRS),                   GCS_PRIORITY_BULK },     // MSG_AHRS
+    { MSG_SIZE(SIMSTATE) + MSG_SIZE(AHRS2), GCS_PRIORITY_BULK }, // MSG_SIMSTATE
+    { MSG_SIZE(HWSTATUS),               GCS_PRIORITY_BULK },     // MSG_HWSTATUS
+    { MSG_SIZE(WIND),                   GCS_PRIORITY_BULK },     // MSG_WIND
+    { MSG_SIZE(RANGEFINDER),            GCS_PRIORITY_BULK },     // MSG_RANGEFINDER
+    { MSG_SIZE(TERRAIN_REQUEST),        GCS_PRIORITY_BULK },     // MSG_TERRAIN
+    { MSG_SIZE(BATTERY2),               GCS_PRIORITY_BULK },     // MSG_BATTERY2
+    { MSG_SIZE(CAMERA_FEEDBACK),        GCS_PRIORITY_CRITICAL }, // MSG_CAMERA_FEEDBACK
+    { MSG_SIZE(MOUNT_STATUS),           GCS_PRIORITY_BULK },     // MSG_MOUNT_STATUS
+    { MSG_SIZE(OPTICAL_FLOW),           GCS_PRIORITY_BULK },     // MSG_OPTICAL_FLOW
+    { MSG_SIZE(GIMBAL_REPORT),          GCS_PRIORITY_BULK },     // MSG_GIMBAL_REPORT
+    { MSG_SIZE(MAG_CAL_PROGRESS),       GCS_PRIORITY_BULK },     // MSG_MAG_CAL_PROGRESS
+    { MSG_SIZE(MAG_CAL_REPORT),         GCS_PRIORITY_CRITICAL }, // MSG_MAG_CAL_REPORT
+    { MSG_SIZE(EKF_STATUS_REPORT),      GCS_PRIORITY_STATE },    // MSG_EKF_STATUS_REPORT
+    { MSG_SIZE(LOCAL_POSITION_NED),     GCS_PRIORITY_STATE },    // MSG_LOCAL_POSITION
+    { MSG_SIZE(PID_TUNING),             GCS_PRIORITY_BULK },     // MSG_PID_TUNING
+    { MSG_SIZE(VIBRATION),              GCS_PRIORITY_BULK },     // MSG_VIBRATION
+    { MSG_SIZE(RPM),                    GCS_PRIORITY_BULK },     // MSG_RPM
+    { MSG_SIZE(MISSION_ITEM_REACHED),   GCS_PRIORITY_CRITICAL }, // MSG_MISSION_ITEM_REACHED
+    { MSG_SIZE(DEBUG_VECT),             GCS_PRIORITY_BULK },     // MSG_SCHEDULER_STATS
+    { MSG_SIZE(DEBUG_VECT),             GCS_PRIORITY_BULK },     // MSG_STREAM_STATS
+    { MSG_SIZE(DEBUG_VECT),             GCS_PRIORITY_BULK },     // MSG_ROUTE_STATS
+    { MSG_SIZE(DEBUG_VECT),             GCS_PRIORITY_BULK },     // MSG_PERF_STATS
+};
+
+static_assert(ARRAY_SIZE(ap_message_info) == MSG_RETRY_DEFERRED,
+              "ap_message_info must have an entry for each ap_message");
+
+#if GCS_STREAM_STATS_ENABLED
+// names for send_stream_stats(), which DEBUG_VECT limits to 10 characters
+static const char ap_message_names[MSG_RETRY_DEFERRED][10] = {
+    "HEARTBEAT", "ATTITUDE",  "LOCATION",  "EXT_STAT1", "EXT_STAT2",
+    "NAV_CTRL",  "CUR_WP",    "VFR_HUD",   "RADIO_OUT", "RADIO_IN",
+    "RAW_IMU1",  "RAW_IMU2",  "RAW_IMU3",  "GPS_RAW",   "SYS_TIME",
+    "SERVO_OUT", "NEXT_WP",   "NEXT_PARM", "STATUSTXT", "LIMITS",
+    "FENCE",     "AHRS",      "SIMSTATE",  "HWSTATUS",  "WIND",
+    "RNGFND",    "TERRAIN",   "BATTERY2",  "CAM_FDBK",  "MOUNT",
+    "OPTFLOW",   "GIMBAL",    "MAGCAL_PR", "MAGCAL_RP", "EKF_STAT",
+    "LOCAL_POS", "PID_TUNE",  "VIBE",      "RPM",       "WP_REACH",
+    "SCHED",     "STREAMS",   "ROUTES",    "PERF",
+};
+#endif
+
+/*
+  return true if this link's byte rate is limited by the token bucket.
+  Links with flow control pace themselves
+ */
+bool GCS_MAVLINK::tx_limited(void)
 {
-    uint8_t i, nextid;
+    return _tx_capacity != 0 && !have_flow_control();
+}
 
-    // see if we can send the deferred messages, if any
-    while (num_deferred_messages != 0) {
-        if (!try_send_message(deferred_messages[next_deferred_message])) {
-            break;
+/*
+  add the tokens earned since the last update and take away the bytes
+  sent since then, including ones not sent by send_message(). The
+  bucket may go into debt by up to its depth
+ */
+void GCS_MAVLINK::update_tx_bucket(void)
+{
+    const uint32_t now = AP_HAL::micros();
+    const uint32_t bytes = comm_get_tx_bytes(chan);
+    const float depth = MAX(_tx_capacity * GCS_TX_BUCKET_MS * 0.001f, (float)MAVLINK_MAX_PACKET_LEN);
+    _tx_tokens += (now - _tx_bucket_us) * 1.0e-6f * _tx_capacity;
+    _tx_tokens -= (bytes - _tx_bucket_bytes);
+    _tx_tokens = constrain_float(_tx_tokens, -depth, depth);
+    _tx_bucket_us = now;
+    _tx_bucket_bytes = bytes;
+}
+
+/*
+  follow the level of the radio's transmit buffer, backing off quickly
+  when it fills and recovering slowly towards the port's baudrate
+ */
+void GCS_MAVLINK::update_tx_capacity(uint8_t txbuf)
+{
+    if (_tx_capacity_max == 0) {
+        return;
+    }
+    if (_tx_capacity == 0) {
+        // first report from the radio
+        _tx_capacity = _tx_capacity_max;
+    }
+    if (txbuf < 20) {
+        _tx_capacity = _tx_capacity * 3 / 4;
+    } else if (txbuf < 50) {
+        _tx_capacity = _tx_capacity * 9 / 10;
+    } else if (txbuf > 90) {
+        _tx_capacity += _tx_capacity_max / 50;
+    }
+    _tx_capacity = constrain_int32(_tx_capacity, _tx_capacity_max / 20, _tx_capacity_max);
+}
+
+/*
+  pick the pending message to send next: the highest priority one,
+  taking them in turn from _next_pending so messages of the same
+  priority share the link
+ */
+int8_t GCS_MAVLINK::next_pending_message(void) const
+{
+    const uint16_t now = AP_HAL::millis();
+    int8_t best = -1;
+    uint8_t best_priority = 0xFF;
+    for (uint8_t i=0; i<MSG_RETRY_DEFERRED; i++) {
+        uint8_t id = _next_pending + i;
+        if (id >= MSG_RETRY_DEFERRED) {
+            id -= MSG_RETRY_DEFERRED;
+        }
+        if (!(_pending_messages & (1ULL<<id))) {
+            continue;
         }
-        next_deferred_message++;
-        if (next_deferred_message == MSG_RETRY_DEFERRED) {
-            next_deferred_message = 0;
+        uint8_t priority = ap_message_info[id].priority;
+        if ((uint16_t)(now - _pending_since_ms[id]) >= GCS_MESSAGE_MAX_WAIT_MS) {
+            priority = 0;
+        }
+        if (priority < best_priority) {
+            best = id;
+            best_priority = priority;
+            if (priority == 0) {
+                break;
+            }
         }
-        num_deferred_messages--;
     }
+    return best;
+}
 
-    if (id == MSG_RETRY_DEFERRED) {
-        return;
+/*
+  send pending messages until we run out of transmit space or byte
+  budget, or the vehicle declines to send
+ */
+void GCS_MAVLINK::send_pending_messages(void)
+{
+    const bool limited = tx_limited();
+    if (limited) {
+        update_tx_bucket();
     }
+    while (_pending_messages != 0) {
+        const int8_t id = next_pending_message();
+        if (limited && _tx_tokens < ap_message_info[id].size) {
+            break;
+        }
+        bool sent;
+        if (id == MSG_STREAM_STATS) {
+            sent = send_stream_stats();
+        } else if (id == MSG_ROUTE_STATS) {
+            sent = routing.send_route_stats(chan);
+        } else if (id == MSG_PERF_STATS) {
+            sent = send_perf_stats();
+        } else {
+            sent = try_send_message((enum ap_message)id);
+        }
+        if (!sent) {
+            break;
+        }
+        _pending_messages &= ~(1ULL<<id);
+        _next_pending = (id + 1) % MSG_RETRY_DEFERRED;
+#if GCS_STREAM_STATS_ENABLED
+        _msg_counts[id].sent++;
+#endif
+        if (limited) {
+            update_tx_bucket();
+        }
+    }
+}
 
-    // this message id might already be deferred
-    for (i=0, nextid = next_deferred_message; i < num_deferred_messages; i++) {
-        if (deferred_messages[nextid] == id) {
-            // its already deferred, discard
-            return;
+// send a message using mavlink, handling message queueing
+void GCS_MAVLINK::send_message(enum ap_message id)
+{
+    if (id < MSG_RETRY_DEFERRED) {
+#if GCS_STREAM_STATS_ENABLED
+        _msg_counts[id].requested++;
+#endif
+        if (!(_pending_messages & (1ULL<<id))) {
+            _pending_messages |= (1ULL<<id);
+            _pending_since_ms[id] = AP_HAL::millis();
         }
-        nextid++;
-        if (nextid == MSG_RETRY_DEFERRED) {
-            nextid = 0;
+    }
+    send_pending_messages();
+}
+
+/*
+  common part of stream_trigger(). Streams count down at 50Hz from
+  staggered starting points set in init(), so streams at the same rate
+  don't all fall due on the same tick
+ */
+bool GCS_MAVLINK::stream_due(enum streams stream_num, float rate)
+{
+    if (rate <= 0) {
+        return false;
+    }
+
+    if (stream_ticks[stream_num] == 0) {
+        // we're triggering now, setup the next trigger point
+        if (rate > 50) {
+            rate = 50;
         }
+        stream_ticks[stream_num] = (50 / rate) - 1;
+        return true;
     }
 
-    if (num_deferred_messages != 0 ||
-        !try_send_message(id)) {
-        // can't send it now, so defer it
-        if (num_deferred_messages == MSG_RETRY_DEFERRED) {
-            // the defer buffer is full, discard
-            return;
+    // count down at 50Hz
+    stream_ticks[stream_num]--;
+    return false;
+}
+
+/*
+  send the requested and achieved rates over the last
+  GCS_STREAM_STATS_WINDOW_MS of one message type, with the link
+  capacity in bytes per second (zero if unlimited)
+ */
+bool GCS_MAVLINK::send_stream_stats(void)
+{
+#if GCS_STREAM_STATS_ENABLED
+    if (!HAVE_PAYLOAD_SPACE(chan, DEBUG_VECT)) {
+        return false;
+    }
+    const uint32_t now = AP_HAL::millis();
+    if (now - _msg_stats_start_ms >= GCS_STREAM_STATS_WINDOW_MS) {
+        memcpy(_msg_counts_last, _msg_counts, sizeof(_msg_counts_last));
+        memset(_msg_counts, 0, sizeof(_msg_counts));
+        _msg_stats_window_ms = now - _msg_stats_start_ms;
+        _msg_stats_start_ms = now;
+    }
+    if (_msg_stats_window_ms == 0) {
+        return true;
+    }
+    for (uint8_t i=0; i<MSG_RETRY_DEFERRED; i++) {
+        const uint8_t id = (_msg_stats_next + i) % MSG_RETRY_DEFERRED;
+        if (_msg_counts_last[id].requested == 0) {
+            continue;
         }
-        nextid = next_deferred_message + num_deferred_messages;
-        if (nextid >= MSG_RETRY_DEFERRED) {
-            nextid -= MSG_RETRY_DEFERRED;
+        const float scale = 1000.0f / _msg_stats_window_ms;
+        mavlink_msg_debug_vect_send(
+            chan,
+            ap_message_names[id],
+            AP_HAL::micros64(),
+            _msg_counts_last[id].requested * scale,
+            _msg_counts_last[id].sent * scale,
+            tx_limited() ? _tx_capacity : 0);
+        _msg_stats_next = id + 1;
+        break;
+    }
+#endif
+    return true;
+}
+
+/*
+  send the statistics of one HAL perf counter as a DEBUG_VECT named
+  after the counter, with x=number of events and y=mean, z=max time in
+  microseconds. Each call reports the next counter. Nothing is sent on
+  HALs which can't list their counters
+ */
+bool GCS_MAVLINK::send_perf_stats(void)
+{
+    if (!HAVE_PAYLOAD_SPACE(chan, DEBUG_VECT)) {
+        return false;
+    }
+    AP_HAL::Util::perf_info info;
+    if (!hal.util->perf_get_info(perf_stats_next, info)) {
+        if (perf_stats_next == 0 || !hal.util->perf_get_info(0, info)) {
+            return true;
         }
-        deferred_messages[nextid] = id;
-        num_deferred_messages++;
+        perf_stats_next = 0;
     }
+    char name[10];
+    strncpy(name, info.name, sizeof(name)-1);
+    name[sizeof(name)-1] = 0;
+    mavlink_msg_debug_vect_send(
+        chan,
+        name,
+        AP_HAL::micros64(),
+        info.count,
+        info.avg_us,
+        info.max_us);
+    perf_stats_next++;
+    return true;
 }
 
 void
@@ -830,45 +1179,43 @@ GCS_MAVLINK::update(run_cli_fn run_cli)
 {
     // receive new packets
     mavlink_message_t msg;
-    mavlink_status_t status;
-    status.packet_rx_drop_count = 0;
-
-    // process received bytes
-    uint16_t nbytes = comm_get_available(chan);
-    for (uint16_t i=0; i<nbytes; i++)
-    {
-        uint8_t c = comm_receive_ch(chan);
+    uint8_t buf[GCS_MAVLINK_RX_CHUNK];
 
-        if (run_cli) {
+    // process the bytes available now, a buffer at a time
+    uint16_t remaining = comm_get_available(chan);
+    while (remaining > 0) {
+        uint16_t nbytes = comm_receive_buffer(chan, buf, MIN(remaining, sizeof(buf)));
+        if (nbytes == 0) {
+            break;
+        }
+        remaining -= MIN(remaining, nbytes);
+        if (run_cli && mavlink_active == 0 &&
+            (AP_HAL::millis() - _cli_timeout) < 20000) {
             /* allow CLI to be started by hitting enter 3 times, if no
              *  heartbeat packets have been received */
-            if ((mavlink_active==0) && (AP_HAL::millis() - _cli_timeout) < 20000 && 
-                comm_is_idle(chan)) {
-                if (c == '\n' || c == '\r') {
-                    crlf_count++;
-                } else {
-                    crlf_count = 0;
+            for (uint16_t i=0; i<nbytes; i++) {
+                uint8_t c = buf[i];
+                if (comm_is_idle(chan)) {
+                    if (c == '\n' || c == '\r') {
+                        crlf_count++;
+                    } else {
+                        crlf_count = 0;
+                    }
+                    if (crlf_count == 3) {
+                        run_cli(_port);
+                    }
                 }
-                if (crlf_count == 3) {
-                    run_cli(_port);
+                mavlink_status_t status;
+                if (mavlink_parse_char(chan, c, &msg, &status)) {
+                    packetReceived(msg);
                 }
             }
+            continue;
         }
 
-        // Try to get a new message
-        if (mavlink_parse_char(chan, c, &msg, &status)) {
-            // we exclude radio packets to make it possible to use the
-            // CLI over the radio
-            if (msg.msgid != MAVLINK_MSG_ID_RADIO && msg.msgid != MAVLINK_MSG_ID_RADIO_STATUS) {
-                mavlink_active |= (1U<<(chan-MAVLINK_COMM_0));
-            }
-            // if a snoop handler has been setup then use it
-            if (msg_snoop != NULL) {
-                msg_snoop(&msg);
-            }
-            if (routing.check_and_forward(chan, &msg)) {
-                handleMessage(&msg);
-            }
+        uint16_t ofs = 0;
+        while (comm_parse_buffer(chan, buf, nbytes, ofs, &msg)) {
+            packetReceived(msg);
         }
     }
 
@@ -893,6 +1240,25 @@ GCS_MAVLINK::update(run_cli_fn run_cli)
 }
 
 
+/*
+  handle a message received on this channel
+ */
+void GCS_MAVLINK::packetReceived(mavlink_message_t &msg)
+{
+    // we exclude radio packets to make it possible to use the
+    // CLI over the radio
+    if (msg.msgid != MAVLINK_MSG_ID_RADIO && msg.msgid != MAVLINK_MSG_ID_RADIO_STATUS) {
+        mavlink_active |= (1U<<(chan-MAVLINK_COMM_0));
+    }
+    // if a snoop handler has been setup then use it
+    if (msg_snoop != NULL) {
+        msg_snoop(&msg);
+    }
+    if (routing.check_and_forward(chan, &msg)) {
+        handleMessage(&msg);
+    }
+}
+
 /*
   send raw GPS position information (GPS_RAW_INT, GPS2_RAW, GPS_RTK and GPS2_RTK).
   returns true if messages fit into transmit buffer, false otherwise.
@@ -1362,6 +1728,33 @@ void GCS_MAVLINK::send_vibration(const AP_InertialSensor &ins) const
         ins.get_accel_clip_count(2));
 }
 
+/*
+  send runtime statistics for one scheduler task as a DEBUG_VECT
+  named after the task, with x=mean, y=max time in microseconds and
+  z=number of overruns. Each call reports the next task in the table
+ */
+void GCS_MAVLINK::send_scheduler_stats(const AP_Scheduler &scheduler)
+{
+    if (sched_stats_next_task >= scheduler.num_tasks()) {
+        sched_stats_next_task = 0;
+    }
+    const AP_Scheduler::TaskStats *stats = scheduler.task_stats(sched_stats_next_task);
+    if (stats == NULL) {
+        return;
+    }
+    char name[10];
+    strncpy(name, scheduler.task_name(sched_stats_next_task), sizeof(name)-1);
+    name[sizeof(name)-1] = 0;
+    mavlink_msg_debug_vect_send(
+        chan,
+        name,
+        AP_HAL::micros64(),
+        stats->mean_us(),
+        stats->max_us,
+        stats->overruns);
+    sched_stats_next_task++;
+}
+
 void GCS_MAVLINK::send_home(const Location &home) const
 {
     if (comm_get_txspace(chan) >= MAVLINK_NUM_NON_PAYLOAD_BYTES + MAVLINK_MSG_ID_HOME_POSITION_LEN) {
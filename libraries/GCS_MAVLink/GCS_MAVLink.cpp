@@ -94,6 +94,22 @@ uint8_t comm_receive_ch(mavlink_channel_t chan)
     return (uint8_t)mavlink_comm_port[chan]->read();
 }
 
+/// Read up to len bytes from the nominated MAVLink channel
+///
+/// @param chan		Channel to receive on
+/// @returns		Number of bytes read
+uint16_t comm_receive_buffer(mavlink_channel_t chan, uint8_t *buf, uint16_t len)
+{
+    // sanity check chan
+    if (chan >= MAVLINK_COMM_NUM_BUFFERS) {
+        return 0;
+    }
+    if ((1U<<chan) & mavlink_locked_mask) {
+        return 0;
+    }
+    return mavlink_comm_port[chan]->read_buffer(buf, len);
+}
+
 /// Check for available transmit space on the nominated MAVLink channel
 ///
 /// @param chan		Channel to check
@@ -134,6 +150,41 @@ uint16_t comm_get_available(mavlink_channel_t chan)
     return (uint16_t)bytes;
 }
 
+/*
+  space reserved in the UART write buffer for the packet being sent on
+  each channel, and how much of it has been filled
+ */
+static uint8_t *mavlink_send_ptr[MAVLINK_COMM_NUM_BUFFERS];
+static uint16_t mavlink_send_ofs[MAVLINK_COMM_NUM_BUFFERS];
+
+// count of bytes sent on each channel
+static uint32_t mavlink_tx_bytes[MAVLINK_COMM_NUM_BUFFERS];
+
+/*
+  start sending a packet of len bytes. If the UART can reserve the
+  space then the pieces of the packet are assembled directly in its
+  write buffer, and handed over in one go by comm_send_end()
+ */
+void comm_send_start(mavlink_channel_t chan, uint16_t len)
+{
+    // sanity check chan
+    if (chan >= MAVLINK_COMM_NUM_BUFFERS) {
+        return;
+    }
+    mavlink_send_ptr[chan] = mavlink_comm_port[chan]->write_reserve(len);
+    mavlink_send_ofs[chan] = 0;
+}
+
+void comm_send_end(mavlink_channel_t chan, uint16_t len)
+{
+    // sanity check chan
+    if (chan >= MAVLINK_COMM_NUM_BUFFERS || mavlink_send_ptr[chan] == NULL) {
+        return;
+    }
+    mavlink_comm_port[chan]->write_commit(mavlink_send_ofs[chan]);
+    mavlink_send_ptr[chan] = NULL;
+}
+
 /*
   send a buffer out a MAVLink channel
  */
@@ -143,9 +194,28 @@ void comm_send_buffer(mavlink_channel_t chan, const uint8_t *buf, uint8_t len)
     if (chan >= MAVLINK_COMM_NUM_BUFFERS) {
         return;
     }
+    mavlink_tx_bytes[chan] += len;
+    if (mavlink_send_ptr[chan] != NULL) {
+        memcpy(&mavlink_send_ptr[chan][mavlink_send_ofs[chan]], buf, len);
+        mavlink_send_ofs[chan] += len;
+        return;
+    }
     mavlink_comm_port[chan]->write(buf, len);
 }
 
+/*
+  return the number of bytes sent on a channel. This wraps, so use the
+  difference between two calls
+ */
+uint32_t comm_get_tx_bytes(mavlink_channel_t chan)
+{
+    // sanity check chan
+    if (chan >= MAVLINK_COMM_NUM_BUFFERS) {
+        return 0;
+    }
+    return mavlink_tx_bytes[chan];
+}
+
 static const uint8_t mavlink_message_crc_progmem[256] = MAVLINK_MESSAGE_CRCS;
 
 // return CRC byte for a mavlink message ID
@@ -156,6 +226,128 @@ uint8_t mavlink_get_message_crc(uint8_t msgid)
 
 extern const AP_HAL::HAL& hal;
 
+#if HAL_CPU_CLASS > HAL_CPU_CLASS_16
+/*
+  table for the X.25 CRC used by MAVLink, giving the same result as
+  crc_accumulate() a byte at a time with a single lookup
+ */
+static const uint16_t crc_x25_table[256] = {
+    0x0000, 0x1189, 0x2312, 0x329B, 0x4624, 0x57AD, 0x6536, 0x74BF,
+    0x8C48, 0x9DC1, 0xAF5A, 0xBED3, 0xCA6C, 0xDBE5, 0xE97E, 0xF8F7,
+    0x1081, 0x0108, 0x3393, 0x221A, 0x56A5, 0x472C, 0x75B7, 0x643E,
+    0x9CC9, 0x8D40, 0xBFDB, 0xAE52, 0xDAED, 0xCB64, 0xF9FF, 0xE876,
+    0x2102, 0x308B, 0x0210, 0x1399, 0x6726, 0x76AF, 0x4434, 0x55BD,
+    0xAD4A, 0xBCC3, 0x8E58, 0x9FD1, 0xEB6E, 0xFAE7, 0xC87C, 0xD9F5,
+    0x3183, 0x200A, 0x1291, 0x0318, 0x77A7, 0x662E, 0x54B5, 0x453C,
+    0xBDCB, 0xAC42, 0x9ED9, 0x8F50, 0xFBEF, 0xEA66, 0xD8FD, 0xC974,
+    0x4204, 0x538D, 0x6116, 0x709F, 0x0420, 0x15A9, 0x2732, 0x36BB,
+    0xCE4C, 0xDFC5, 0xED5E, 0xFCD7, 0x8868, 0x99E1, 0xAB7A, 0xBAF3,
+    0x5285, 0x430C, 0x7197, 0x601E, 0x14A1, 0x0528, 0x37B3, 0x263A,
+    0xDECD, 0xCF44, 0xFDDF, 0xEC56, 0x98E9, 0x8960, 0xBBFB, 0xAA72,
+    0x6306, 0x728F, 0x4014, 0x519D, 0x2522, 0x34AB, 0x0630, 0x17B9,
+    0xEF4E, 0xFEC7, 0xCC5C, 0xDDD5, 0xA96A, 0xB8E3, 0x8A78, 0x9BF1,
+    0x7387, 0x620E, 0x5095, 0x411C, 0x35A3, 0x242A, 0x16B1, 0x0738,
+    0xFFCF, 0xEE46, 0xDCDD, 0xCD54, 0xB9EB, 0xA862, 0x9AF9, 0x8B70,
+    0x8408, 0x9581, 0xA71A, 0xB693, 0xC22C, 0xD3A5, 0xE13E, 0xF0B7,
+    0x0840, 0x19C9, 0x2B52, 0x3ADB, 0x4E64, 0x5FED, 0x6D76, 0x7CFF,
+    0x9489, 0x8500, 0xB79B, 0xA612, 0xD2AD, 0xC324, 0xF1BF, 0xE036,
+    0x18C1, 0x0948, 0x3BD3, 0x2A5A, 0x5EE5, 0x4F6C, 0x7DF7, 0x6C7E,
+    0xA50A, 0xB483, 0x8618, 0x9791, 0xE32E, 0xF2A7, 0xC03C, 0xD1B5,
+    0x2942, 0x38CB, 0x0A50, 0x1BD9, 0x6F66, 0x7EEF, 0x4C74, 0x5DFD,
+    0xB58B, 0xA402, 0x9699, 0x8710, 0xF3AF, 0xE226, 0xD0BD, 0xC134,
+    0x39C3, 0x284A, 0x1AD1, 0x0B58, 0x7FE7, 0x6E6E, 0x5CF5, 0x4D7C,
+    0xC60C, 0xD785, 0xE51E, 0xF497, 0x8028, 0x91A1, 0xA33A, 0xB2B3,
+    0x4A44, 0x5BCD, 0x6956, 0x78DF, 0x0C60, 0x1DE9, 0x2F72, 0x3EFB,
+    0xD68D, 0xC704, 0xF59F, 0xE416, 0x90A9, 0x8120, 0xB3BB, 0xA232,
+    0x5AC5, 0x4B4C, 0x79D7, 0x685E, 0x1CE1, 0x0D68, 0x3FF3, 0x2E7A,
+    0xE70E, 0xF687, 0xC41C, 0xD595, 0xA12A, 0xB0A3, 0x8238, 0x93B1,
+    0x6B46, 0x7ACF, 0x4854, 0x59DD, 0x2D62, 0x3CEB, 0x0E70, 0x1FF9,
+    0xF78F, 0xE606, 0xD49D, 0xC514, 0xB1AB, 0xA022, 0x92B9, 0x8330,
+    0x7BC7, 0x6A4E, 0x58D5, 0x495C, 0x3DE3, 0x2C6A, 0x1EF1, 0x0F78,
+};
+
+static uint16_t comm_crc_calculate(const uint8_t *buf, uint16_t len)
+{
+    uint16_t crc = X25_INIT_CRC;
+    while (len--) {
+        crc = (crc >> 8) ^ crc_x25_table[(crc ^ *buf++) & 0xFF];
+    }
+    return crc;
+}
+#else
+#define comm_crc_calculate(buf, len) crc_calculate(buf, len)
+#endif
+
+/*
+  parse received bytes from buf[ofs] on, stopping after the first
+  message, which is returned in msg with ofs moved past it. Returns
+  false once the whole buffer has been consumed.
+
+  Frames which are complete in the buffer are found with memchr(),
+  checked with a single table driven CRC pass and copied into msg in
+  one go. The bytes of a frame split across buffers go through
+  mavlink_parse_char(), and frames with a bad CRC are skipped as it
+  would skip them, so the messages found are the same as feeding each
+  byte to mavlink_parse_char()
+ */
+bool comm_parse_buffer(mavlink_channel_t chan, const uint8_t *buf, uint16_t len,
+                       uint16_t &ofs, mavlink_message_t *msg)
+{
+    mavlink_status_t *status = mavlink_get_channel_status(chan);
+    mavlink_status_t r_status;
+
+    while (ofs < len) {
+        if (status->parse_state > MAVLINK_PARSE_STATE_IDLE) {
+            // finish a frame started in an earlier buffer
+            if (mavlink_parse_char(chan, buf[ofs++], msg, &r_status)) {
+                return true;
+            }
+            continue;
+        }
+
+        const uint8_t *stx = (const uint8_t *)memchr(&buf[ofs], MAVLINK_STX, len - ofs);
+        if (stx == NULL) {
+            ofs = len;
+            break;
+        }
+        ofs = stx - buf;
+
+        if (len - ofs < 2 || len - ofs < MAVLINK_NUM_NON_PAYLOAD_BYTES + stx[1]) {
+            // the rest of this frame is in a later buffer
+            mavlink_parse_char(chan, buf[ofs++], msg, &r_status);
+            continue;
+        }
+
+        const uint8_t payload_len = stx[1];
+        const uint16_t frame_len = MAVLINK_NUM_NON_PAYLOAD_BYTES + payload_len;
+        uint16_t crc = comm_crc_calculate(&stx[1], MAVLINK_CORE_HEADER_LEN + payload_len);
+        crc_accumulate(MAVLINK_MESSAGE_CRC(stx[5]), &crc);
+        if (stx[frame_len-2] != (crc & 0xFF) || stx[frame_len-1] != (crc >> 8)) {
+            // drop the frame, but its last byte may start another
+            status->parse_error++;
+            ofs += frame_len - 1;
+            if (buf[ofs] != MAVLINK_STX) {
+                ofs++;
+            }
+            continue;
+        }
+
+        // the header, payload and checksum are laid out in
+        // mavlink_message_t as they are on the wire
+        memcpy(&msg->magic, stx, frame_len);
+        msg->checksum = crc;
+        ofs += frame_len;
+
+        status->current_rx_seq = msg->seq;
+        if (status->packet_rx_success_count == 0) {
+            status->packet_rx_drop_count = 0;
+        }
+        status->packet_rx_success_count++;
+        return true;
+    }
+    return false;
+}
+
 /*
   return true if the MAVLink parser is idle, so there is no partly parsed
   MAVLink message being processed
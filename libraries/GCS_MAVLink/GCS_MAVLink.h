@@ -16,6 +16,11 @@
 
 #define MAVLINK_SEND_UART_BYTES(chan, buf, len) comm_send_buffer(chan, buf, len)
 
+// assemble each packet in place in the UART write buffer when the
+// driver supports it
+#define MAVLINK_START_UART_SEND(chan, len) comm_send_start(chan, len)
+#define MAVLINK_END_UART_SEND(chan, len) comm_send_end(chan, len)
+
 // define our own MAVLINK_MESSAGE_CRC() macro to allow it to be put
 // into progmem
 #define MAVLINK_MESSAGE_CRC(msgid) mavlink_get_message_crc(msgid)
@@ -58,6 +63,21 @@ static inline void comm_send_ch(mavlink_channel_t chan, uint8_t ch)
 
 void comm_send_buffer(mavlink_channel_t chan, const uint8_t *buf, uint8_t len);
 
+/// Count of bytes sent on the nominated MAVLink channel, which wraps
+///
+/// @param chan		Channel to check
+/// @returns		Number of bytes sent
+uint32_t comm_get_tx_bytes(mavlink_channel_t chan);
+
+/// Reserve space for a whole packet on the nominated MAVLink channel,
+/// which comm_send_buffer() then fills until comm_send_end()
+///
+/// @param chan		Channel to send to
+/// @param len		Length of the packet
+///
+void comm_send_start(mavlink_channel_t chan, uint16_t len);
+void comm_send_end(mavlink_channel_t chan, uint16_t len);
+
 /// Read a byte from the nominated MAVLink channel
 ///
 /// @param chan		Channel to receive on
@@ -65,6 +85,15 @@ void comm_send_buffer(mavlink_channel_t chan, const uint8_t *buf, uint8_t len);
 ///
 uint8_t comm_receive_ch(mavlink_channel_t chan);
 
+/// Read up to len bytes from the nominated MAVLink channel
+///
+/// @param chan		Channel to receive on
+/// @param buf		Buffer to read into
+/// @param len		Size of the buffer
+/// @returns		Number of bytes read
+///
+uint16_t comm_receive_buffer(mavlink_channel_t chan, uint8_t *buf, uint16_t len);
+
 /// Check for available data on the nominated MAVLink channel
 ///
 /// @param chan		Channel to check
@@ -87,6 +116,10 @@ bool comm_is_idle(mavlink_channel_t chan);
 #define MAVLINK_USE_CONVENIENCE_FUNCTIONS
 #include "include/mavlink/v1.0/ardupilotmega/mavlink.h"
 
+// parse a buffer of received bytes, returning the next message in it
+bool comm_parse_buffer(mavlink_channel_t chan, const uint8_t *buf, uint16_t len,
+                       uint16_t &ofs, mavlink_message_t *msg);
+
 // return a MAVLink variable type given a AP_Param type
 uint8_t mav_var_type(enum ap_var_type t);
 
@@ -28,8 +28,30 @@ extern const AP_HAL::HAL& hal;
 
 #define ROUTING_DEBUG 0
 
+#define ROUTE_NONE 0xFF
+
+// channel masks are uint8_t
+static_assert(MAVLINK_COMM_NUM_BUFFERS <= 8, "too many MAVLink channels for routing");
+static_assert(MAVLINK_MAX_ROUTES < ROUTE_NONE, "too many MAVLink routes");
+
 // constructor
-MAVLink_routing::MAVLink_routing(void) : num_routes(0) {}
+MAVLink_routing::MAVLink_routing(void) :
+    num_routes(0),
+    all_channels_mask(0),
+    stats_next(0)
+{
+    memset(route_hash, ROUTE_NONE, sizeof(route_hash));
+    memset(systems, 0, sizeof(systems));
+}
+
+/*
+  hash a sysid/compid or a sysid into a table index, by
+  multiplication so that neighbouring ids spread out
+ */
+static inline uint8_t route_hash_index(uint16_t key)
+{
+    return ((uint16_t)(key * 40503U)) >> (16 - MAVLINK_ROUTE_HASH_BITS);
+}
 
 /*
   forward a MAVLink message to the right port. This also
@@ -100,11 +122,15 @@ bool MAVLink_routing::check_and_forward(mavlink_channel_t in_channel, const mavl
     }
 
     // learn new routes
-    learn_route(in_channel, msg);
+    struct route *from = learn_route(in_channel, msg);
+    if (from != NULL) {
+        from->packets++;
+        from->bytes += (uint16_t)msg->len + MAVLINK_NUM_NON_PAYLOAD_BYTES;
+    }
 
     if (msg->msgid == MAVLINK_MSG_ID_HEARTBEAT) {
         // heartbeat needs special handling
-        handle_heartbeat(in_channel, msg);
+        handle_heartbeat(in_channel, msg, from);
         return true;
     }
 
@@ -125,40 +151,59 @@ bool MAVLink_routing::check_and_forward(mavlink_channel_t in_channel, const mavl
         return true;
     }
 
-    // forward on any channels matching the targets
-    bool forwarded = false;
-    bool sent_to_chan[MAVLINK_COMM_NUM_BUFFERS];
-    memset(sent_to_chan, 0, sizeof(sent_to_chan));
-    for (uint8_t i=0; i<num_routes; i++) {
-        if (broadcast_system || (target_system == routes[i].sysid &&
-                                 (broadcast_component || 
-                                  target_component == routes[i].compid ||
-                                  !match_system))) {
-            if (in_channel != routes[i].channel && !sent_to_chan[routes[i].channel]) {
-                if (comm_get_txspace(routes[i].channel) >= 
-                    ((uint16_t)msg->len) + MAVLINK_NUM_NON_PAYLOAD_BYTES) {
+    // find the channels matching the targets. A message for another
+    // system goes to any of its components
+    uint8_t channel_mask;
+    if (broadcast_system) {
+        channel_mask = all_channels_mask;
+    } else if (broadcast_component || !match_system) {
+        channel_mask = system_channel_mask(target_system);
+    } else {
+        struct route *r = find_route(target_system, target_component);
+        channel_mask = r != NULL ? r->channel_mask : 0;
+    }
+
+    // never send a message back where it came from
+    channel_mask &= ~(1U<<(in_channel-MAVLINK_COMM_0));
+
+    if (channel_mask != 0) {
 #if ROUTING_DEBUG
-                    ::printf("fwd msg %u from chan %u on chan %u sysid=%d compid=%d\n",
-                             msg->msgid,
-                             (unsigned)in_channel,
-                             (unsigned)routes[i].channel,
-                             (int)target_system,
-                             (int)target_component);
+        ::printf("fwd msg %u from chan %u on mask 0x%x sysid=%d compid=%d\n",
+                 msg->msgid,
+                 (unsigned)in_channel,
+                 (unsigned)channel_mask,
+                 (int)target_system,
+                 (int)target_component);
 #endif
-                    _mavlink_resend_uart(routes[i].channel, msg);
-                }
-                sent_to_chan[routes[i].channel] = true;
-                forwarded = true;
-            }
-        }
-    }
-    if (!forwarded && match_system) {
+        forward(channel_mask, msg, from);
+    } else if (match_system) {
         process_locally = true;
     }
 
     return process_locally;
 }
 
+/*
+  send a message on each channel in channel_mask, from the one
+  received buffer. A channel without room for the whole message is
+  skipped, and counted as a drop against the sender's route
+ */
+void MAVLink_routing::forward(uint8_t channel_mask, const mavlink_message_t* msg, struct route *from)
+{
+    const uint16_t len = ((uint16_t)msg->len) + MAVLINK_NUM_NON_PAYLOAD_BYTES;
+    for (uint8_t i=0; i<MAVLINK_COMM_NUM_BUFFERS; i++) {
+        if (!(channel_mask & (1U<<i))) {
+            continue;
+        }
+        mavlink_channel_t channel = (mavlink_channel_t)(MAVLINK_COMM_0 + i);
+        if (comm_get_txspace(channel) >= len) {
+            _mavlink_resend_uart(channel, msg);
+        } else if (from != NULL) {
+            from->drops++;
+        }
+    }
+}
+
 /*
   send a MAVLink message to all components with this vehicle's system id
 
@@ -166,24 +211,14 @@ bool MAVLink_routing::check_and_forward(mavlink_channel_t in_channel, const mavl
 */
 void MAVLink_routing::send_to_components(const mavlink_message_t* msg)
 {
-    bool sent_to_chan[MAVLINK_COMM_NUM_BUFFERS];
-    memset(sent_to_chan, 0, sizeof(sent_to_chan));
-
-    // check learned routes
-    for (uint8_t i=0; i<num_routes; i++) {
-        if ((routes[i].sysid == mavlink_system.sysid) && !sent_to_chan[routes[i].channel]) {
-            if (comm_get_txspace(routes[i].channel) >= ((uint16_t)msg->len) + MAVLINK_NUM_NON_PAYLOAD_BYTES) {
+    uint8_t channel_mask = system_channel_mask(mavlink_system.sysid);
+    if (channel_mask != 0) {
 #if ROUTING_DEBUG
-                ::printf("send msg %u on chan %u sysid=%u compid=%u\n",
-                         msg->msgid,
-                         (unsigned)routes[i].channel,
-                         (unsigned)routes[i].sysid,
-                         (unsigned)routes[i].compid);
+        ::printf("send msg %u on mask 0x%x\n",
+                 msg->msgid,
+                 (unsigned)channel_mask);
 #endif
-                _mavlink_resend_uart(routes[i].channel, msg);
-                sent_to_chan[routes[i].channel] = true;
-            }
-        }
+        forward(channel_mask, msg, NULL);
     }
 }
 
@@ -198,7 +233,7 @@ bool MAVLink_routing::find_by_mavtype(uint8_t mavtype, uint8_t &sysid, uint8_t &
         if (routes[i].mavtype == mavtype) {
             sysid = routes[i].sysid;
             compid = routes[i].compid;
-            channel = routes[i].channel;
+            channel = routes[i].first_channel;
             return true;
         }
     }
@@ -207,35 +242,88 @@ bool MAVLink_routing::find_by_mavtype(uint8_t mavtype, uint8_t &sysid, uint8_t &
     return false;
 }
 
+/*
+  find the route for a sysid/compid, or NULL if it hasn't been learned
+ */
+struct MAVLink_routing::route *MAVLink_routing::find_route(uint8_t sysid, uint8_t compid)
+{
+    uint8_t idx = route_hash_index((sysid<<8) | compid);
+    for (uint8_t i=0; i<MAVLINK_ROUTE_HASH_SIZE; i++) {
+        const uint8_t r = route_hash[idx];
+        if (r == ROUTE_NONE) {
+            return NULL;
+        }
+        if (routes[r].sysid == sysid && routes[r].compid == compid) {
+            return &routes[r];
+        }
+        idx = (idx + 1) & (MAVLINK_ROUTE_HASH_SIZE-1);
+    }
+    return NULL;
+}
+
+/*
+  find the entry for a sysid, optionally creating it. The table has
+  room for a system for every route, so creation can't fail
+ */
+struct MAVLink_routing::system *MAVLink_routing::find_system(uint8_t sysid, bool create)
+{
+    uint8_t idx = route_hash_index(sysid);
+    for (uint8_t i=0; i<MAVLINK_ROUTE_HASH_SIZE; i++) {
+        struct system &sys = systems[idx];
+        if (sys.channel_mask == 0) {
+            if (!create) {
+                return NULL;
+            }
+            sys.sysid = sysid;
+            return &sys;
+        }
+        if (sys.sysid == sysid) {
+            return &sys;
+        }
+        idx = (idx + 1) & (MAVLINK_ROUTE_HASH_SIZE-1);
+    }
+    return NULL;
+}
+
+// return the channels on which a sysid has been seen
+uint8_t MAVLink_routing::system_channel_mask(uint8_t sysid)
+{
+    struct system *sys = find_system(sysid, false);
+    return sys != NULL ? sys->channel_mask : 0;
+}
+
 /*
   see if the message is for a new route and learn it
 */
-void MAVLink_routing::learn_route(mavlink_channel_t in_channel, const mavlink_message_t* msg)
+struct MAVLink_routing::route *MAVLink_routing::learn_route(mavlink_channel_t in_channel, const mavlink_message_t* msg)
 {
-    uint8_t i;
     if (msg->sysid == 0 || 
         (msg->sysid == mavlink_system.sysid && 
          msg->compid == mavlink_system.compid)) {
-        return;
+        return NULL;
     }
-    for (i=0; i<num_routes; i++) {
-        if (routes[i].sysid == msg->sysid && 
-            routes[i].compid == msg->compid &&
-            routes[i].channel == in_channel) {
-            if (routes[i].mavtype == 0 && msg->msgid == MAVLINK_MSG_ID_HEARTBEAT) {
-                routes[i].mavtype = mavlink_msg_heartbeat_get_type(msg);
-            }
-            break;
+    const uint8_t channel_bit = 1U<<(in_channel-MAVLINK_COMM_0);
+    struct route *r = find_route(msg->sysid, msg->compid);
+    if (r == NULL) {
+        if (num_routes == MAVLINK_MAX_ROUTES) {
+            return NULL;
         }
-    }
-    if (i == num_routes && i<MAVLINK_MAX_ROUTES) {
-        routes[i].sysid = msg->sysid;
-        routes[i].compid = msg->compid;
-        routes[i].channel = in_channel;
-        if (msg->msgid == MAVLINK_MSG_ID_HEARTBEAT) {
-            routes[i].mavtype = mavlink_msg_heartbeat_get_type(msg);
+        r = &routes[num_routes];
+        memset(r, 0, sizeof(*r));
+        r->sysid = msg->sysid;
+        r->compid = msg->compid;
+        r->first_channel = in_channel;
+        uint8_t idx = route_hash_index((msg->sysid<<8) | msg->compid);
+        while (route_hash[idx] != ROUTE_NONE) {
+            idx = (idx + 1) & (MAVLINK_ROUTE_HASH_SIZE-1);
         }
+        route_hash[idx] = num_routes;
         num_routes++;
+    }
+    if (!(r->channel_mask & channel_bit)) {
+        r->channel_mask |= channel_bit;
+        find_system(msg->sysid, true)->channel_mask |= channel_bit;
+        all_channels_mask |= channel_bit;
 #if ROUTING_DEBUG
         ::printf("learned route %u %u via %u\n",
                  (unsigned)msg->sysid, 
@@ -243,6 +331,10 @@ void MAVLink_routing::learn_route(mavlink_channel_t in_channel, const mavlink_me
                  (unsigned)in_channel);
 #endif
     }
+    if (r->mavtype == 0 && msg->msgid == MAVLINK_MSG_ID_HEARTBEAT) {
+        r->mavtype = mavlink_msg_heartbeat_get_type(msg);
+    }
+    return r;
 }
 
 
@@ -251,7 +343,7 @@ void MAVLink_routing::learn_route(mavlink_channel_t in_channel, const mavlink_me
   propogation heartbeat messages need to be forwarded on all channels
   except channels where the sysid/compid of the heartbeat could come from
 */
-void MAVLink_routing::handle_heartbeat(mavlink_channel_t in_channel, const mavlink_message_t* msg)
+void MAVLink_routing::handle_heartbeat(mavlink_channel_t in_channel, const mavlink_message_t* msg, struct route *from)
 {
     uint16_t mask = GCS_MAVLINK::active_channel_mask();
 
@@ -260,10 +352,8 @@ void MAVLink_routing::handle_heartbeat(mavlink_channel_t in_channel, const mavli
     mask &= ~(1U<<(in_channel-MAVLINK_COMM_0));
 
     // mask out channels that are known sources for this sysid/compid
-    for (uint8_t i=0; i<num_routes; i++) {
-        if (routes[i].sysid == msg->sysid && routes[i].compid == msg->compid) {
-            mask &= ~(1U<<((unsigned)(routes[i].channel-MAVLINK_COMM_0)));
-        }
+    if (from != NULL) {
+        mask &= ~from->channel_mask;
     }
 
     if (mask == 0) {
@@ -271,22 +361,43 @@ void MAVLink_routing::handle_heartbeat(mavlink_channel_t in_channel, const mavli
         return;
     }
 
-    // send on the remaining channels
-    for (uint8_t i=0; i<MAVLINK_COMM_NUM_BUFFERS; i++) {
-        if (mask & (1U<<i)) {
-            mavlink_channel_t channel = (mavlink_channel_t)(MAVLINK_COMM_0 + i);
-            if (comm_get_txspace(channel) >= ((uint16_t)msg->len) + MAVLINK_NUM_NON_PAYLOAD_BYTES) {
 #if ROUTING_DEBUG
-                ::printf("fwd HB from chan %u on chan %u from sysid=%u compid=%u\n",
-                         (unsigned)in_channel,
-                         (unsigned)channel,
-                         (unsigned)msg->sysid,
-                         (unsigned)msg->compid);
+    ::printf("fwd HB from chan %u on mask 0x%x from sysid=%u compid=%u\n",
+             (unsigned)in_channel,
+             (unsigned)mask,
+             (unsigned)msg->sysid,
+             (unsigned)msg->compid);
 #endif
-                _mavlink_resend_uart(channel, msg);
-            }
-        }
+    forward(mask, msg, from);
+}
+
+/*
+  send the counters of one route as a DEBUG_VECT named for the route,
+  with the packets, bytes and drops from that sysid/compid
+ */
+bool MAVLink_routing::send_route_stats(mavlink_channel_t chan)
+{
+    if (num_routes == 0) {
+        return true;
+    }
+    if (!HAVE_PAYLOAD_SPACE(chan, DEBUG_VECT)) {
+        return false;
+    }
+    if (stats_next >= num_routes) {
+        stats_next = 0;
     }
+    const struct route &r = routes[stats_next];
+    char name[10];
+    snprintf(name, sizeof(name), "R%u/%u", (unsigned)r.sysid, (unsigned)r.compid);
+    mavlink_msg_debug_vect_send(
+        chan,
+        name,
+        AP_HAL::micros64(),
+        r.packets,
+        r.bytes,
+        r.drops);
+    stats_next++;
+    return true;
 }
 
 
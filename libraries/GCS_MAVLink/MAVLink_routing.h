@@ -14,6 +14,11 @@
 // we make more extensive use of MAVLink forwarding
 #define MAVLINK_MAX_ROUTES 20
 
+// size of the route lookup hash tables, a power of two comfortably
+// larger than MAVLINK_MAX_ROUTES
+#define MAVLINK_ROUTE_HASH_BITS 5
+#define MAVLINK_ROUTE_HASH_SIZE (1U<<MAVLINK_ROUTE_HASH_BITS)
+
 /*
   object to handle MAVLink packet routing
  */
@@ -43,26 +48,63 @@ public:
      */
     bool find_by_mavtype(uint8_t mavtype, uint8_t &sysid, uint8_t &compid, mavlink_channel_t &channel);
 
+    /*
+      send the counters of one route as a DEBUG_VECT, cycling through
+      the routes on each call. Returns false if there is no space to
+      send
+     */
+    bool send_route_stats(mavlink_channel_t chan);
+
 private:
-    // a simple linear routing table. We don't expect to have a lot of
-    // routes, so a scalable structure isn't worthwhile yet.
+    /*
+      a route is a sysid/compid seen on one or more channels. Routes
+      are kept in the order they were learned, and found with hash
+      tables of route indexes keyed on sysid/compid and on sysid
+     */
     uint8_t num_routes;
     struct route {
         uint8_t sysid;
         uint8_t compid;
-        mavlink_channel_t channel;
+        uint8_t channel_mask;
+        // the channel this sysid/compid was first seen on
+        mavlink_channel_t first_channel;
         uint8_t mavtype;
+        // traffic received from this sysid/compid, and copies of it we
+        // had to drop for lack of transmit space
+        uint32_t packets;
+        uint32_t bytes;
+        uint32_t drops;
     } routes[MAVLINK_MAX_ROUTES];
+    uint8_t route_hash[MAVLINK_ROUTE_HASH_SIZE];
 
-    // learn new routes
-    void learn_route(mavlink_channel_t in_channel, const mavlink_message_t* msg);
+    // channels on which each sysid has been seen
+    struct system {
+        uint8_t sysid;
+        uint8_t channel_mask;
+    } systems[MAVLINK_ROUTE_HASH_SIZE];
+
+    // channels on which anything has been seen
+    uint8_t all_channels_mask;
+
+    // next route for send_route_stats()
+    uint8_t stats_next;
+
+    // hash table lookups
+    struct route *find_route(uint8_t sysid, uint8_t compid);
+    struct system *find_system(uint8_t sysid, bool create);
+    uint8_t system_channel_mask(uint8_t sysid);
+
+    // learn new routes, returning the route for the sender
+    struct route *learn_route(mavlink_channel_t in_channel, const mavlink_message_t* msg);
+
+    // send a message on each channel in a mask that has room for it
+    void forward(uint8_t channel_mask, const mavlink_message_t* msg, struct route *from);
 
     // extract target sysid and compid from a message
     void get_targets(const mavlink_message_t* msg, int16_t &sysid, int16_t &compid);
 
     // special handling for heartbeat messages
-    void handle_heartbeat(mavlink_channel_t in_channel, const mavlink_message_t* msg);
+    void handle_heartbeat(mavlink_channel_t in_channel, const mavlink_message_t* msg, struct route *from);
 };
 
 #endif // __MAVLINK_ROUTING_H
-
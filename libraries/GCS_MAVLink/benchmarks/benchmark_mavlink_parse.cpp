@@ -0,0 +1,96 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_HAL/AP_HAL.h>
+#include <GCS_MAVLink/GCS.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#define STREAM_SIZE 16384
+
+static uint8_t stream[STREAM_SIZE];
+static uint16_t stream_len;
+
+static void add_message(const mavlink_message_t &msg)
+{
+    stream_len += mavlink_msg_to_send_buffer(&stream[stream_len], &msg);
+}
+
+/*
+  a link carrying a mix of telemetry and GCS traffic, as seen at a
+  vehicle with a companion computer, with a little line noise
+ */
+static void build_stream(void)
+{
+    if (stream_len != 0) {
+        return;
+    }
+    mavlink_message_t msg;
+    uint32_t i = 0;
+    while (stream_len < STREAM_SIZE - 3*MAVLINK_MAX_PACKET_LEN) {
+        mavlink_msg_attitude_pack(1, 1, &msg, i, 0.1f, 0.2f, 0.3f, 0, 0, 0);
+        add_message(msg);
+        mavlink_msg_raw_imu_pack(1, 1, &msg, i, 1, 2, 3, 4, 5, 6, 7, 8, 9);
+        add_message(msg);
+        switch (i % 4) {
+        case 0:
+            mavlink_msg_heartbeat_pack(255, 190, &msg, MAV_TYPE_GCS, MAV_AUTOPILOT_INVALID, 0, 0, 0);
+            break;
+        case 1:
+            mavlink_msg_rc_channels_override_pack(255, 190, &msg, 1, 1, 1500, 1500, 1000, 1500, 0, 0, 0, 0);
+            break;
+        case 2:
+            mavlink_msg_gps_raw_int_pack(1, 1, &msg, i, 3, -353632610, 1491652300, 584000, 100, 100, 0, 0, 10);
+            break;
+        case 3:
+            mavlink_msg_mission_item_pack(255, 190, &msg, 1, 1, i, MAV_FRAME_GLOBAL_RELATIVE_ALT,
+                                          MAV_CMD_NAV_WAYPOINT, 0, 1, 0, 0, 0, 0, -35.36f, 149.16f, 100);
+            break;
+        }
+        add_message(msg);
+        if (i % 16 == 15) {
+            stream[stream_len++] = 0x55;
+        }
+        i++;
+    }
+}
+
+static void BM_MAVLinkParseChar(benchmark::State& state)
+{
+    build_stream();
+    mavlink_message_t msg;
+    mavlink_status_t status;
+    uint32_t count = 0;
+    while (state.KeepRunning()) {
+        for (uint16_t i=0; i<stream_len; i++) {
+            if (mavlink_parse_char(MAVLINK_COMM_0, stream[i], &msg, &status)) {
+                count++;
+            }
+        }
+    }
+    gbenchmark_escape(&count);
+    state.SetBytesProcessed(int64_t(state.iterations()) * stream_len);
+}
+
+static void BM_MAVLinkParseBuffer(benchmark::State& state)
+{
+    build_stream();
+    mavlink_message_t msg;
+    const uint16_t chunk = state.range_x();
+    uint32_t count = 0;
+    while (state.KeepRunning()) {
+        for (uint16_t i=0; i<stream_len; i += chunk) {
+            uint16_t len = MIN(chunk, stream_len - i);
+            uint16_t ofs = 0;
+            while (comm_parse_buffer(MAVLINK_COMM_1, &stream[i], len, ofs, &msg)) {
+                count++;
+            }
+        }
+    }
+    gbenchmark_escape(&count);
+    state.SetBytesProcessed(int64_t(state.iterations()) * stream_len);
+}
+
+BENCHMARK(BM_MAVLinkParseChar);
+BENCHMARK(BM_MAVLinkParseBuffer)->Arg(32)->Arg(256);
+
+BENCHMARK_MAIN()
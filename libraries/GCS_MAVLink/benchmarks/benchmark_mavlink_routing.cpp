@@ -0,0 +1,115 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_HAL/AP_HAL.h>
+#include <GCS_MAVLink/GCS.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+/*
+  a port which accepts and discards everything
+ */
+class NullUART : public AP_HAL::UARTDriver {
+public:
+    void begin(uint32_t baud) {}
+    void begin(uint32_t baud, uint16_t rxSpace, uint16_t txSpace) {}
+    void end() {}
+    void flush() {}
+    bool is_initialized() { return true; }
+    void set_blocking_writes(bool blocking) {}
+    bool tx_pending() { return false; }
+    int16_t available() { return 0; }
+    int16_t txspace() { return 4096; }
+    int16_t read() { return -1; }
+    size_t write(uint8_t c) { bytes++; return 1; }
+    size_t write(const uint8_t *buffer, size_t size) { bytes += size; return size; }
+    uint32_t bytes;
+};
+
+static NullUART ports[MAVLINK_COMM_NUM_BUFFERS];
+static MAVLink_routing routing;
+
+/*
+  a vehicle with two GCS, a companion computer running several
+  components and a gimbal on separate links, and a swarm of other
+  vehicles seen through the first GCS link: the table is full
+ */
+static void setup_routes(void)
+{
+    static bool done;
+    if (done) {
+        return;
+    }
+    done = true;
+    mavlink_system.sysid = 1;
+    mavlink_system.compid = 1;
+    for (uint8_t i=0; i<MAVLINK_COMM_NUM_BUFFERS; i++) {
+        mavlink_comm_port[i] = &ports[i];
+    }
+    mavlink_message_t msg;
+    mavlink_msg_heartbeat_pack(255, 190, &msg, MAV_TYPE_GCS, MAV_AUTOPILOT_INVALID, 0, 0, 0);
+    routing.check_and_forward(MAVLINK_COMM_0, &msg);
+    mavlink_msg_heartbeat_pack(254, 190, &msg, MAV_TYPE_GCS, MAV_AUTOPILOT_INVALID, 0, 0, 0);
+    routing.check_and_forward(MAVLINK_COMM_1, &msg);
+    for (uint8_t c=0; c<4; c++) {
+        mavlink_msg_heartbeat_pack(1, 100+c, &msg, MAV_TYPE_ONBOARD_CONTROLLER, MAV_AUTOPILOT_INVALID, 0, 0, 0);
+        routing.check_and_forward(MAVLINK_COMM_2, &msg);
+    }
+    mavlink_msg_heartbeat_pack(1, MAV_COMP_ID_GIMBAL, &msg, MAV_TYPE_GIMBAL, MAV_AUTOPILOT_INVALID, 0, 0, 0);
+    routing.check_and_forward(MAVLINK_COMM_3, &msg);
+    for (uint8_t s=0; s<MAVLINK_MAX_ROUTES-7; s++) {
+        mavlink_msg_heartbeat_pack(10+s, 1, &msg, MAV_TYPE_QUADROTOR, MAV_AUTOPILOT_ARDUPILOTMEGA, 0, 0, 0);
+        routing.check_and_forward(MAVLINK_COMM_0, &msg);
+    }
+}
+
+static void run(benchmark::State& state, const mavlink_message_t &msg, mavlink_channel_t chan)
+{
+    bool local = false;
+    while (state.KeepRunning()) {
+        local ^= routing.check_and_forward(chan, &msg);
+    }
+    gbenchmark_escape(&local);
+}
+
+// a command for us from the GCS
+static void BM_RouteLocal(benchmark::State& state)
+{
+    setup_routes();
+    mavlink_message_t msg;
+    mavlink_msg_command_long_pack(255, 190, &msg, 1, 1, MAV_CMD_DO_SET_MODE, 0, 0, 0, 0, 0, 0, 0, 0);
+    run(state, msg, MAVLINK_COMM_0);
+}
+
+// a gimbal command from the GCS, forwarded to one link
+static void BM_RouteComponent(benchmark::State& state)
+{
+    setup_routes();
+    mavlink_message_t msg;
+    mavlink_msg_command_long_pack(255, 190, &msg, 1, MAV_COMP_ID_GIMBAL, MAV_CMD_DO_MOUNT_CONTROL, 0, 0, 0, 0, 0, 0, 0, 0);
+    run(state, msg, MAVLINK_COMM_0);
+}
+
+// a message for the last vehicle learned
+static void BM_RouteOtherSystem(benchmark::State& state)
+{
+    setup_routes();
+    mavlink_message_t msg;
+    mavlink_msg_command_long_pack(254, 190, &msg, 10+MAVLINK_MAX_ROUTES-8, 1, MAV_CMD_DO_SET_MODE, 0, 0, 0, 0, 0, 0, 0, 0);
+    run(state, msg, MAVLINK_COMM_1);
+}
+
+// a broadcast from the companion computer, fanned out to every link
+static void BM_RouteBroadcast(benchmark::State& state)
+{
+    setup_routes();
+    mavlink_message_t msg;
+    mavlink_msg_command_long_pack(1, 100, &msg, 0, 0, MAV_CMD_DO_SET_MODE, 0, 0, 0, 0, 0, 0, 0, 0);
+    run(state, msg, MAVLINK_COMM_2);
+}
+
+BENCHMARK(BM_RouteLocal);
+BENCHMARK(BM_RouteComponent);
+BENCHMARK(BM_RouteOtherSystem);
+BENCHMARK(BM_RouteBroadcast);
+
+BENCHMARK_MAIN()
@@ -25,6 +25,7 @@ void setup(void)
 {
     hal.console->println("routing test startup...");
     gcs[0].init(hal.uartA, MAVLINK_COMM_0);
+    gcs[1].init(hal.uartC, MAVLINK_COMM_1);
 }
 
 void loop(void)
@@ -88,6 +89,33 @@ void loop(void)
         err_count++;
     }
 
+    // a gimbal on another channel
+    heartbeat.type = MAV_TYPE_GIMBAL;
+    mavlink_msg_heartbeat_encode(mavlink_system.sysid, MAV_COMP_ID_GIMBAL, &msg, &heartbeat);
+    if (!routing.check_and_forward(MAVLINK_COMM_1, &msg)) {
+        hal.console->printf("gimbal heartbeat should be processed locally\n");
+        err_count++;
+    }
+    uint8_t sysid, compid;
+    mavlink_channel_t channel;
+    if (!routing.find_by_mavtype(MAV_TYPE_GIMBAL, sysid, compid, channel) ||
+        sysid != mavlink_system.sysid ||
+        compid != MAV_COMP_ID_GIMBAL ||
+        channel != MAVLINK_COMM_1) {
+        hal.console->printf("gimbal should be found on channel 1\n");
+        err_count++;
+    }
+
+    // incoming targetted message for the gimbal should only be
+    // forwarded
+    param_set.target_system = mavlink_system.sysid;
+    param_set.target_component = MAV_COMP_ID_GIMBAL;
+    mavlink_msg_param_set_encode(3, 1, &msg, &param_set);
+    if (routing.check_and_forward(MAVLINK_COMM_0, &msg)) {
+        hal.console->printf("param set 5 should not be processed locally\n");
+        err_count++;
+    }
+
     if (err_count == 0) {
         hal.console->printf("All OK\n");
     }
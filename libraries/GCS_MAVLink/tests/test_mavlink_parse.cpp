@@ -0,0 +1,217 @@
+#include <AP_gtest.h>
+
+#include <string.h>
+
+#include <AP_HAL/AP_HAL.h>
+#include <GCS_MAVLink/GCS.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#define STREAM_SIZE 16384
+#define MAX_MESSAGES 1024
+
+// both parsers get a channel of their own
+#define CHAN_CHAR MAVLINK_COMM_0
+#define CHAN_BUFFER MAVLINK_COMM_1
+
+static uint8_t stream[STREAM_SIZE];
+static uint16_t stream_len;
+
+static uint32_t seed;
+
+static uint32_t next_random(void)
+{
+    seed = seed * 1103515245U + 12345U;
+    return seed >> 16;
+}
+
+static void add_message(const mavlink_message_t &msg)
+{
+    stream_len += mavlink_msg_to_send_buffer(&stream[stream_len], &msg);
+}
+
+/*
+  a stream of the messages a vehicle sees, with frames of several
+  lengths
+ */
+static void build_stream(void)
+{
+    mavlink_message_t msg;
+    stream_len = 0;
+    seed = 1;
+    for (uint32_t i=0; stream_len < STREAM_SIZE - 2*MAVLINK_MAX_PACKET_LEN; i++) {
+        switch (i % 5) {
+        case 0:
+            mavlink_msg_heartbeat_pack(255, 190, &msg, MAV_TYPE_GCS, MAV_AUTOPILOT_INVALID, 0, 0, 0);
+            break;
+        case 1:
+            mavlink_msg_attitude_pack(1, 1, &msg, i, 0.1f, 0.2f, 0.3f, 0, 0, 0);
+            break;
+        case 2:
+            mavlink_msg_param_value_pack(1, 1, &msg, "SYSID_THISMAV", i, MAV_PARAM_TYPE_REAL32, 600, i);
+            break;
+        case 3:
+            mavlink_msg_rc_channels_override_pack(255, 190, &msg, 1, 1, 1500, 1500, 1000, 1500, 0, 0, 0, 0);
+            break;
+        case 4:
+            mavlink_msg_mission_item_pack(255, 190, &msg, 1, 1, i, MAV_FRAME_GLOBAL_RELATIVE_ALT,
+                                          MAV_CMD_NAV_WAYPOINT, 0, 1, 0, 0, 0, 0, -35.36f, 149.16f, 100);
+            break;
+        }
+        add_message(msg);
+    }
+}
+
+struct parsed {
+    mavlink_message_t msg[MAX_MESSAGES];
+    uint16_t count;
+    uint32_t success_count;
+};
+
+static void reset_channel(mavlink_channel_t chan)
+{
+    memset(mavlink_get_channel_status(chan), 0, sizeof(mavlink_status_t));
+}
+
+static void parse_char(struct parsed &p)
+{
+    mavlink_status_t status;
+    reset_channel(CHAN_CHAR);
+    p.count = 0;
+    for (uint16_t i=0; i<stream_len; i++) {
+        if (mavlink_parse_char(CHAN_CHAR, stream[i], &p.msg[p.count], &status) &&
+            p.count < MAX_MESSAGES-1) {
+            p.count++;
+        }
+    }
+    p.success_count = mavlink_get_channel_status(CHAN_CHAR)->packet_rx_success_count;
+}
+
+/*
+  feed the stream to comm_parse_buffer() in chunks of the given size,
+  or of random sizes if chunk is zero
+ */
+static void parse_buffer(struct parsed &p, uint16_t chunk)
+{
+    reset_channel(CHAN_BUFFER);
+    p.count = 0;
+    for (uint16_t i=0; i<stream_len; ) {
+        uint16_t len = chunk ? chunk : 1 + next_random() % 300;
+        len = MIN(len, stream_len - i);
+        uint16_t ofs = 0;
+        while (comm_parse_buffer(CHAN_BUFFER, &stream[i], len, ofs, &p.msg[p.count])) {
+            if (p.count < MAX_MESSAGES-1) {
+                p.count++;
+            }
+        }
+        EXPECT_EQ(len, ofs);
+        i += len;
+    }
+    p.success_count = mavlink_get_channel_status(CHAN_BUFFER)->packet_rx_success_count;
+}
+
+static bool same_message(const mavlink_message_t &a, const mavlink_message_t &b)
+{
+    // the header, payload and the checksum bytes which follow it
+    return a.checksum == b.checksum &&
+        memcmp(&a.magic, &b.magic, MAVLINK_CORE_HEADER_LEN + 1 + a.len + 2) == 0;
+}
+
+static struct parsed by_char, by_buffer;
+
+static void check_same(uint16_t chunk)
+{
+    parse_char(by_char);
+    parse_buffer(by_buffer, chunk);
+    ASSERT_EQ(by_char.count, by_buffer.count) << "chunk " << chunk;
+    EXPECT_EQ(by_char.success_count, by_buffer.success_count) << "chunk " << chunk;
+    for (uint16_t i=0; i<by_char.count; i++) {
+        EXPECT_TRUE(same_message(by_char.msg[i], by_buffer.msg[i])) << "message " << i << " chunk " << chunk;
+    }
+    EXPECT_TRUE(comm_is_idle(CHAN_CHAR) == comm_is_idle(CHAN_BUFFER));
+}
+
+static const uint16_t chunks[] = { 0, 1, 2, 7, 17, 32, 100, 256, 263, STREAM_SIZE };
+
+static void check_all_chunks(void)
+{
+    for (uint8_t i=0; i<ARRAY_SIZE(chunks); i++) {
+        check_same(chunks[i]);
+    }
+}
+
+TEST(MAVLinkParseTest, CleanStream)
+{
+    build_stream();
+    check_all_chunks();
+    EXPECT_GT(by_char.count, 100);
+}
+
+/*
+  frames with a bad CRC are dropped, and a CRC byte which happens to
+  be a start byte begins the next frame
+ */
+TEST(MAVLinkParseTest, BadCRC)
+{
+    build_stream();
+    uint16_t ofs = 0;
+    uint16_t n = 0;
+    while (ofs < stream_len) {
+        const uint16_t frame_len = MAVLINK_NUM_NON_PAYLOAD_BYTES + stream[ofs+1];
+        switch (n++ % 4) {
+        case 0:
+            // corrupt the payload
+            stream[ofs + MAVLINK_NUM_HEADER_BYTES]++;
+            break;
+        case 1:
+            // bad first CRC byte, which is a start byte
+            stream[ofs + frame_len - 2] = MAVLINK_STX;
+            break;
+        case 2:
+            // bad second CRC byte, which is a start byte
+            stream[ofs + frame_len - 1] = MAVLINK_STX;
+            break;
+        }
+        ofs += frame_len;
+    }
+    check_all_chunks();
+}
+
+/*
+  line noise, start bytes in the noise and frames cut short
+ */
+TEST(MAVLinkParseTest, Noise)
+{
+    build_stream();
+    for (uint16_t i=0; i<stream_len; i++) {
+        switch (next_random() % 64) {
+        case 0:
+            stream[i] = MAVLINK_STX;
+            break;
+        case 1:
+            stream[i] = next_random();
+            break;
+        case 2:
+            // drop a byte
+            memmove(&stream[i], &stream[i+1], stream_len - i - 1);
+            stream_len--;
+            break;
+        }
+    }
+    check_all_chunks();
+}
+
+/*
+  random bytes with plenty of start bytes
+ */
+TEST(MAVLinkParseTest, RandomBytes)
+{
+    stream_len = STREAM_SIZE;
+    seed = 42;
+    for (uint16_t i=0; i<stream_len; i++) {
+        stream[i] = (next_random() % 8 == 0) ? MAVLINK_STX : next_random();
+    }
+    check_all_chunks();
+}
+
+AP_GTEST_MAIN()